@@ -0,0 +1,169 @@
+//
+// Created by Dextron12 on 17/10/26.
+//
+
+#include "Bench.hpp"
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <new>
+
+#ifndef DEXIUM_VERSION
+    #define DEXIUM_VERSION "unknown"
+#endif
+#ifndef DEXIUM_BUILD_TYPE
+    #define DEXIUM_BUILD_TYPE "unknown"
+#endif
+
+// ---- Allocation counting ----
+
+namespace {
+    std::atomic<uint64_t> s_allocs{0};
+    std::atomic<uint64_t> s_bytes{0};
+
+    void* countedAlloc(std::size_t size) {
+        s_allocs.fetch_add(1, std::memory_order_relaxed);
+        s_bytes.fetch_add(size, std::memory_order_relaxed);
+        return std::malloc(size ? size : 1);
+    }
+}
+
+void* operator new(std::size_t size) {
+    if (void* p = countedAlloc(size)) return p;
+    throw std::bad_alloc();
+}
+void* operator new[](std::size_t size) {
+    if (void* p = countedAlloc(size)) return p;
+    throw std::bad_alloc();
+}
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept { return countedAlloc(size); }
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept { return countedAlloc(size); }
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { std::free(p); }
+
+namespace Dexium::Bench {
+
+    uint64_t allocationCount() { return s_allocs.load(std::memory_order_relaxed); }
+    uint64_t allocatedBytes() { return s_bytes.load(std::memory_order_relaxed); }
+
+    void Suite::add(std::string name, BenchFn fn) {
+        m_cases.push_back({std::move(name), std::move(fn)});
+    }
+
+    std::vector<Result> Suite::run(const std::string& filter, double minSeconds, int samples) {
+        std::vector<Result> results;
+        samples = std::max(samples, 1);
+
+        fmt::print("{:<44} {:>12} {:>12} {:>12} {:>14} {:>14}\n", "benchmark", "iterations", "ns/op", "allocs/op", "ops/s", "items/s");
+
+        for (const auto& c : m_cases) {
+            if (!filter.empty() && c.name.find(filter) == std::string::npos) continue;
+
+            // Grow the iteration count until one run takes a decent slice of the min time, then scale up to it
+            uint64_t iterations = 1;
+            double ns = 0.0;
+            for (;;) {
+                State probe(iterations);
+                c.fn(probe);
+                ns = probe.m_ns;
+                if (ns >= minSeconds * 1e9 * 0.1 || iterations >= (1ull << 40)) break;
+                iterations *= 10;
+            }
+            if (ns > 0.0) {
+                const double scale = (minSeconds * 1e9) / ns;
+                iterations = std::max<uint64_t>(1, static_cast<uint64_t>(static_cast<double>(iterations) * std::min(scale, 1000.0)));
+            }
+
+            // Median sample wins, the allocation counts come from the same sample
+            std::vector<State> runs;
+            runs.reserve(static_cast<size_t>(samples));
+            for (int s = 0; s < samples; ++s) {
+                runs.emplace_back(iterations);
+                c.fn(runs.back());
+            }
+            std::sort(runs.begin(), runs.end(), [](const State& a, const State& b) { return a.m_ns < b.m_ns; });
+            const State& median = runs[runs.size() / 2];
+
+            Result r;
+            r.name = c.name;
+            r.iterations = iterations;
+            r.nsPerOp = median.m_ns / static_cast<double>(iterations);
+            r.allocsPerOp = static_cast<double>(median.m_allocs) / static_cast<double>(iterations);
+            r.bytesPerOp = static_cast<double>(median.m_bytes) / static_cast<double>(iterations);
+            r.opsPerSec = r.nsPerOp > 0.0 ? 1e9 / r.nsPerOp : 0.0;
+            r.itemsPerSec = r.opsPerSec * static_cast<double>(median.itemsPerOp);
+            r.label = median.label;
+
+            fmt::print("{:<44} {:>12} {:>12.2f} {:>12.2f} {:>14.0f} {:>14.0f}  {}\n",
+                       r.name, r.iterations, r.nsPerOp, r.allocsPerOp, r.opsPerSec, r.itemsPerSec, r.label);
+            std::fflush(stdout);
+
+            results.push_back(std::move(r));
+        }
+
+        return results;
+    }
+
+    namespace {
+        std::string jsonEscape(const std::string& s) {
+            std::string out;
+            out.reserve(s.size());
+            for (char c : s) {
+                switch (c) {
+                    case '"': out += "\\\""; break;
+                    case '\\': out += "\\\\"; break;
+                    case '\n': out += "\\n"; break;
+                    default: out += c; break;
+                }
+            }
+            return out;
+        }
+
+        const char* compilerName() {
+#if defined(__clang__)
+            return "clang " __clang_version__;
+#elif defined(__GNUC__)
+            return "gcc " __VERSION__;
+#elif defined(_MSC_VER)
+            return "msvc";
+#else
+            return "unknown";
+#endif
+        }
+    }
+
+    bool Suite::writeJSON(const std::string& path, const std::vector<Result>& results) {
+        std::ofstream file(path);
+        if (!file) {
+            fmt::print(stderr, "[Bench]: Failed to open '{}' for writing\n", path);
+            return false;
+        }
+
+        file << "{\n";
+        file << fmt::format("  \"dexium_version\": \"{}\",\n", DEXIUM_VERSION);
+        file << fmt::format("  \"build_type\": \"{}\",\n", DEXIUM_BUILD_TYPE);
+        file << fmt::format("  \"compiler\": \"{}\",\n", jsonEscape(compilerName()));
+        file << fmt::format("  \"timestamp\": {},\n", static_cast<long long>(std::time(nullptr)));
+        file << "  \"results\": [\n";
+        for (size_t i = 0; i < results.size(); ++i) {
+            const auto& r = results[i];
+            file << fmt::format("    {{\"name\": \"{}\", \"iterations\": {}, \"ns_per_op\": {:.3f}, \"allocs_per_op\": {:.4f}, "
+                                "\"bytes_per_op\": {:.2f}, \"ops_per_sec\": {:.1f}, \"items_per_sec\": {:.1f}, \"label\": \"{}\"}}{}\n",
+                                jsonEscape(r.name), r.iterations, r.nsPerOp, r.allocsPerOp, r.bytesPerOp, r.opsPerSec,
+                                r.itemsPerSec, jsonEscape(r.label), i + 1 < results.size() ? "," : "");
+        }
+        file << "  ]\n}\n";
+        return true;
+    }
+}
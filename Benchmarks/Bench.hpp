@@ -0,0 +1,109 @@
+//
+// Created by Dextron12 on 17/10/26.
+//
+
+#ifndef DEXIUM_BENCH_HPP
+#define DEXIUM_BENCH_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+// A tiny microbenchmark harness for the dexium_bench target (see Benchmarks/main.cpp)
+/*
+ * A benchmark is a fn taking a State. It does its setup, then hands the operation to State::measure(), which runs it
+ * state.iterations times back to back. The harness picks iterations so each sample runs for roughly the min time,
+ * then reports the median sample as ns/op, heap allocations/op (global operator new is counted) & throughput.
+ */
+
+namespace Dexium::Bench {
+
+    // Totals since program start, counted by the replaced global operator new (over-aligned news aren't counted)
+    uint64_t allocationCount();
+    uint64_t allocatedBytes();
+
+    // Keeps the compiler from optimizing away a result
+    template <typename T>
+    inline void doNotOptimize(const T& value) {
+#if defined(__GNUC__) || defined(__clang__)
+        asm volatile("" : : "r,m"(value) : "memory");
+#else
+        static volatile const void* sink;
+        sink = &value;
+#endif
+    }
+
+    class State {
+    public:
+        explicit State(uint64_t iterations) : iterations(iterations) {}
+
+        uint64_t iterations;
+
+        // Items processed by one op (commands in a flush etc), used for items/s. Defaults to 1
+        uint64_t itemsPerOp = 1;
+
+        // Extra info printed after the row (draw calls per flush etc). Set it after measure()
+        std::string label;
+
+        // Times iterations calls of op. Call exactly once per benchmark run, after any setup
+        template <typename Op>
+        void measure(Op&& op) {
+            const uint64_t allocs = allocationCount();
+            const uint64_t bytes = allocatedBytes();
+            const auto start = std::chrono::steady_clock::now();
+
+            for (uint64_t i = 0; i < iterations; ++i) op();
+
+            const auto end = std::chrono::steady_clock::now();
+            m_ns = std::chrono::duration<double, std::nano>(end - start).count();
+            m_allocs = allocationCount() - allocs;
+            m_bytes = allocatedBytes() - bytes;
+        }
+
+    private:
+        friend class Suite;
+
+        double m_ns = 0.0;
+        uint64_t m_allocs = 0;
+        uint64_t m_bytes = 0;
+    };
+
+    struct Result {
+        std::string name;
+        uint64_t iterations = 0; // Per sample
+        double nsPerOp = 0.0;
+        double allocsPerOp = 0.0;
+        double bytesPerOp = 0.0;
+        double opsPerSec = 0.0;
+        double itemsPerSec = 0.0;
+        std::string label;
+    };
+
+    class Suite {
+    public:
+        using BenchFn = std::function<void(State&)>;
+
+        void add(std::string name, BenchFn fn);
+
+        // Runs every benchmark whose name contains filter (all when empty). Prints a table as it goes
+        std::vector<Result> run(const std::string& filter, double minSeconds, int samples);
+
+        // Machine readable results, for tracking regressions across releases
+        static bool writeJSON(const std::string& path, const std::vector<Result>& results);
+
+    private:
+        struct Case {
+            std::string name;
+            BenchFn fn;
+        };
+        std::vector<Case> m_cases;
+    };
+
+    // Each Benchmarks/*.cpp registers its own group
+    void registerCoreBenches(Suite& suite);
+    void registerRendererBenches(Suite& suite);
+}
+
+#endif //DEXIUM_BENCH_HPP
@@ -0,0 +1,287 @@
+//
+// Created by Dextron12 on 17/10/26.
+//
+
+#include "Bench.hpp"
+
+#include <core/Error.hpp>
+#include <core/Material.hpp>
+#include <core/Mesh.hpp>
+#include <core/MeshOptimizer.hpp>
+#include <core/ResourcePool.hpp>
+#include <core/Signal.hpp>
+#include <core/Transform.h>
+#include <core/SceneGraph.hpp>
+#include <core/TransformBuffer.hpp>
+#include <core/VertexLayout.hpp>
+
+#include <utils/ID.hpp>
+
+#include <algorithm>
+#include <array>
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace Dexium::Bench {
+
+    namespace {
+        struct Listener {
+            int total = 0;
+            void onValue(int v) { total += v; }
+        };
+
+        // The File sink doesn't write anything yet, so this measures the Logger itself rather than terminal I/O
+        void useQuietLogger(Utils::LoggerFormat format) {
+            auto& logger = Core::LogService::use();
+            if (!logger) logger = std::make_unique<Core::Logger>();
+            logger->outputs = Utils::LoggerOutput::File;
+            logger->format = format;
+        }
+    }
+
+    void registerCoreBenches(Suite& suite) {
+        // ---- ResourcePool / ResourceManager ----
+
+        suite.add("ResourcePool::add+remove", [](State& state) {
+            Private::Interfaces::ResourcePool<int> pool;
+            state.measure([&] {
+                auto handle = pool.add(std::make_unique<int>(1));
+                pool.remove(handle);
+            });
+        });
+
+        suite.add("ResourcePool::get", [](State& state) {
+            Private::Interfaces::ResourcePool<int> pool;
+            std::vector<Core::ResourceHandle<int>> handles;
+            for (int i = 0; i < 1024; ++i) handles.push_back(pool.add(std::make_unique<int>(i)));
+
+            size_t next = 0;
+            state.measure([&] {
+                doNotOptimize(pool.get(handles[next]));
+                next = (next + 1) & 1023;
+            });
+        });
+
+        suite.add("ResourceManager::getPool", [](State& state) {
+            Core::ResourceManager manager;
+            manager.getPool<int>();
+            manager.getPool<float>();
+            manager.getPool<double>();
+            state.measure([&] {
+                doNotOptimize(&manager.getPool<float>());
+            });
+        });
+
+        // ---- Signal ----
+
+        suite.add("Signal::emit (8 slots)", [](State& state) {
+            Core::Signal<int> signal;
+            Listener listeners[8];
+            std::vector<Core::Signal<int>::Connection> connections;
+            for (auto& l : listeners) connections.push_back(signal.connect<Listener, &Listener::onValue>(&l));
+
+            state.measure([&] {
+                signal.emit(1);
+            });
+            doNotOptimize(listeners[0].total);
+        });
+
+        suite.add("Signal::connect+disconnect", [](State& state) {
+            Core::Signal<int> signal;
+            Listener listener;
+            uint64_t n = 0;
+            state.measure([&] {
+                {
+                    auto connection = signal.connect<Listener, &Listener::onValue>(&listener);
+                } // Disconnects
+                // Dead slots are only dropped by cleanup(), do it now & then like a game loop would
+                if ((++n & 1023) == 0) signal.cleanup();
+            });
+        });
+
+        // ---- TraceLog ----
+
+        suite.add("TraceLog (cached repeat)", [](State& state) {
+            useQuietLogger(Utils::LoggerFormat::None);
+            state.measure([&] {
+                TraceLog(LogLevel::DEBUG, "[Bench]: Repeated message {}", 42);
+            });
+        });
+
+        suite.add("TraceLog (immediate mode)", [](State& state) {
+            useQuietLogger(Utils::LoggerFormat::ImmediateMode);
+            state.measure([&] {
+                TraceLog(LogLevel::DEBUG, "[Bench]: Repeated message {}", 42);
+            });
+            useQuietLogger(Utils::LoggerFormat::None);
+        });
+
+        // ---- UUID ----
+
+        suite.add("UUID::Generate", [](State& state) {
+            state.measure([&] {
+                doNotOptimize(Utils::UUID::Generate());
+            });
+        });
+
+        suite.add("std::hash<UUID>", [](State& state) {
+            const Utils::UUID id = Utils::UUID::Generate();
+            std::hash<Utils::UUID> hasher;
+            state.measure([&] {
+                doNotOptimize(hasher(id));
+            });
+        });
+
+        suite.add("UUID::str", [](State& state) {
+            const Utils::UUID id = Utils::UUID::Generate();
+            state.measure([&] {
+                doNotOptimize(id.str());
+            });
+        });
+
+        // ---- Transform / Material ----
+
+        suite.add("Transform::ModelMatrix (static)", [](State& state) {
+            Core::Transform transform(glm::vec3(10.f, 20.f, 0.f), glm::vec3(0.f, 0.f, 45.f), glm::vec3(2.f));
+            state.measure([&] {
+                doNotOptimize(transform.ModelMatrix());
+            });
+        });
+
+        suite.add("Transform::ModelMatrix (moving)", [](State& state) {
+            Core::Transform transform(glm::vec3(10.f, 20.f, 0.f), glm::vec3(0.f, 0.f, 45.f), glm::vec3(2.f));
+            state.measure([&] {
+                transform.position.x += 1.f; // Forces a rebuild every call
+                doNotOptimize(transform.ModelMatrix());
+            });
+        });
+
+        // Every matrix rebuilt each op, the Transform loop is the per-object baseline
+        suite.add("Transform::ModelMatrix loop (10k, moving)", [](State& state) {
+            std::vector<Core::Transform> transforms;
+            for (int i = 0; i < 10000; ++i) transforms.emplace_back(glm::vec3(static_cast<float>(i), 0.f, 0.f), glm::vec3(0.f, 0.f, static_cast<float>(i)));
+            state.itemsPerOp = transforms.size();
+            state.measure([&] {
+                for (auto& transform : transforms) {
+                    transform.position.y += 1.f;
+                    doNotOptimize(transform.ModelMatrix());
+                }
+            });
+        });
+
+        for (const bool flat : {true, false}) {
+            suite.add(flat ? "TransformBuffer::computeMatrices (10k, 2D)" : "TransformBuffer::computeMatrices (10k, 3D)", [flat](State& state) {
+                Core::TransformBuffer buffer;
+                for (int i = 0; i < 10000; ++i) {
+                    const float f = static_cast<float>(i);
+                    buffer.add(Core::Transform(glm::vec3(f, 0.f, 0.f), flat ? glm::vec3(0.f, 0.f, f) : glm::vec3(f * 0.5f, f * 0.25f, f)));
+                }
+                std::vector<glm::mat4> matrices(buffer.size());
+                state.itemsPerOp = buffer.size();
+                state.measure([&] {
+                    buffer.computeMatrices(matrices.data());
+                    doNotOptimize(matrices.front());
+                });
+            });
+        }
+
+        // 10k nodes as 100 roots with 99 children each, one child moving per frame vs every root moving
+        for (bool all : {false, true}) {
+            suite.add(all ? "SceneGraph::update (10k, every root moved)" : "SceneGraph::update (10k, one node moved)", [all](State& state) {
+                Core::SceneGraph graph;
+                graph.reserve(10000);
+                std::vector<Core::SceneGraph::Node> roots;
+                for (int r = 0; r < 100; ++r) {
+                    const auto root = graph.create(Core::Transform(glm::vec3(static_cast<float>(r), 0.f, 0.f)));
+                    roots.push_back(root);
+                    for (int c = 0; c < 99; ++c) graph.create(Core::Transform(glm::vec3(0.f, static_cast<float>(c), 0.f)), root);
+                }
+                graph.update();
+
+                const auto child = graph.handleAt(graph.indexOf(roots[50]) + 1);
+                float x = 0.f;
+                state.itemsPerOp = graph.size();
+                state.measure([&] {
+                    x += 1.f;
+                    if (all) {
+                        for (auto root : roots) graph.local(root).position.y = x;
+                    } else {
+                        graph.local(child).position.x = x;
+                    }
+                    graph.update();
+                    doNotOptimize(graph.worldAt(0));
+                });
+            });
+        }
+
+        // Build time cost of a compact layout (the GPU side saving is 20 -> 12 bytes a vertex)
+        for (bool compact : {false, true}) {
+            suite.add(compact ? "VertexLayout::pack (10k, Compact)" : "VertexLayout::pack (10k, Default)", [compact](State& state) {
+                const auto layout = compact ? Core::VertexLayout::Compact() : Core::VertexLayout::Default();
+                std::vector<float> vertices(10000 * layout.sourceFloats());
+                for (size_t i = 0; i < vertices.size(); ++i) vertices[i] = static_cast<float>(i % 97) / 97.f;
+                std::vector<unsigned char> packed(10000 * layout.stride());
+
+                state.itemsPerOp = 10000;
+                state.measure([&] {
+                    layout.pack(vertices.data(), 10000, packed.data());
+                    doNotOptimize(packed.data());
+                });
+            });
+        }
+
+        // An imported mesh's worst case: a 100x100 grid with its triangles shuffled (ACMR ~3 -> ~0.7)
+        suite.add("MeshOptimizer::optimize (20k triangles, shuffled)", [](State& state) {
+            useQuietLogger(Utils::LoggerFormat::None);
+            constexpr unsigned int N = 100;
+            Core::Mesh source;
+            for (unsigned int y = 0; y <= N; ++y) {
+                for (unsigned int x = 0; x <= N; ++x) {
+                    const float u = static_cast<float>(x) / N, v = static_cast<float>(y) / N;
+                    source.vertices.insert(source.vertices.end(), {u, v, u * v, u, v});
+                }
+            }
+            std::vector<std::array<unsigned int, 3>> triangles;
+            for (unsigned int y = 0; y < N; ++y) {
+                for (unsigned int x = 0; x < N; ++x) {
+                    const unsigned int a = y * (N + 1) + x, b = a + 1, c = a + N + 1, d = c + 1;
+                    triangles.push_back({a, c, b});
+                    triangles.push_back({b, c, d});
+                }
+            }
+            std::shuffle(triangles.begin(), triangles.end(), std::mt19937(1));
+            for (const auto& t : triangles) source.indices.insert(source.indices.end(), t.begin(), t.end());
+            source.vertexCount = static_cast<int>((N + 1) * (N + 1));
+            source.indexCount = static_cast<int>(source.indices.size());
+
+            Core::Mesh mesh;
+            state.itemsPerOp = triangles.size();
+            state.measure([&] {
+                mesh.vertices = source.vertices;
+                mesh.indices = source.indices;
+                mesh.vertexCount = source.vertexCount;
+                mesh.indexCount = source.indexCount;
+                doNotOptimize(Core::MeshOptimizer::optimize(mesh).vertexCache.acmrAfter);
+            });
+        });
+
+        suite.add("Material::setUniform (vec4 overwrite)", [](State& state) {
+            useQuietLogger(Utils::LoggerFormat::None);
+            Core::Material material;
+            material.setUniform("u_Colour", glm::vec4(1.f));
+            state.measure([&] {
+                material.setUniform("u_Colour", glm::vec4(0.5f));
+            });
+        });
+
+        suite.add("Material::setUniform (mat4 overwrite)", [](State& state) {
+            useQuietLogger(Utils::LoggerFormat::None);
+            Core::Material material;
+            material.setUniform("u_Matrix", glm::mat4(1.f));
+            state.measure([&] {
+                material.setUniform("u_Matrix", glm::mat4(2.f));
+            });
+        });
+    }
+}
@@ -0,0 +1,254 @@
+//
+// Created by Dextron12 on 17/10/26.
+//
+
+#include "Bench.hpp"
+
+#include <renderer/GLStateCache.hpp>
+#include <renderer/RecordingGL.hpp>
+#include <renderer/Renderer.hpp>
+#include <renderer/RenderPass.hpp>
+#include <renderer/RenderTarget.hpp>
+#include <renderer/SortKey.hpp>
+
+#include <core/Camera.hpp>
+#include <core/GeometryArena.hpp>
+#include <core/Material.hpp>
+#include <core/Mesh.hpp>
+#include <core/Shader.hpp>
+#include <core/Transform.h>
+
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace Dexium::Bench {
+
+    namespace {
+        constexpr size_t CommandCount = 10000;
+        constexpr size_t MaterialCount = 8;
+        constexpr size_t MeshCount = 16;
+
+        // A frame's worth of renderables, drawn through the headless RecordingGL backend
+        struct Scene {
+            std::unique_ptr<Core::Mesh> mesh;
+            std::vector<Core::Mesh*> meshes; // What store() cycles through, just mesh unless useMeshes() was called
+            std::unique_ptr<Core::GeometryArena> arena;
+            std::vector<std::unique_ptr<Core::Mesh>> extraMeshes;
+            std::vector<Core::Shader> shaders;
+            std::vector<Core::Material> materials;
+            std::vector<Core::Transform> transforms;
+
+            Core::Camera2D camera;
+            std::unique_ptr<Renderer::RenderTarget> target;
+            std::unique_ptr<Renderer::RenderPass> pass;
+            std::unique_ptr<Renderer::Renderer> renderer;
+
+            Scene() {
+                auto& gl = Renderer::RecordingGL::get();
+                if (!gl.installed()) gl.install();
+                gl.logging = false; // Counters only, the log would dominate the timings
+
+                mesh = Core::createMesh(Core::MeshType::Mesh2D::Rectangle);
+                meshes = {mesh.get()};
+
+                shaders.reserve(2);
+                for (int i = 0; i < 2; ++i) {
+                    shaders.push_back(Core::Shaders::generateDefault2DShader());
+                    shaders.back().compile();
+                }
+
+                materials.resize(MaterialCount);
+                for (size_t i = 0; i < MaterialCount; ++i) {
+                    materials[i].shader = &shaders[i % shaders.size()];
+                    materials[i].setUniform("uColor", glm::vec4(static_cast<float>(i) / MaterialCount, 0.f, 1.f, 1.f));
+                }
+
+                std::mt19937 rng(1234);
+                std::uniform_real_distribution<float> pos(0.f, 1000.f);
+                std::uniform_real_distribution<float> depth(-10.f, 10.f);
+                transforms.reserve(CommandCount);
+                for (size_t i = 0; i < CommandCount; ++i) {
+                    transforms.emplace_back(glm::vec3(pos(rng), pos(rng), depth(rng)), glm::vec3(0.f), glm::vec3(8.f));
+                }
+
+                target = std::make_unique<Renderer::RenderTarget>(Renderer::Viewport(0, 0, 1280, 720));
+                pass = std::make_unique<Renderer::RenderPass>(target.get(), &camera);
+                pass->plpState.Projection_uName = "projection";
+                pass->plpState.View_uName = "view";
+                pass->plpState.Model_uName = "model";
+                pass->setClearColor({0.f, 0.f, 0.f, 1.f});
+
+                renderer = std::make_unique<Renderer::Renderer>();
+            }
+
+            // MeshCount distinct meshes, each with its own buffers or all sharing a GeometryArena
+            void useMeshes(bool inArena) {
+                if (inArena) arena = std::make_unique<Core::GeometryArena>();
+                meshes.clear();
+                for (size_t i = 0; i < MeshCount; ++i) {
+                    const auto type = i % 2 ? Core::MeshType::Mesh2D::Triangle : Core::MeshType::Mesh2D::Rectangle;
+                    extraMeshes.push_back(inArena ? arena->createMesh(type) : Core::createMesh(type));
+                    meshes.push_back(extraMeshes.back().get());
+                }
+            }
+
+            // Interleaves materials so the sort has real work to do
+            void store() {
+                for (size_t i = 0; i < CommandCount; ++i) {
+                    pass->storeCommand(meshes[i % meshes.size()], &materials[(i * 7) % MaterialCount], &transforms[i]);
+                }
+            }
+
+            // Like store(), but every material draws every mesh (store() gives each material MeshCount / MaterialCount of them)
+            void storeMixed() {
+                for (size_t i = 0; i < CommandCount; ++i) {
+                    pass->storeCommand(meshes[(i / MaterialCount) % meshes.size()], &materials[(i * 7) % MaterialCount], &transforms[i]);
+                }
+            }
+        };
+
+        // Draw calls per op since drawsBefore, as a label. Shows whether the runs actually formed
+        std::string drawsPerOp(uint64_t drawsBefore, uint64_t ops) {
+            const uint64_t draws = Renderer::RecordingGL::get().stats().drawCalls - drawsBefore;
+            return std::to_string(draws / std::max<uint64_t>(ops, 1)) + " draws/op";
+        }
+    }
+
+    void registerRendererBenches(Suite& suite) {
+        suite.add("CommandSorter::sort (10k, incl. copy)", [](State& state) {
+            std::mt19937_64 rng(42);
+            std::vector<Renderer::Command> pristine;
+            pristine.reserve(CommandCount);
+            for (size_t i = 0; i < CommandCount; ++i) pristine.emplace_back(nullptr, nullptr, nullptr, rng());
+
+            Renderer::CommandSorter sorter;
+            std::vector<Renderer::Command> commands;
+            commands.reserve(CommandCount);
+
+            state.itemsPerOp = CommandCount;
+            state.measure([&] {
+                commands.assign(pristine.begin(), pristine.end());
+                sorter.sort(commands);
+                doNotOptimize(commands.front().sortKey);
+            });
+        });
+
+        suite.add("RenderPass::storeCommand (10k)", [](State& state) {
+            Scene scene;
+            state.itemsPerOp = CommandCount;
+            state.measure([&] {
+                scene.store();
+                scene.pass->clearCommands();
+            });
+        });
+
+        suite.add("Renderer::flush (10k, 8 materials)", [](State& state) {
+            Scene scene;
+            state.itemsPerOp = CommandCount;
+            state.measure([&] {
+                scene.store();
+                scene.renderer->submit(scene.pass.get());
+                scene.renderer->flush();
+                scene.pass->clearCommands();
+            });
+        });
+
+        suite.add("Renderer::flush instanced (10k, 8 materials)", [](State& state) {
+            Scene scene;
+            for (auto& shader : scene.shaders) {
+                shader = Core::Shaders::generateDefault2DInstancedShader();
+                shader.compile();
+            }
+            scene.pass->plpState.instancing = true;
+
+            state.itemsPerOp = CommandCount;
+            state.measure([&] {
+                scene.store();
+                scene.renderer->submit(scene.pass.get());
+                scene.renderer->flush();
+                scene.pass->clearCommands();
+            });
+        });
+
+        // A 10k vertex mesh with 3% of its vertices moving each frame. The baseline re-sends the whole VBO
+        // (what rebuilding did, minus making a new VAO & buffers every time)
+        for (bool partial : {false, true}) {
+            suite.add(partial ? "Mesh::uploadDirty (10k vertices, 3% changed)" : "Mesh full re-upload (10k vertices, 3% changed)", [partial](State& state) {
+                auto& gl = Renderer::RecordingGL::get();
+                if (!gl.installed()) gl.install();
+                gl.logging = false;
+
+                constexpr size_t Vertices = 10000, Changed = 300;
+                Core::Mesh mesh;
+                mesh.vertices.resize(Vertices * 5);
+                mesh.vertexCount = static_cast<int>(Vertices);
+                mesh.usageHint = GL_DYNAMIC_DRAW;
+                mesh.buildMesh();
+
+                size_t frame = 0;
+                state.itemsPerOp = Changed;
+                state.measure([&] {
+                    const size_t first = (frame++ * 997) % (Vertices - Changed);
+                    for (size_t v = first; v < first + Changed; ++v) mesh.vertices[v * 5 + 1] += 1.f;
+
+                    if (partial) {
+                        mesh.markVerticesDirty(first, Changed);
+                        mesh.uploadDirty();
+                    } else {
+                        Renderer::GLStateCache::get().bindBuffer(GL_ARRAY_BUFFER, mesh.VBO);
+                        glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(mesh.vertices.size() * sizeof(float)), mesh.vertices.data(), mesh.usageHint);
+                    }
+                });
+            });
+        }
+
+        // Distinct meshes break instanced runs up, multi-draw only splits on material & VAO
+        for (bool multiDraw : {false, true}) {
+            suite.add(multiDraw ? "Renderer::flush multi-draw (10k, 8 materials, 16 arena meshes)"
+                                : "Renderer::flush instanced (10k, 8 materials, 16 meshes)", [multiDraw](State& state) {
+                Scene scene;
+                for (auto& shader : scene.shaders) {
+                    shader = Core::Shaders::generateDefault2DInstancedShader();
+                    shader.compile();
+                }
+                scene.useMeshes(multiDraw);
+                scene.pass->plpState.instancing = !multiDraw;
+                scene.pass->plpState.multiDraw = multiDraw;
+
+                const uint64_t draws = Renderer::RecordingGL::get().stats().drawCalls;
+                state.itemsPerOp = CommandCount;
+                state.measure([&] {
+                    scene.store();
+                    scene.renderer->submit(scene.pass.get());
+                    scene.renderer->flush();
+                    scene.pass->clearCommands();
+                });
+                state.label = drawsPerOp(draws, state.iterations);
+            });
+        }
+
+        // Each material draws all 16 meshes at random depths, so runs only form if the sort keys group by mesh (128 draws)
+        suite.add("Renderer::flush instanced (10k, 8 materials x 16 meshes)", [](State& state) {
+            Scene scene;
+            for (auto& shader : scene.shaders) {
+                shader = Core::Shaders::generateDefault2DInstancedShader();
+                shader.compile();
+            }
+            scene.useMeshes(false);
+            scene.pass->plpState.instancing = true;
+
+            const uint64_t draws = Renderer::RecordingGL::get().stats().drawCalls;
+            state.itemsPerOp = CommandCount;
+            state.measure([&] {
+                scene.storeMixed();
+                scene.renderer->submit(scene.pass.get());
+                scene.renderer->flush();
+                scene.pass->clearCommands();
+            });
+            state.label = drawsPerOp(draws, state.iterations);
+        });
+    }
+}
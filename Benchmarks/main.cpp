@@ -0,0 +1,40 @@
+//
+// Created by Dextron12 on 17/10/26.
+//
+
+#include "Bench.hpp"
+
+#include <fmt/format.h>
+
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+// dexium_bench [--filter <substring>] [--min-time <seconds>] [--samples <n>] [--json <path>]
+int main(int argc, char** argv) {
+    std::string filter;
+    std::string jsonPath;
+    double minSeconds = 0.25;
+    int samples = 5;
+
+    for (int i = 1; i < argc; ++i) {
+        const bool hasValue = i + 1 < argc;
+        if (std::strcmp(argv[i], "--filter") == 0 && hasValue) filter = argv[++i];
+        else if (std::strcmp(argv[i], "--json") == 0 && hasValue) jsonPath = argv[++i];
+        else if (std::strcmp(argv[i], "--min-time") == 0 && hasValue) minSeconds = std::atof(argv[++i]);
+        else if (std::strcmp(argv[i], "--samples") == 0 && hasValue) samples = std::atoi(argv[++i]);
+        else {
+            fmt::print("usage: {} [--filter <substring>] [--min-time <seconds>] [--samples <n>] [--json <path>]\n", argv[0]);
+            return std::strcmp(argv[i], "--help") == 0 ? 0 : 1;
+        }
+    }
+
+    Dexium::Bench::Suite suite;
+    Dexium::Bench::registerCoreBenches(suite);
+    Dexium::Bench::registerRendererBenches(suite);
+
+    const auto results = suite.run(filter, minSeconds, samples);
+
+    if (!jsonPath.empty() && !Dexium::Bench::Suite::writeJSON(jsonPath, results)) return 1;
+    return 0;
+}
@@ -41,7 +41,10 @@ namespace Dexium::Core {
 
             const glm::mat4& getProjectionMatrix(const Renderer::Viewport& vp) override;
 
-            void update() override; // Updates the View matrix from the transform data
+            void update() override; // Updates the View matrix from the transform data (nothing to do if it hasn't moved)
+
+        private:
+            uint32_t m_viewGeneration = 0; // transform.generation() the view was built from, 0 = never
     };
 
 }
@@ -0,0 +1,102 @@
+//
+// Created by Dextron12 on 17/10/26.
+//
+
+#ifndef DEXIUM_GEOMETRYARENA_HPP
+#define DEXIUM_GEOMETRYARENA_HPP
+
+#include <core/Mesh.hpp>
+
+#include <glad/gl.h>
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace Dexium::Core {
+
+    // Packs many meshes into a few big vertex & index buffers sharing one vertex format
+    /*
+     * A Mesh from createMesh()/buildMesh() owns its own VAO, so every mesh switch in a pass is a glBindVertexArray.
+     * Meshes added to an arena are instead sub-allocated out of a page (one VAO + VBO + EBO), and only remember where
+     * their data starts (Mesh::baseVertex & Mesh::firstIndex). The Renderer draws with glDrawElementsBaseVertex, so
+     * switching between meshes of the same page binds nothing.
+     *
+     * Pages are allocated verticesPerPage/indicesPerPage big up front (bigger if a single mesh needs it), a full page
+     * just starts another one. Freed ranges go back on a per-page free list (first fit, merged with their neighbours).
+     *
+     * Every mesh in the arena is stored in its layout (vertices must hold layout.sourceFloats() floats a vertex), the
+     * mesh's own layout is overwritten. Indices are per mesh, so 16 bit whenever a mesh has <= 65536 vertices: pages are
+     * 16 or 32 bit, bigger meshes open a 32 bit page (which smaller ones may share).
+     * Arena meshes don't own any GL objects, remove() them (or just destroy them) to free their ranges, destroy() frees
+     * the pages. Meshes still in the arena when it's destroyed are left pointing at freed pages, don't draw them.
+     */
+    class GeometryArena {
+    public:
+        explicit GeometryArena(size_t verticesPerPage = 1 << 16, size_t indicesPerPage = 1 << 18,
+                               VertexLayout layout = VertexLayout::Default());
+
+        // Only unlinks the meshes still in the arena, call destroy() to free the pages
+        ~GeometryArena();
+
+        GeometryArena(const GeometryArena&) = delete;
+        GeometryArena& operator=(const GeometryArena&) = delete;
+
+        // A predefined mesh (see Core::createMesh()), living in the arena
+        std::unique_ptr<Mesh> createMesh(Mesh::_MeshType type);
+        // Use instead of Mesh::buildMesh() for a custom mesh: uploads its vertices/indices & points it into the arena
+        bool add(Mesh& mesh);
+        // Frees the mesh's ranges for reuse. It can't be drawn afterwards (until it's added again)
+        void remove(Mesh& mesh);
+
+        // Frees every page (Call before the context is destroyed)
+        void destroy();
+
+        size_t pageCount() const { return m_pages.size(); }
+        const VertexLayout& layout() const { return m_layout; }
+        bool contains(const Mesh& mesh) const { return mesh.m_arena.arena == this; }
+
+    private:
+        struct Range {
+            size_t offset, count;
+        };
+
+        struct Page {
+            GLuint VAO = 0, VBO = 0, EBO = 0;
+            GLenum indexType = GL_UNSIGNED_SHORT;
+            size_t vertexCapacity = 0, indexCapacity = 0;
+            std::vector<Range> freeVertices, freeIndices; // Sorted by offset
+        };
+
+        struct Allocation {
+            size_t page;
+            Range vertices, indices; // indices.count is 0 for meshes drawn without an EBO
+            Mesh::ArenaLink* link = nullptr; // The owning mesh's, kept current as it moves
+        };
+
+        Page& createPage(size_t vertices, size_t indices, GLenum indexType);
+
+        // First fit out of a sorted free list, SIZE_MAX if nothing fits
+        static size_t allocate(std::vector<Range>& freeList, size_t count);
+        // Returns the range, merging it with any free neighbours
+        static void release(std::vector<Range>& freeList, Range range);
+
+        // Used by Mesh::ArenaLink: frees an allocation's ranges / follows its mesh to a new address
+        void freeAllocation(uint32_t handle);
+        void relink(uint32_t handle, Mesh::ArenaLink* link);
+        // Clears every mesh's link, they can't reach the arena anymore
+        void unlinkAll();
+
+        size_t m_verticesPerPage, m_indicesPerPage;
+        VertexLayout m_layout;
+
+        std::vector<Page> m_pages;
+        // Keyed by handle, not Mesh*, so the mesh can move (& its address be reused) freely
+        std::unordered_map<uint32_t, Allocation> m_allocations;
+        uint32_t m_nextHandle = 1;
+
+        friend class Mesh;
+    };
+}
+
+#endif //DEXIUM_GEOMETRYARENA_HPP
@@ -9,6 +9,7 @@
 #include <core/Shader.hpp>
 
 #include <variant>
+#include <vector>
 
 namespace Dexium::Core {
 
@@ -27,6 +28,9 @@ namespace Dexium::Core {
 
         //entt::id_type ID;
 
+        // Compact id used by the Renderer's sort keys (see renderer/SortKey.hpp). Unique per constructed material
+        uint32_t sortID = nextSortID();
+
         // Shader program
         Shader* shader = nullptr;
 
@@ -35,19 +39,35 @@ namespace Dexium::Core {
             // Check if the value is contained within the variant
             static_assert(variant_contains<T, UniformValue>::value, "Unsupported uniform type");
 
-            auto [it, inserted] = uniforms.insert_or_assign(name, value);
-
-            if (!inserted) {
-                // WARN: Overriting existing uniform
-                TraceLog(LogLevel::WARNING, "[Material]: Overwriting uniform '{}' with a new value", name.c_str());
+            // Overwriting is normal (animated tints, uv frames...), but setting the same value again shouldn't dirty the block
+            auto it = uniforms.find(name);
+            if (it != uniforms.end()) {
+                if (std::holds_alternative<T>(it->second) && std::get<T>(it->second) == value) return;
+                it->second = value;
+            } else {
+                uniforms.emplace(name, value);
             }
-
-            // Make/Update entry
-            uniforms[name] = value;
+            m_blockDirty = true;
         };
 
         Material() = default;
 
+        // A uniform the shader's MaterialBlock doesn't hold, so it's set on the program by name
+        struct LooseUniform {
+            const std::string* name;
+            const UniformValue* value;
+        };
+
+        // Packs the uniforms into the shader's MaterialBlock layout (only if they, or the shader, changed since last time),
+        // uploads them & binds the block. Called by the Renderer on material switches, the shader's program must be bound
+        void applyBlock();
+
+        // Uniforms left over after applyBlock() (every uniform if the shader has no MaterialBlock)
+        const std::vector<LooseUniform>& getLooseUniforms() const { return m_loose; }
+
+        // Frees the MaterialBlock buffer (Call before the context is destroyed, like RenderTarget::destroy())
+        void destroy();
+
         void remUniform(const std::string& name);
         void clearUniforms();
 
@@ -60,15 +80,47 @@ namespace Dexium::Core {
         Texture* getTexture(const std::string& uniformName);
         const std::unordered_map<std::string, Texture*>& getTextures() const;
 
+        // Order independent hash of the bound texture ids. Materials sharing the same textures share the same key
+        uint32_t getTextureSetKey() const;
+
         // We purposely DON'T provide a bind() as the Render will internally handle this
         // But perhaps this funciton should provide one that will allow it to work independent of a renderer
         // to allign material with the phiolosphy of the framework
 
     private:
+        static uint32_t nextSortID();
+
         std::unordered_map<std::string, UniformValue> uniforms;
 
         std::unordered_map<std::string, Texture*> textures;
 
+        // The MaterialBlock's GL side. Copies start without a buffer (and repack into their own), moves take it along
+        struct BlockBuffer {
+            GLuint id = 0;
+            GLsizeiptr capacity = 0;
+            uint32_t reflection = 0; // Shader::reflectionGeneration() the block was packed for
+
+            BlockBuffer() = default;
+            BlockBuffer(const BlockBuffer&) {}
+            BlockBuffer& operator=(const BlockBuffer& other) {
+                if (this != &other) reflection = 0; // Keep our buffer, but repack into it
+                return *this;
+            }
+            BlockBuffer(BlockBuffer&& other) noexcept : id(other.id), capacity(other.capacity), reflection(other.reflection) {
+                other.id = 0;
+                other.capacity = 0;
+                other.reflection = 0;
+            }
+            BlockBuffer& operator=(BlockBuffer&& other) noexcept;
+        };
+
+        std::vector<unsigned char> m_block; // Packed std140 bytes
+        std::vector<LooseUniform> m_loose;
+        BlockBuffer m_blockBuffer;
+        bool m_blockDirty = true;
+
+        void packBlock();
+
 
     };
 }
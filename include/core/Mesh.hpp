@@ -5,14 +5,22 @@
 #ifndef DEXIUM_MESH_H
 #define DEXIUM_MESH_H
 
+#include <array>
 #include <memory>
 #include <variant>
 #include <functional>
+#include <vector>
 
 #include <glad/gl.h>
 
+#include <glm/glm.hpp>
+
+#include <core/VertexLayout.hpp>
+
 namespace Dexium::Core {
 
+    class GeometryArena;
+
     namespace MeshType {
         enum class Mesh2D {
             Triangle,
@@ -37,36 +45,168 @@ namespace Dexium::Core {
         unsigned int EBO = 0; // (Element Buffer Object) Allows user to set indices and reduce vertex counts
 
         int vertexCount = 0; int indexCount = 0;
+
+        // Compact id used by the Renderer's sort keys, keeps instanced runs together (see renderer/SortKey.hpp). Unique per mesh
+        uint32_t sortID = nextSortID();
+
+        // Where this mesh's data starts in its buffers (a vertex & an index, not bytes). Only non-zero for meshes
+        // sub-allocated out of a GeometryArena, the Renderer draws with these as the base vertex & index offset
+        GLint baseVertex = 0;
+        GLuint firstIndex = 0;
         std::vector<float> vertices;
         std::vector<unsigned int> indices;
 
+        // How vertices are stored on the GPU. vertices is always floats in this layout's order (layout.sourceFloats() a vertex),
+        // buildMesh() packs them down to layout.stride() bytes. Set it before building
+        VertexLayout layout = VertexLayout::Default();
+        // Set by buildMesh(): GL_UNSIGNED_SHORT when every vertex fits in 16 bits, else GL_UNSIGNED_INT
+        GLenum indexType = GL_UNSIGNED_INT;
+        size_t indexSize() const { return indexTypeSize(indexType); }
+
         // Not the clearest API
         using _MeshType = std::variant<MeshType::Mesh2D, MeshType::Mesh3D>;
 
         GLenum drawMode = GL_TRIANGLES;
         GLenum usageHint = GL_STATIC_DRAW;
 
+        // Run MeshOptimizer::optimize() (default options) before uploading, for imported meshes in poor triangle order.
+        // It renumbers vertices, so vertex indices given to updateVertices() afterwards follow the new order
+        bool optimize = false;
+
+        // Local space bounds of the vertex positions, used by the Renderer's culling (PipelineState::culling)
+        // Filled by buildMesh()/createMesh(). Meshes without bounds are never culled
+        glm::vec3 boundsMin{0.f};
+        glm::vec3 boundsMax{0.f};
+        bool hasBounds = false;
+
+        // Recomputes the bounds from vertices. Assumes each vertex starts with its xyz position (true for the default layout)
+        void computeBounds();
+
         Mesh() = default; // default constucts a mesh (Should onlyu be used for type specification purposes)
         ~Mesh() {destroy(); }
 
+        // Copies share the GL buffers but start without any streaming state (see uploadDirty()), moves take it along
+        Mesh(const Mesh&) = default;
+        Mesh& operator=(const Mesh&) = default;
+        Mesh(Mesh&&) noexcept = default;
+        Mesh& operator=(Mesh&&) noexcept = default;
+
         // Generates and uploads the Mesh on its provided data. Use createMesh for a default, or use this fn when creating your own mesh
+        // setupAttribs skips the layout: vertices go up as raw floats & the callback points the attribs at them
         void buildMesh(const std::function<void()>& setupAttribs = nullptr);
 
+        // Partial updates, for meshes that change a little every frame (deformable terrain, UI...)
+        /*
+         * Edit vertices/indices in place and mark what changed (updateVertices()/updateIndices() do both), then
+         * uploadDirty() sends just the changed ranges, no VAO/VBO rebuild & no full re-upload.
+         *
+         * The first uploadDirty() grows the mesh's own buffers into a ring of StreamRegions copies (same buffer names,
+         * so the VAO stays valid). Each upload then writes the next copy, after its fence says the GPU is done drawing
+         * from it, through an unsynchronized map so the driver never syncs. A copy also catches up on the ranges it
+         * missed while the others were in use, and baseVertex/firstIndex point the draws at the newest one.
+         *
+         * Counts are fixed, rebuild the mesh to resize it. Bounds aren't recomputed, call computeBounds() if the shape
+         * outgrows them. Only for meshes owning their buffers (not GeometryArena ones)
+         */
+        static constexpr int StreamRegions = 3;
+
+        void markVerticesDirty(size_t firstVertex, size_t count);
+        void markIndicesDirty(size_t firstIndex, size_t count);
+        // Copies count vertices (full vertices, in the mesh's layout) over vertices from firstVertex & marks them
+        void updateVertices(size_t firstVertex, const float* data, size_t count);
+        void updateIndices(size_t firstIndex, const unsigned int* data, size_t count);
+
+        void uploadDirty();
+        // Anything marked since the last uploadDirty()
+        bool isDirty() const { return m_stream.state && m_stream.state->pending; }
+        // Sub-allocated out of a GeometryArena page, so the VAO/VBO/EBO are shared with other meshes
+        bool inArena() const { return m_inArena; }
+
         // Tranform is no longer a part of Mesh, It would be its own entity
         // Rendering a Mesh directly is no longer possible, unless you built its own entity that commands the renderer how to do so
         // Mesh no loinger uploads its own data!! Instead the createMesh function will do this. (Or a function that creates a custom mesh, will do this too)
 
     private:
+        static uint32_t nextSortID();
+
         void destroy(); // Safely destroys and frees the GL buffers
 
         bool usingEBO() const { return EBO != 0; } // Helper to determine if theres an active EBO
 
+        // In vertices or indices, not bytes
+        struct DirtyRange {
+            size_t first, count;
+        };
+
+        struct StreamState {
+            bool allocated = false; // Buffers grown into the ring yet
+            bool pending = false;
+            int region = 0; // The copy draws read from
+            std::array<GLsync, StreamRegions> fences{};
+            // What each copy is missing (sorted, merged)
+            std::array<std::vector<DirtyRange>, StreamRegions> staleVertices, staleIndices;
+        };
+        // Owns the StreamState. Copies start without one (two meshes can't share a ring's fences), moves take it along
+        struct StreamHolder {
+            std::unique_ptr<StreamState> state;
+
+            StreamHolder() = default;
+            StreamHolder(const StreamHolder&) {}
+            StreamHolder& operator=(const StreamHolder& other) {
+                if (this != &other) reset();
+                return *this;
+            }
+            StreamHolder(StreamHolder&&) noexcept = default;
+            StreamHolder& operator=(StreamHolder&& other) noexcept {
+                if (this != &other) {
+                    reset();
+                    state = std::move(other.state);
+                }
+                return *this;
+            }
+
+            // Deletes any fences still in flight, then drops the state
+            void reset();
+        };
+        StreamHolder m_stream; // Made by the first mark
+
+        StreamState& stream();
+        static void markRange(std::vector<DirtyRange>& ranges, DirtyRange range);
+
+        bool m_rawVertices = false; // Built with a setupAttribs callback, so the VBO holds vertices as is
+        bool m_inArena = false; // Sub-allocated by a GeometryArena, the buffers are its pages' (set by add(), cleared by remove())
+
+        // The GeometryArena allocation this mesh owns, so a mesh destroyed without remove() still frees its ranges
+        // Copies share the ranges but don't own them (they keep m_inArena though), moves take the allocation along
+        struct ArenaLink {
+            GeometryArena* arena = nullptr;
+            uint32_t handle = 0;
+
+            ArenaLink() = default;
+            ArenaLink(const ArenaLink&) {}
+            ArenaLink& operator=(const ArenaLink& other) {
+                if (this != &other) release();
+                return *this;
+            }
+            ArenaLink(ArenaLink&& other) noexcept;
+            ArenaLink& operator=(ArenaLink&& other) noexcept;
+
+            // Hands the ranges back to the arena (if there still is one)
+            void release();
+        };
+        ArenaLink m_arena;
+        size_t vertexStride() const; // Bytes per vertex in the VBO
+        // Writes count vertices from first, as the VBO stores them
+        void packVertices(size_t first, size_t count, void* dst) const;
+
         // Private func thast generates the meshes
         void generateMesh(MeshType::Mesh2D type);
         void generateMesh(MeshType::Mesh3D type);
 
         // Relations
         friend std::unique_ptr<Mesh> createMesh(Mesh::_MeshType, const std::function<void()>& setupAttribs);
+        friend std::unique_ptr<Mesh> createMesh(Mesh::_MeshType, const VertexLayout& layout);
+        friend class GeometryArena;
 
     };
     // Your one stop shop to generating mesh's in Dexium. This helper function has two overloads:
@@ -74,6 +214,8 @@ namespace Dexium::Core {
     // 2. Generates a custom mesh defined from provided vertex/indice information and optionalally overridden default attrib locations
     // NOTE: by providing a lambda to setupAttribs, you must bind and enable the attribs yourself.
     std::unique_ptr<Mesh> createMesh(Mesh::_MeshType, const std::function<void()>& setupAttribs = nullptr);
+    // A predefined mesh stored in layout (its source data is always pos(3) + uv(2), e.g. VertexLayout::Compact())
+    std::unique_ptr<Mesh> createMesh(Mesh::_MeshType, const VertexLayout& layout);
     std::unique_ptr<Mesh> createMesh(const std::vector<float>& vertices, const std::vector<unsigned int>& indicies, std::function<void()> setupAttribs);
 
 
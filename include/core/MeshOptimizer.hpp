@@ -0,0 +1,66 @@
+//
+// Created by Dextron12 on 17/10/26.
+//
+
+#ifndef DEXIUM_MESHOPTIMIZER_HPP
+#define DEXIUM_MESHOPTIMIZER_HPP
+
+#include <cstddef>
+#include <vector>
+
+namespace Dexium::Core {
+
+    class Mesh;
+
+    // Build time reordering of triangle list meshes, so the GPU transforms, shades & fetches less
+    /*
+     * Three stages, in the order optimize() runs them:
+     * 1. Vertex cache: reorders triangles so they reuse recently transformed vertices (Forsyth's linear-speed
+     *    algorithm, scored against a 32 entry LRU).
+     * 2. Overdraw: splits that order into clusters where it costs little cache efficiency (threshold), then draws the
+     *    clusters facing out from the mesh first so they occlude the rest (Sander et al's "Tipsify" sort).
+     * 3. Vertex fetch: renumbers vertices in order of first use, so the fetches walk memory forwards. Unused vertices
+     *    are dropped.
+     *
+     * Each stage reports ACMR (vertices transformed per triangle, against a FIFO post-transform cache) before & after.
+     * 0.5 is the best a regular grid can do, 3 is no reuse at all.
+     * Vertex positions are the first 3 floats of each vertex, same as Mesh::computeBounds().
+     */
+    namespace MeshOptimizer {
+
+        struct Options {
+            bool vertexCache = true;
+            bool overdraw = true;
+            bool vertexFetch = true;
+            unsigned int cacheSize = 16;    // FIFO the ACMR (and overdraw's cluster split) is measured against
+            float overdrawThreshold = 1.05f; // How much worse ACMR the overdraw clusters may get (1.05 = 5%)
+        };
+
+        struct StageReport {
+            bool ran = false;
+            float acmrBefore = 0.f, acmrAfter = 0.f;
+        };
+
+        struct Report {
+            StageReport vertexCache, overdraw, vertexFetch;
+            // Old vertex -> new vertex after the fetch stage (UINT32_MAX for dropped ones). Empty if it didn't run
+            std::vector<unsigned int> remap;
+        };
+
+        // Runs the enabled stages over mesh.indices/vertices (call before buildMesh(), or set Mesh::optimize).
+        // Only for indexed GL_TRIANGLES meshes, anything else is left as is
+        Report optimize(Mesh& mesh, const Options& options = {});
+
+        // The stages on their own. indices is a triangle list, every index < vertexCount
+        void optimizeVertexCache(std::vector<unsigned int>& indices, size_t vertexCount);
+        void optimizeOverdraw(std::vector<unsigned int>& indices, const std::vector<float>& vertices, size_t vertexCount,
+                              unsigned int cacheSize = 16, float threshold = 1.05f);
+        // Returns the remap. vertices shrinks if some were never used
+        std::vector<unsigned int> optimizeVertexFetch(std::vector<float>& vertices, std::vector<unsigned int>& indices, size_t vertexCount);
+
+        // Average cache misses per triangle for a FIFO post-transform cache of cacheSize entries
+        float computeACMR(const std::vector<unsigned int>& indices, size_t vertexCount, unsigned int cacheSize = 16);
+    }
+}
+
+#endif //DEXIUM_MESHOPTIMIZER_HPP
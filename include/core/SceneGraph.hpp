@@ -0,0 +1,114 @@
+//
+// Created by Dextron12 on 17/10/26.
+//
+
+#ifndef DEXIUM_SCENEGRAPH_HPP
+#define DEXIUM_SCENEGRAPH_HPP
+
+#include <core/Transform.h>
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+namespace Dexium::Core {
+
+    class Mesh;
+    class Material;
+
+    // Parent/child transforms, stored flat with every parent ahead of its children
+    /*
+     * Nodes live in parallel arrays in depth-first order, so each subtree is one contiguous range
+     * [indexOf(node), indexOf(node) + subtreeSize(node)). That keeps update() a single forward sweep (a parent's world
+     * matrix is always done before its children read it), and lets a clean subtree be skipped by jumping over its range.
+     *
+     * Editing a node through local()/setLocal() flags it & its ancestors, update() then only walks into flagged
+     * subtrees and rebuilds world = parentWorld * local for the edited nodes and everything below them.
+     *
+     * setParent() moves the subtree's range in place (std::rotate on each array), so reparenting never allocates.
+     * Nodes are handles, stable across reparenting & removal, dense indices aren't.
+     *
+     * Nodes with a mesh & material can be drawn with RenderPass::storeCommand(graph, node), which submits the whole
+     * subtree. Commands point at the graph's world matrices, so submit after update() & don't add/remove/reparent
+     * nodes until the pass is flushed.
+     */
+    class SceneGraph {
+    public:
+        using Node = uint32_t;
+        static constexpr Node InvalidNode = UINT32_MAX;
+
+        // Adds a node as the last child of parent (or as a root). Making children right after their parent appends,
+        // anything else shifts the nodes after it along
+        Node create(const Transform& local = Transform(glm::vec3(0.f)), Node parent = InvalidNode);
+        // Removes node & everything below it
+        void destroy(Node node);
+        void clear();
+        void reserve(size_t count);
+
+        // Moves node (with its subtree) under parent, or makes it a root with InvalidNode. Its local transform is kept,
+        // so it snaps to the new parent's space. Returns false if parent is node itself or one of its descendants
+        bool setParent(Node node, Node parent);
+        Node getParent(Node node) const;
+
+        bool valid(Node node) const;
+        size_t size() const { return m_handles.size(); }
+
+        // Flags node dirty, so grab it again after update() before editing it next time
+        // An invalid node gets a scratch transform, edits to it go nowhere
+        Transform& local(Node node);
+        void setLocal(Node node, const Transform& local);
+
+        // As of the last update(). Identity for an invalid node
+        const glm::mat4& world(Node node) const;
+
+        // What the node draws as, nullptrs for a node that's just a pivot
+        void setRenderable(Node node, Mesh* mesh, Material* material);
+
+        // Rebuilds the world matrices of every node edited (or moved) since the last call, and their descendants
+        void update();
+
+        // Dense access, for walking a subtree's range
+        size_t indexOf(Node node) const; // SIZE_MAX if invalid
+        size_t subtreeSize(Node node) const; // 0 if invalid
+        Node handleAt(size_t index) const { return m_handles[index]; }
+        Transform& localAt(size_t index) { return m_locals[index]; }
+        const glm::mat4& worldAt(size_t index) const { return m_worlds[index]; }
+        Mesh* meshAt(size_t index) const { return m_meshes[index]; }
+        Material* materialAt(size_t index) const { return m_materials[index]; }
+
+    private:
+        enum Flags : uint8_t {
+            Dirty = 1 << 0, // Local changed, or moved to a new parent
+            SubtreeDirty = 1 << 1, // This node or something below it is Dirty
+        };
+
+        // Dense, depth-first
+        std::vector<Node> m_handles;
+        std::vector<Node> m_parents; // Handles, so they survive the ranges moving about
+        std::vector<uint32_t> m_sizes; // Subtree size, including the node
+        std::vector<Transform> m_locals;
+        std::vector<glm::mat4> m_worlds;
+        std::vector<Mesh*> m_meshes;
+        std::vector<Material*> m_materials;
+        std::vector<uint8_t> m_flags;
+
+        std::vector<uint32_t> m_indices; // Handle -> dense index (UINT32_MAX when free)
+        std::vector<Node> m_freeHandles;
+
+        // Calls f on each dense array, for ops that move ranges around
+        template<typename F>
+        void forEachArray(F&& f) {
+            f(m_handles); f(m_parents); f(m_sizes); f(m_locals);
+            f(m_worlds); f(m_meshes); f(m_materials); f(m_flags);
+        }
+
+        void markDirty(size_t index);
+        // Adds delta to the subtree size of parent & all its ancestors
+        void resizeAncestors(Node parent, int64_t delta);
+        // Refreshes m_indices for the dense range [first, last)
+        void reindex(size_t first, size_t last);
+    };
+}
+
+#endif //DEXIUM_SCENEGRAPH_HPP
@@ -5,7 +5,12 @@
 #ifndef DEXIUM_SHADER_HPP
 #define DEXIUM_SHADER_HPP
 
+#include <cstdint>
+#include <cstring>
 #include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
 
 #include <glad/gl.h>
 
@@ -24,56 +29,194 @@ namespace Dexium::Core {
         Shader(const std::string& vertex, const std::string& fragment, bool areFiles = true);
 
         void compile();
+
+        // Submits the compile & link without waiting on the driver (with GL_KHR_parallel_shader_compile it really runs in
+        // the background). isCompiled() turns true on a later frame, once it has finished. Don't copy the Shader until then
+        void compileAsync();
+
         //Checks if the program compiled withotu errors
+        // The non-const one also finishes a pending compileAsync() if the driver is done (never blocks with the extension)
+        bool isCompiled();
         bool isCompiled() const noexcept { return compiled; }
 
+        // True between compileAsync() & the isCompiled() that finishes it
+        bool isPending() const noexcept { return m_pending; }
+
+        // True if the program declares the shared CameraBlock UBO (See renderer/UniformBlocks.hpp)
+        // The Renderer then skips its per-program u_Projection/u_View uploads
+        bool usesCameraBlock() const noexcept { return cameraBlock; }
+
         void bind() const;
 
-        template<typename T>
-        void setUniform(const std::string& name, const T& value) {
-            GLint loc;
-            if (uniformCache.find(name) != uniformCache.end()) {
-                loc = uniformCache[name];
-            } else {
-                // Not yet cached
-                loc = glGetUniformLocation(ID, name.c_str());
-                uniformCache[name] = loc;
+        // Hash used for uniform name lookups (FNV-1a). constexpr, so hot names can be hashed at compile time
+        static constexpr uint32_t uniformHash(std::string_view name) {
+            uint32_t hash = 2166136261u;
+            for (char c : name) {
+                hash ^= static_cast<uint8_t>(c);
+                hash *= 16777619u;
             }
-            // Check if the location of the uniform exists (may be optimized out)
-            if (loc == -1) {
-                TraceLog(LogLevel::WARNING, "[Shader]: Uniform '{}' not found in shader", name.c_str());
-                return;
+            return hash;
+        }
+
+        // A uniform resolved once (by getUniform), so setting it is just an index into the program's uniform table
+        template<typename T>
+        struct UniformHandle {
+            int32_t index = -1;
+            bool valid() const { return index >= 0; }
+        };
+
+        // Resolves name to a handle. Invalid if the program doesn't have it (or its GLSL type doesn't match T)
+        // Handles are only good for this program, and until the next compile()
+        template<typename T>
+        UniformHandle<T> getUniform(std::string_view name) {
+            static_assert(isUniformType<T>(), "Unsupported uniform type");
+
+            const int32_t index = findUniform(name);
+            if (index < 0) return {};
+
+            if (!typeMatches<T>(m_uniforms[index].type)) {
+                TraceLog(LogLevel::WARNING, "[Shader]: Uniform '{}' isn't a {} in the shader, handle not resolved", name, typeName<T>());
+                return {};
             }
-            // Set the uniform for its type
-            if constexpr (std::is_same_v<T, float>) {
-                //float
-                glUniform1f(loc, value);
-            }else if constexpr (std::is_same_v<T, int>) {
-                //int
-                glUniform1i(loc, value);
-            } else if constexpr (std::is_same_v<T, bool>) {
-                //bool
-                glUniform1i(loc, value);
-            } else if constexpr (std::is_same_v<T, glm::vec2>) {
-                //vec2
-                glUniform2fv(loc, 1, glm::value_ptr(value));
-            } else if constexpr (std::is_same_v<T, glm::vec3>) {
-                glUniform3fv(loc, 1, glm::value_ptr(value));
-            } else if constexpr (std::is_same_v<T, glm::vec4>) {
-                glUniform4fv(loc, 1, glm::value_ptr(value));
-            } else if constexpr (std::is_same_v<T, glm::mat4>) {
-                glUniformMatrix4fv(loc, 1, GL_FALSE, glm::value_ptr(value));
+            return {index};
+        }
+
+        // Uploads value unless the uniform already holds it. The program must be bound
+        // Values are shadowed per Shader object, so don't share one compiled program between copies of a Shader
+        template<typename T>
+        void setUniform(UniformHandle<T> handle, const T& value) {
+            if (!handle.valid() || handle.index >= static_cast<int32_t>(m_uniforms.size())) return;
+            upload(m_uniforms[handle.index], value);
+        }
+
+        // Same, looked up by name (no allocation, names the program doesn't have are warned about once)
+        template<typename T>
+        void setUniform(std::string_view name, const T& value) {
+            static_assert(isUniformType<T>(), "Unsupported uniform type");
+
+            const int32_t index = findUniform(name);
+            if (index < 0) return;
+            upload(m_uniforms[index], value);
+        }
+
+        // Forget the shadowed values, so every uniform is uploaded again. Only needed after setting uniforms with raw GL calls
+        void invalidateUniforms();
+
+        // A member of the program's MaterialBlock (See renderer/UniformBlocks.hpp), where Materials pack their values
+        struct BlockMember {
+            std::string name;
+            uint32_t hash = 0; // uniformHash(name)
+            GLint offset = 0; // std140 byte offset
+            GLenum type = 0;
+        };
+
+        // Byte size of the MaterialBlock, 0 if the program doesn't declare one
+        GLint materialBlockSize() const noexcept { return m_materialBlockSize; }
+        const std::vector<BlockMember>& materialBlockMembers() const noexcept { return m_materialBlock; }
+        // Changes whenever the reflection above is rebuilt (finishCompile() / a cache load), unique across Shaders. 0 = never reflected
+        // The program ID is no good for this, compileAsync() hands it out before there's any reflection
+        uint32_t reflectionGeneration() const noexcept { return m_reflectionGeneration; }
+
+    private:
+        // One active uniform of the program (reflected at compile, or added on first lookup)
+        struct UniformSlot {
+            std::string name;
+            uint32_t hash = 0;
+            GLint location = -1; // -1 for names the program doesn't have, kept so they're only looked up & warned about once
+            GLenum type = 0; // GL type (GL_FLOAT_MAT4...), 0 if unknown
+
+            // Last uploaded value, bitwise. Identical uploads are skipped
+            alignas(16) unsigned char shadow[sizeof(glm::mat4)]{};
+            bool shadowValid = false;
+        };
+
+        template<typename T>
+        static constexpr bool isUniformType() {
+            return std::is_same_v<T, float> || std::is_same_v<T, int> || std::is_same_v<T, bool> ||
+                   std::is_same_v<T, glm::vec2> || std::is_same_v<T, glm::vec3> || std::is_same_v<T, glm::vec4> ||
+                   std::is_same_v<T, glm::mat4>;
+        }
+
+        template<typename T>
+        static bool typeMatches(GLenum type) {
+            if (type == 0) return true; // Unknown (lazy lookup), trust the caller
+            if constexpr (std::is_same_v<T, float>) return type == GL_FLOAT;
+            else if constexpr (std::is_same_v<T, int> || std::is_same_v<T, bool>) return !isFloatType(type); // ints, bools & samplers
+            else if constexpr (std::is_same_v<T, glm::vec2>) return type == GL_FLOAT_VEC2;
+            else if constexpr (std::is_same_v<T, glm::vec3>) return type == GL_FLOAT_VEC3;
+            else if constexpr (std::is_same_v<T, glm::vec4>) return type == GL_FLOAT_VEC4;
+            else return type == GL_FLOAT_MAT4;
+        }
+
+        template<typename T>
+        static const char* typeName() {
+            if constexpr (std::is_same_v<T, float>) return "float";
+            else if constexpr (std::is_same_v<T, int>) return "int";
+            else if constexpr (std::is_same_v<T, bool>) return "bool";
+            else if constexpr (std::is_same_v<T, glm::vec2>) return "vec2";
+            else if constexpr (std::is_same_v<T, glm::vec3>) return "vec3";
+            else if constexpr (std::is_same_v<T, glm::vec4>) return "vec4";
+            else return "mat4";
+        }
+
+        static bool isFloatType(GLenum type);
+
+        // Index into m_uniforms, or -1 if the program doesn't have name
+        int32_t findUniform(std::string_view name);
+
+        template<typename T>
+        void upload(UniformSlot& slot, const T& value) {
+            // bools go up as ints, so compare them that way too
+            using Stored = std::conditional_t<std::is_same_v<T, bool>, int, T>;
+            const Stored stored = static_cast<Stored>(value);
+            static_assert(sizeof(Stored) <= sizeof(slot.shadow));
+
+            if (slot.shadowValid && std::memcmp(slot.shadow, &stored, sizeof(Stored)) == 0) return;
+            std::memcpy(slot.shadow, &stored, sizeof(Stored));
+            slot.shadowValid = true;
+
+            if constexpr (std::is_same_v<Stored, float>) {
+                glUniform1f(slot.location, stored);
+            } else if constexpr (std::is_same_v<Stored, int>) {
+                glUniform1i(slot.location, stored);
+            } else if constexpr (std::is_same_v<Stored, glm::vec2>) {
+                glUniform2fv(slot.location, 1, glm::value_ptr(stored));
+            } else if constexpr (std::is_same_v<Stored, glm::vec3>) {
+                glUniform3fv(slot.location, 1, glm::value_ptr(stored));
+            } else if constexpr (std::is_same_v<Stored, glm::vec4>) {
+                glUniform4fv(slot.location, 1, glm::value_ptr(stored));
             } else {
-                TraceLog(LogLevel::ERROR, "[Shader]: Unsupported uniform value requested to be set");
+                glUniformMatrix4fv(slot.location, 1, GL_FALSE, glm::value_ptr(stored));
             }
         }
 
-    private:
+        // Fills m_uniforms & the MaterialBlock layout from the linked program (glGetActiveUniform)
+        void reflectUniforms();
+
         std::string vertexCode, fragmentCode;
 
-        std::unordered_map<std::string, GLint> uniformCache; // Per program uniform cache for lookups (no need for continiously polling locations)
+        std::vector<UniformSlot> m_uniforms; // Dense per program uniform table, see getUniform()/findUniform()
+
+        std::vector<BlockMember> m_materialBlock;
+        GLint m_materialBlockSize = 0;
+        uint32_t m_reflectionGeneration = 0;
 
         bool compiled = false; // enabled when shader is successfully compiled
+        bool cameraBlock = false;
+
+        // An in flight compile (see compileAsync())
+        bool m_pending = false;
+        GLuint m_vertex = 0, m_fragment = 0;
+        bool m_caching = false;
+        uint64_t m_cacheKey = 0;
+
+        // Kicks off the compile & link. False if there's nothing to wait on (loaded from the cache, or no sources)
+        bool beginCompile();
+        // Checks the results & finishes the program off (blocks if the driver is still going)
+        void finishCompile();
+
+        // Points every engine uniform block the program declares at its fixed binding
+        void bindUniformBlocks();
     };
 
 
@@ -81,9 +224,26 @@ namespace Dexium::Core {
         namespace PREBUILT_2D {
             extern const std::string SHADER_2D_VERTEX;
             extern const std::string SHADER_2D_FRAGMENT;
+
+            // Same as SHADER_2D_VERTEX, but the model matrix is a per-instance attribute (locations 2-5)
+            // Use with PipelineState::instancing (pairs with SHADER_2D_FRAGMENT)
+            extern const std::string SHADER_2D_INSTANCED_VERTEX;
+
+            // Used by SpriteBatch. Vertices are already in world space & carry their own colour
+            extern const std::string SHADER_2D_BATCH_VERTEX;
+            extern const std::string SHADER_2D_BATCH_FRAGMENT;
+
+            // GL_TEXTURE_2D_ARRAY variants (see TextureArrayPool). The mesh one picks its layer with the int u_Layer uniform,
+            // the batch one with the per-vertex layer SpriteBatch writes
+            extern const std::string SHADER_2D_ARRAY_FRAGMENT;
+            extern const std::string SHADER_2D_BATCH_ARRAY_FRAGMENT;
         }
 
         Shader generateDefault2DShader();
+        Shader generateDefault2DInstancedShader();
+        Shader generateDefault2DBatchShader();
+        Shader generateDefault2DArrayShader();
+        Shader generateDefault2DBatchArrayShader();
     }
 
 }
@@ -0,0 +1,54 @@
+//
+// Created by Dextron12 on 17/10/26.
+//
+
+#ifndef DEXIUM_SHADERCACHE_HPP
+#define DEXIUM_SHADERCACHE_HPP
+
+#include <glad/gl.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+
+// On-disk cache of linked program binaries (glGetProgramBinary/glProgramBinary, GL 4.1+)
+/*
+ * Once enabled, Shader::compile() first asks the cache for a binary of the same sources. A hit skips glCompileShader &
+ * glLinkProgram entirely, a miss (or a binary the driver rejects) compiles like normal and stores the result.
+ *
+ * Entries are keyed by a hash of both sources + GL_VENDOR/GL_RENDERER/GL_VERSION, so a driver update just misses the
+ * cache rather than loading a stale binary. Files are plain <key>.bin blobs, deleting the directory clears the cache.
+ */
+
+namespace Dexium::Core {
+
+    class ShaderCache {
+    public:
+        // Turns the cache on. dir is relative to the VFS root (so call after VFS::init() & with a current GL context)
+        // Returns false (leaving the cache off) if the driver can't hand out program binaries or dir can't be made
+        static bool enable(const std::filesystem::path& dir = "cache/shaders");
+        static void disable();
+        static bool enabled() noexcept { return m_enabled; }
+
+        // Key for a source pair on the current driver
+        static uint64_t key(const std::string& vertex, const std::string& fragment);
+
+        // A linked program made from the cached binary for key. 0 on a miss or if the driver rejected the binary
+        // (the stale entry is then deleted), in which case compile normally
+        static GLuint load(uint64_t key);
+
+        // Writes program's binary under key. The program should be linked with GL_PROGRAM_BINARY_RETRIEVABLE_HINT set
+        static void store(GLuint program, uint64_t key);
+
+    private:
+        static std::filesystem::path entryPath(uint64_t key);
+
+        static bool m_enabled;
+        static std::filesystem::path m_dir;
+        static std::string m_driver; // Vendor, renderer & version, hashed into every key
+
+        ShaderCache() = default;
+    };
+}
+
+#endif //DEXIUM_SHADERCACHE_HPP
@@ -0,0 +1,122 @@
+//
+// Created by Dextron12 on 17/10/26.
+//
+
+#ifndef DEXIUM_SPRITEBATCH_HPP
+#define DEXIUM_SPRITEBATCH_HPP
+
+#include <core/Colour.h>
+#include <core/Shader.hpp>
+#include <core/TextureArrayPool.hpp>
+
+#include <renderer/StreamBuffer.hpp>
+
+#include <glm/glm.hpp>
+
+#include <memory>
+#include <vector>
+
+namespace Dexium::Core {
+
+    class Texture;
+    class Transform;
+
+    // A streaming 2D renderable for LOTS of moving sprites
+    /*
+     * Instead of a Mesh + draw per quad, sprites are queued each frame and on render() their 4 corners are
+     * transformed on the CPU and written straight into a triple buffered StreamBuffer (persistently mapped when
+     * the context supports it, orphaned otherwise). Sprites sharing a texture become a single draw.
+     *
+     * Like every other renderable, the batch only observes its Textures, it never owns them.
+     * Queue sprites with draw() every frame, then either hand the batch to a RenderPass (RenderPass::storeBatch)
+     * or call render() yourself. The queue is cleared after rendering.
+     */
+    class SpriteBatch {
+    public:
+        // The vertex format written to the GPU (28 bytes)
+        struct Vertex {
+            glm::vec3 position;
+            glm::vec2 uv;
+            uint32_t colour; // RGBA8
+            float layer; // Array layer, ignored for GL_TEXTURE_2D textures
+        };
+
+        // maxSprites is the size of a single ring region, more sprites than this are just drawn in multiple chunks
+        explicit SpriteBatch(size_t maxSprites = 16384);
+
+        SpriteBatch(const SpriteBatch&) = delete;
+        SpriteBatch& operator=(const SpriteBatch&) = delete;
+        // Moves take the GL objects along, leaving the source to re-init on its next render()
+        SpriteBatch(SpriteBatch&& other) noexcept;
+        SpriteBatch& operator=(SpriteBatch&& other) noexcept;
+
+        // Queue a sprite. pos is the top-left corner (before rotation), rotation (degrees) is applied around origin
+        // uvRect is (left, top, right, bottom) in texture space, which is also what a TextureAtlas hands back
+        void draw(Texture* texture, const glm::vec2& pos, const glm::vec2& size,
+                  const glm::vec4& uvRect = {0.f, 0.f, 1.f, 1.f}, const Colour& colour = {1.f, 1.f, 1.f, 1.f},
+                  float rotation = 0.f, const glm::vec2& origin = {0.f, 0.f}, float depth = 0.f);
+
+        // Same, but samples one layer of a TextureArrayPool array. Sprites from the same array are drawn together whatever their layer
+        void draw(const TextureArrayPool::Layer& layer, const glm::vec2& pos, const glm::vec2& size,
+                  const glm::vec4& uvRect = {0.f, 0.f, 1.f, 1.f}, const Colour& colour = {1.f, 1.f, 1.f, 1.f},
+                  float rotation = 0.f, const glm::vec2& origin = {0.f, 0.f}, float depth = 0.f);
+
+        // Queue a unit quad transformed by transform (Same quad space as MeshData::quadVertices)
+        void draw(Texture* texture, Transform& transform,
+                  const glm::vec4& uvRect = {0.f, 0.f, 1.f, 1.f}, const Colour& colour = {1.f, 1.f, 1.f, 1.f});
+
+        // Writes every queued sprite into the stream buffer and draws them, one draw per texture run. Clears the queue.
+        void render(const glm::mat4& projection, const glm::mat4& view);
+
+        // Drops any queued sprites without drawing them
+        void clear();
+
+        size_t size() const { return m_sprites.size(); }
+
+        // Frees the VAO, the index buffer & the stream buffer (Call before the context is destroyed)
+        void destroy();
+
+        // When true (default) sprites are stably grouped by texture before drawing, so each texture is one draw.
+        // Turn it off for blended sprites that rely on submission order (draws then only merge adjacent sprites)
+        bool sortByTexture = true;
+
+        // Overrides the built-in batch shader. Must consume the Vertex layout (0: vec3 pos, 1: vec2 uv, 2: vec4 colour, 3: float layer)
+        // and u_Texture, plus either the CameraBlock or plain u_Projection & u_View uniforms (See Shaders::PREBUILT_2D::SHADER_2D_BATCH_VERTEX)
+        Shader* shader = nullptr;
+        // Same, for sprites whose texture is a GL_TEXTURE_2D_ARRAY (u_Texture is a sampler2DArray)
+        Shader* arrayShader = nullptr;
+
+    private:
+        struct QueuedSprite {
+            Texture* texture;
+            glm::vec3 corners[4]; // Pre-transformed (tl, tr, br, bl)
+            glm::vec4 uvRect;
+            uint32_t colour;
+            float layer;
+        };
+
+        // Shared by both 2D draw() overloads
+        void queue(Texture* texture, float layer, const glm::vec2& pos, const glm::vec2& size, const glm::vec4& uvRect,
+                   const Colour& colour, float rotation, const glm::vec2& origin, float depth);
+
+        // Binds shader (if it isn't already) with the frame's matrices
+        void useShader(Shader* shader, const glm::mat4& projection, const glm::mat4& view);
+
+        void initGL();
+
+        size_t m_maxSprites;
+
+        std::vector<QueuedSprite> m_sprites;
+        std::vector<uint32_t> m_order; // Draw order into m_sprites
+
+        Renderer::StreamBuffer m_vertices;
+        GLuint m_VAO = 0;
+        GLuint m_EBO = 0; // Static quad index pattern, shared by every chunk
+
+        std::unique_ptr<Shader> m_defaultShader;
+        std::unique_ptr<Shader> m_defaultArrayShader;
+        Shader* m_activeShader = nullptr; // During render()
+    };
+}
+
+#endif //DEXIUM_SPRITEBATCH_HPP
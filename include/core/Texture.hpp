@@ -40,9 +40,11 @@ namespace Dexium::Core {
     class Texture {
     public:
         unsigned int texID = 0;
+        unsigned int target = 0x0DE1; // GL_TEXTURE_2D, or GL_TEXTURE_2D_ARRAY (0x8C1A) for TextureArrayPool arrays
         Utils::TexFlags flags = Utils::TexFlags::None;
 
         int width = 0, height = 0, nrChannels = 0;
+        int layers = 1; // Only > 1 for array textures
 
         ~Texture();
 
@@ -52,7 +54,7 @@ namespace Dexium::Core {
         Texture& operator=(const Texture&) = delete;
 
         // Checks stored flags and uploads params according to the flag specifications
-        // REQUIRES: The texture bound to GL_TEXTURE_2D
+        // REQUIRES: The texture bound to its target
         void uploadParameters() const;
 
         bool load(const std::filesystem::path& path);
@@ -0,0 +1,85 @@
+//
+// Created by Dextron12 on 17/10/26.
+//
+
+#ifndef DEXIUM_TEXTUREARRAYPOOL_HPP
+#define DEXIUM_TEXTUREARRAYPOOL_HPP
+
+#include <core/Texture.hpp>
+
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace Dexium::Core {
+
+    class Material;
+
+    // Groups same sized images into GL_TEXTURE_2D_ARRAY textures, one layer per image
+    /*
+     * The Renderer hands out a texture slot per distinct Texture, so lots of individually loaded sprites exhaust the slots
+     * and every pass rebinds. Pooled images of the same size all live in one array Texture (target GL_TEXTURE_2D_ARRAY),
+     * so they share a single slot & bind, and pick their image with a layer index instead:
+     *  - Meshes: apply() sets the material's sampler to the array & an int "u_Layer" uniform.
+     *    Use Shaders::generateDefault2DArrayShader() (or sample a sampler2DArray with vec3(uv, u_Layer) yourself)
+     *  - SpriteBatch: draw(Layer, ...) puts the layer in the vertex, so any mix of layers from one array is one draw
+     *
+     * Images are always stored as RGBA8, flipped like Texture::load(). Arrays are allocated layersPerArray deep up front,
+     * a full array just starts another one for that size.
+     */
+    class TextureArrayPool {
+    public:
+        struct Layer {
+            Texture* array = nullptr; // Owned by the pool
+            int layer = -1;
+
+            bool valid() const { return array != nullptr && layer >= 0; }
+        };
+
+        explicit TextureArrayPool(int layersPerArray = 256,
+                                  Utils::TexFlags flags = Utils::TexFlags::Linear | Utils::TexFlags::ClampEdge);
+
+        TextureArrayPool(const TextureArrayPool&) = delete;
+        TextureArrayPool& operator=(const TextureArrayPool&) = delete;
+
+        // Loads an image file (via the VFS) into a free layer of the array matching its size
+        Layer insert(const std::filesystem::path& path);
+        // Tightly packed RGBA8 pixels, rows bottom-up
+        Layer insert(const unsigned char* rgba, int width, int height);
+
+        // Frees the layer for reuse
+        bool remove(const Layer& layer);
+
+        // Points material's sampler at the layer's array & sets layerUniform to its index
+        bool apply(const Layer& layer, Material& material, const std::string& samplerName = "texture1",
+                   const std::string& layerUniform = "u_Layer") const;
+
+        // Frees every array (Call before the context is destroyed)
+        void destroy();
+
+        size_t arrayCount() const;
+
+    private:
+        struct Array {
+            std::unique_ptr<Texture> texture;
+            int nextLayer = 0; // Layers below this have been handed out at least once
+            std::vector<int> freeLayers;
+            int used = 0;
+        };
+
+        struct Bucket {
+            int width, height;
+            std::vector<std::unique_ptr<Array>> arrays;
+        };
+
+        Array& createArray(Bucket& bucket);
+
+        int m_layersPerArray;
+        Utils::TexFlags m_flags;
+
+        std::vector<Bucket> m_buckets; // One per image size
+    };
+}
+
+#endif //DEXIUM_TEXTUREARRAYPOOL_HPP
@@ -0,0 +1,118 @@
+//
+// Created by Dextron12 on 17/10/26.
+//
+
+#ifndef DEXIUM_TEXTUREATLAS_HPP
+#define DEXIUM_TEXTUREATLAS_HPP
+
+#include <core/Texture.hpp>
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace Dexium::Core {
+
+    class Material;
+
+    // Packs lots of small images into a few large texture pages at runtime (skyline bottom-left packer)
+    /*
+     * Every inserted image gets a Handle. Its Region says which page (a regular Texture) it landed on and its uvRect,
+     * which is exactly what SHADER_2D_VERTEX's uvRect uniform & SpriteBatch::draw() want. Everything sharing a page is
+     * one texture to the Renderer, so sprites stop fighting over texture slots.
+     *
+     * The skyline can't reuse the space of removed images, so after lots of remove() calls run defragment(). It repacks
+     * every live image (largest first) into fresh pages from the CPU copies kept here. Handles stay valid, but regions
+     * move: compare generation() and re-apply() materials when it changes.
+     *
+     * Images are flipped on insert like Texture::load(), so uvRect is (u0, v0, u1, v1) with v0 at the image's bottom row.
+     */
+    class TextureAtlas {
+    public:
+        using Handle = uint32_t;
+        static constexpr Handle InvalidHandle = 0xFFFFFFFFu;
+
+        struct Region {
+            Texture* page = nullptr; // Owned by the atlas
+            uint32_t pageIndex = 0;
+            int x = 0, y = 0, width = 0, height = 0; // Texels, excluding padding
+            glm::vec4 uvRect{0.f}; // Normalised (u0, v0, u1, v1)
+        };
+
+        // padding is extruded edge texels around each image, so linear filtering doesn't bleed between neighbours
+        explicit TextureAtlas(int pageSize = 2048, int padding = 1);
+
+        TextureAtlas(const TextureAtlas&) = delete;
+        TextureAtlas& operator=(const TextureAtlas&) = delete;
+
+        // Loads an image file (via the VFS) and packs it
+        Handle insert(const std::filesystem::path& path);
+        // Packs tightly packed RGBA8 pixels (rows bottom-up, i.e. already flipped for GL)
+        Handle insert(const unsigned char* rgba, int width, int height);
+
+        // Frees the handle. Its space is only reclaimed by defragment()
+        bool remove(Handle handle);
+
+        // nullptr for removed/invalid handles
+        const Region* get(Handle handle) const;
+
+        // Points material's sampler at the handle's page & sets its "uvRect" uniform
+        bool apply(Handle handle, Material& material, const std::string& samplerName = "texture1") const;
+
+        // Repacks every live image into as few pages as possible
+        void defragment();
+
+        // Frees every page (Call before the context is destroyed, like RenderTarget::destroy())
+        void destroy();
+
+        // Bumped whenever regions move (defragment)
+        uint32_t generation() const { return m_generation; }
+
+        size_t pageCount() const { return m_pages.size(); }
+        Texture* getPage(size_t index) const { return index < m_pages.size() ? m_pages[index]->texture.get() : nullptr; }
+
+        // Live image area / area the skylines have consumed. Low values mean defragment() is worth it
+        float occupancy() const;
+
+    private:
+        struct SkylineNode {
+            int x, y, width;
+        };
+
+        struct Page {
+            std::unique_ptr<Texture> texture;
+            std::vector<SkylineNode> skyline;
+            size_t usedArea = 0; // Area under the skyline, including holes left by removed images
+        };
+
+        struct Entry {
+            bool alive = false;
+            std::vector<unsigned char> pixels; // Padded RGBA8 copy, used to defragment
+            int paddedWidth = 0, paddedHeight = 0;
+            Region region;
+        };
+
+        // Finds the lowest (then left-most) spot for a w*h rect on the page. Returns the skyline node index or -1
+        int findPosition(const Page& page, int w, int h, int& outX, int& outY) const;
+        void addSkylineLevel(Page& page, int nodeIndex, int x, int y, int w, int h);
+
+        bool place(Entry& entry);
+        Page& newPage();
+        void upload(const Entry& entry, const Page& page) const;
+
+        int m_pageSize;
+        int m_padding;
+
+        std::vector<std::unique_ptr<Page>> m_pages;
+        std::vector<Entry> m_entries; // Indexed by Handle
+        std::vector<Handle> m_freeHandles;
+
+        uint32_t m_generation = 0;
+    };
+}
+
+#endif //DEXIUM_TEXTUREATLAS_HPP
@@ -7,12 +7,14 @@
 
 #include <glm/glm.hpp>
 
+#include <cstdint>
+
 namespace Dexium::Core {
 
     class Transform {
     public:
         glm::vec3 position;
-        glm::vec3 rotation; // Rot is done in euler angles (radians) -> (pitch, yaw, roll)
+        glm::vec3 rotation; // Rot is done in euler angles (degrees) -> (pitch, yaw, roll)
         glm::vec3 scale;
 
         Transform() = default;
@@ -20,11 +22,23 @@ namespace Dexium::Core {
             :position(pos), rotation(rot), scale(scale){}
 
         // Returns a glm::mat4 model matrix of this transform(pos + rot + scale)
-        glm::mat4 ModelMatrix();
+        // Cached: only rebuilt when position, rotation or scale differ from the last call, so static objects cost a compare
+        const glm::mat4& ModelMatrix();
+
+        // Changes every time ModelMatrix() actually rebuilds, so dependants (camera views...) can skip their own work too
+        // Drawn from one counter shared by every Transform, so a copied or reassigned transform never repeats one, 0 = never built
+        uint32_t generation() const noexcept { return m_generation; }
+
+    private:
+        // What m_model was built from
+        glm::vec3 m_cachedPosition{0.f}, m_cachedRotation{0.f}, m_cachedScale{0.f};
+        glm::mat4 m_model{1.f};
+        uint32_t m_generation = 0;
+        bool m_cached = false;
     };
 
 
 }
 
 
-#endif //DEXIUM_TRANSFORM_H
\ No newline at end of file
+#endif //DEXIUM_TRANSFORM_H
@@ -0,0 +1,80 @@
+//
+// Created by Dextron12 on 17/10/26.
+//
+
+#ifndef DEXIUM_TRANSFORMBUFFER_HPP
+#define DEXIUM_TRANSFORMBUFFER_HPP
+
+#include <core/Transform.h>
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+namespace Dexium::Core {
+
+    // Many transforms stored as structure of arrays, for building model matrices in bulk
+    /*
+     * Where Transform::ModelMatrix() is built for caching one object, this is built for throughput: computeMatrices()
+     * walks the arrays 4 transforms at a time (SSE2 when available, scalar otherwise), with its own sin/cos so the
+     * trig is vectorised too. Groups with no X/Y rotation (the usual 2D case) take a cheaper Z-only path.
+     * Large buffers are split across threads, like CommandSorter.
+     *
+     * Matrices come out in dense order (indexOf()/handleAt() map between the two). Removing swaps the last transform
+     * into the hole, so dense order isn't stable, handles are.
+     * InstanceBuffer::upload(const TransformBuffer&) writes the matrices straight into the instance buffer.
+     *
+     * Transform stays its own type (its fields are plain members, they can't alias these arrays), get()/set() convert.
+     */
+    class TransformBuffer {
+    public:
+        using Handle = uint32_t;
+        static constexpr Handle InvalidHandle = UINT32_MAX;
+
+        // Buffers with at least this many transforms are split across threads (0 disables threading)
+        size_t parallelThreshold = 65536;
+        // Max worker threads (0 = std::thread::hardware_concurrency)
+        unsigned maxThreads = 0;
+
+        Handle add(const Transform& transform);
+        void remove(Handle handle);
+        void clear();
+        void reserve(size_t count);
+
+        bool valid(Handle handle) const;
+        size_t size() const { return m_handles.size(); }
+
+        Transform get(Handle handle) const;
+        void set(Handle handle, const Transform& transform);
+
+        void setPosition(Handle handle, const glm::vec3& position);
+        void setRotation(Handle handle, const glm::vec3& rotation); // Degrees, like Transform
+        void setScale(Handle handle, const glm::vec3& scale);
+
+        // Dense index of handle (its matrix's slot in computeMatrices() output), or SIZE_MAX if invalid
+        size_t indexOf(Handle handle) const;
+        Handle handleAt(size_t index) const { return m_handles[index]; }
+
+        // Writes size() model matrices to out (same maths as Transform::ModelMatrix())
+        void computeMatrices(glm::mat4* out) const;
+
+        // Just the dense range [first, first + count)
+        void computeMatrices(glm::mat4* out, size_t first, size_t count) const;
+
+    private:
+        // SoA, indexed densely
+        std::vector<float> m_px, m_py, m_pz;
+        std::vector<float> m_rx, m_ry, m_rz;
+        std::vector<float> m_sx, m_sy, m_sz;
+
+        std::vector<Handle> m_handles; // Dense index -> handle
+        std::vector<uint32_t> m_indices; // Handle -> dense index (UINT32_MAX when free)
+        std::vector<Handle> m_freeHandles;
+
+        // Single threaded kernel over a dense range
+        void computeRange(glm::mat4* out, size_t first, size_t count) const;
+    };
+}
+
+#endif //DEXIUM_TRANSFORMBUFFER_HPP
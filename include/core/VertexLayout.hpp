@@ -0,0 +1,79 @@
+//
+// Created by Dextron12 on 17/10/26.
+//
+
+#ifndef DEXIUM_VERTEXLAYOUT_HPP
+#define DEXIUM_VERTEXLAYOUT_HPP
+
+#include <glad/gl.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Dexium::Core {
+
+    // How one attribute is stored on the GPU. Mesh data is always authored as floats, buildMesh() converts it
+    enum class VertexFormat : uint8_t {
+        Float, Float2, Float3, Float4,
+        Half2,
+        Half3,     // Padded to 8 bytes, attribs stay 4 byte aligned
+        Half4,
+        UNorm16x2, // [0, 1] -> uint16, for UVs that don't tile past the edge
+        UNorm8x4,  // [0, 1] -> RGBA8, colours
+        SNorm10x3  // [-1, 1] -> GL_INT_2_10_10_10_REV (w = 0), normals & tangents
+    };
+
+    // Describes a mesh's vertex attributes in place of raw glVertexAttribPointer calls
+    /*
+     * Each attribute reads its components (in order) out of the mesh's float vertices, and is stored as its format.
+     * So a pos(3) + uv(2) mesh is 5 floats a vertex either way, but 20 bytes on the GPU with Default() & 12 with Compact().
+     * Attributes are packed back to back, the stride is their sum.
+     */
+    class VertexLayout {
+    public:
+        struct Attribute {
+            GLuint location;
+            VertexFormat format;
+            uint32_t offset; // Bytes into the packed vertex
+        };
+
+        VertexLayout() = default;
+
+        VertexLayout& add(GLuint location, VertexFormat format);
+
+        // pos Float3 @ 0, uv Float2 @ 1. What createMesh() has always used
+        static VertexLayout Default();
+        // pos Half3 @ 0, uv UNorm16x2 @ 1. Same source data as Default(), 60% of the size.
+        // Halves hold ~3 significant digits, fine for unit meshes scaled by their transform
+        static VertexLayout Compact();
+
+        const std::vector<Attribute>& attributes() const { return m_attributes; }
+        uint32_t stride() const { return m_stride; }              // Packed bytes per vertex
+        uint32_t sourceFloats() const { return m_sourceFloats; }  // Floats per vertex in Mesh::vertices
+        bool empty() const { return m_attributes.empty(); }
+
+        // Converts count vertices (sourceFloats() each) into count * stride() bytes at dst
+        void pack(const float* src, size_t count, void* dst) const;
+        // Points & enables every attribute at the bound GL_ARRAY_BUFFER (and VAO)
+        void apply() const;
+
+        bool operator==(const VertexLayout& other) const;
+        bool operator!=(const VertexLayout& other) const { return !(*this == other); }
+
+    private:
+        std::vector<Attribute> m_attributes;
+        uint32_t m_stride = 0;
+        uint32_t m_sourceFloats = 0;
+    };
+
+    // Smallest index type able to address vertexCount vertices (16 bit up to 65536)
+    GLenum indexTypeFor(size_t vertexCount);
+    size_t indexTypeSize(GLenum type);
+    // Converts count indices into type at dst (indices must fit, see indexTypeFor())
+    void packIndices(const unsigned int* src, size_t count, GLenum type, void* dst);
+
+    uint16_t floatToHalf(float value);
+}
+
+#endif //DEXIUM_VERTEXLAYOUT_HPP
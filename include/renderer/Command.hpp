@@ -5,6 +5,10 @@
 #ifndef DEXIUM_COMMAND_HPP
 #define DEXIUM_COMMAND_HPP
 
+#include <glm/glm.hpp>
+
+#include <cstdint>
+
 //Forward declares
 namespace Dexium::Core {
     class Mesh;
@@ -20,9 +24,18 @@ namespace Dexium::Renderer {
         Core::Material* material;
         Core::Transform* transform;
 
+        uint64_t sortKey = 0; // Packed key (see SortKey.hpp), built when the command is stored in a pass
+
+        // Drawn with this instead of transform->ModelMatrix() when set (SceneGraph nodes point it at their world matrix)
+        const glm::mat4* world = nullptr;
+
         Command(Core::Mesh* mesh, Core::Material* material, Core::Transform* transform);
+        Command(Core::Mesh* mesh, Core::Material* material, Core::Transform* transform, uint64_t sortKey);
+
+        // The matrix this command is drawn & culled with
+        const glm::mat4& modelMatrix() const;
     };
 
 }
 
-#endif //DEXIUM_COMMAND_HPP
\ No newline at end of file
+#endif //DEXIUM_COMMAND_HPP
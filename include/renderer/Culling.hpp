@@ -0,0 +1,119 @@
+//
+// Created by Dextron12 on 17/10/26.
+//
+
+#ifndef DEXIUM_CULLING_HPP
+#define DEXIUM_CULLING_HPP
+
+#include <renderer/Command.hpp>
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace Dexium::Renderer {
+
+    struct AABB {
+        glm::vec3 min{0.f};
+        glm::vec3 max{0.f};
+
+        bool overlaps(const AABB& other) const {
+            return min.x <= other.max.x && max.x >= other.min.x &&
+                   min.y <= other.max.y && max.y >= other.min.y &&
+                   min.z <= other.max.z && max.z >= other.min.z;
+        }
+    };
+
+    // World space box containing everything projection * view can see (the NDC cube pulled back into the world)
+    AABB computeViewBounds(const glm::mat4& projection, const glm::mat4& view);
+
+    // Conservative world box of a local box under model (rotations grow it, never shrink it)
+    AABB transformBounds(const glm::vec3& localMin, const glm::vec3& localMax, const glm::mat4& model);
+
+    // Drops pass commands whose mesh bounds don't touch the view bounds
+    /*
+     * World boxes are gathered into SoA arrays, then tested 4 at a time (SSE when available, scalar otherwise).
+     * Commands whose Mesh has no bounds always survive. The command order is kept, so it can run before or after sorting.
+     */
+    class CommandCuller {
+    public:
+        // Returns how many commands were dropped
+        size_t cull(std::vector<Command>& commands, const AABB& view);
+
+    private:
+        std::vector<float> m_minX, m_minY, m_minZ;
+        std::vector<float> m_maxX, m_maxY, m_maxZ;
+        std::vector<uint8_t> m_visible;
+    };
+
+    // Buckets static commands into square XY cells, so only the cells around the view are ever looked at
+    /*
+     * For big worlds (tile maps etc) where most of the level is off screen. Items are inserted once with their world bounds
+     * and stay until removed, a query appends the commands in the cells overlapping a box (each item once).
+     * See RenderPass::enableStaticGrid()/storeStatic().
+     */
+    class UniformGrid {
+    public:
+        using Handle = uint32_t;
+        static constexpr Handle InvalidHandle = 0xFFFFFFFFu;
+
+        explicit UniformGrid(float cellSize = 512.f);
+
+        Handle insert(const Command& command, const AABB& worldBounds);
+        // Re-buckets an item that moved, and takes its new sort key (depth is part of it)
+        void update(Handle handle, const AABB& worldBounds, uint64_t sortKey);
+        void remove(Handle handle);
+        void clear();
+
+        // The stored command, or nullptr for a dead handle
+        const Command* get(Handle handle) const {
+            return handle < m_items.size() && m_items[handle].alive ? &m_items[handle].command : nullptr;
+        }
+
+        // Appends every item whose bounds overlap area (cells first, then the exact box test)
+        void query(const AABB& area, std::vector<Command>& out);
+
+        size_t size() const { return m_items.size() - m_freeHandles.size(); }
+        float cellSize() const { return m_cellSize; }
+
+    private:
+        struct CellRange {
+            int x0, y0, x1, y1;
+            bool oversized; // Covers too many cells to bucket, lives in m_oversized instead
+
+            bool operator==(const CellRange& o) const {
+                return oversized == o.oversized && x0 == o.x0 && y0 == o.y0 && x1 == o.x1 && y1 == o.y1;
+            }
+        };
+
+        // Items spanning more cells than this are kept in a plain list that every query walks
+        static constexpr int64_t MaxCellsPerItem = 256;
+
+        struct Item {
+            Command command{nullptr, nullptr, nullptr};
+            AABB bounds;
+            CellRange cells{};
+            uint32_t stamp = 0; // Last query that returned it
+            bool alive = false;
+        };
+
+        CellRange cellsFor(const AABB& bounds) const;
+        static uint64_t cellKey(int x, int y) {
+            return (static_cast<uint64_t>(static_cast<uint32_t>(x)) << 32) | static_cast<uint32_t>(y);
+        }
+
+        void link(Handle handle);
+        void unlink(Handle handle);
+
+        float m_cellSize;
+        std::unordered_map<uint64_t, std::vector<Handle>> m_cells;
+        std::vector<Item> m_items;
+        std::vector<Handle> m_oversized;
+        std::vector<Handle> m_freeHandles;
+        uint32_t m_stamp = 0;
+    };
+}
+
+#endif //DEXIUM_CULLING_HPP
@@ -0,0 +1,117 @@
+//
+// Created by Dextron12 on 17/10/26.
+//
+
+#ifndef DEXIUM_FRAMEPROFILER_HPP
+#define DEXIUM_FRAMEPROFILER_HPP
+
+#include <glad/gl.h>
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Dexium::Renderer {
+
+    // Per-pass GPU & CPU timings for Renderer::flush() (Renderer::getProfiler())
+    /*
+     * GPU: each pass is wrapped in a GL_TIME_ELAPSED query and each frame in a pair of GL_TIMESTAMP queries.
+     * Queries live in a FrameLatency deep ring and are only ever read once GL says they're available, so the CPU never
+     * waits on them. A frame's GPU numbers show up a few frames late (or as -1 if the GPU fell further behind than the ring).
+     *
+     * CPU: flush() is split into sort, bind (shader/texture/uniform setup) & draw phases per pass.
+     *
+     * Off by default, when disabled the renderer only pays for a branch. Poll latest()/summary() each frame, or dumpCSV().
+     */
+    class FrameProfiler {
+    public:
+        using Clock = std::chrono::steady_clock;
+
+        static constexpr size_t FrameLatency = 4;
+
+        enum class Phase { Sort, Bind, Draw };
+
+        struct PassTiming {
+            std::string passName;
+            size_t commands = 0;
+            size_t drawCalls = 0;
+            double cpuSortMs = 0.0;
+            double cpuBindMs = 0.0;
+            double cpuDrawMs = 0.0;
+            double cpuTotalMs = 0.0;
+            double gpuMs = -1.0; // -1 when the query result was never available
+        };
+
+        struct FrameTiming {
+            uint64_t frame = 0;
+            double cpuMs = 0.0; // The whole flush()
+            double gpuMs = -1.0; // First to last GPU timestamp of the flush
+            std::vector<PassTiming> passes;
+        };
+
+        bool enabled = false;
+
+        // Frames kept for latest()/summary()/dumpCSV()
+        size_t historySize = 240;
+
+        // Called by the Renderer
+        void beginFrame();
+        void beginPass(const std::string& passName, size_t commandCount);
+        void endPass();
+        void endFrame();
+
+        // Time point for addPhase(), or a null one when disabled (so callers don't need to check)
+        Clock::time_point stamp() const { return m_active ? Clock::now() : Clock::time_point{}; }
+        // Adds the time since since to the current pass's phase & restarts since
+        void addPhase(Phase phase, Clock::time_point& since);
+        void countDraw() { if (m_active) ++m_current.passes.back().drawCalls; }
+
+        // Most recent frame with its GPU results resolved (nullptr until one is)
+        const FrameTiming* latest() const { return m_history.empty() ? nullptr : &m_history.back(); }
+        const std::deque<FrameTiming>& history() const { return m_history; }
+
+        // Per passName averages over the last frames frames of history
+        std::unordered_map<std::string, PassTiming> summary(size_t frames = 60) const;
+
+        // Writes every frame in history as CSV (one row per pass, plus a "<frame>" row per frame)
+        bool dumpCSV(const std::filesystem::path& path) const;
+
+        // Frees the GL queries (Call before the context is destroyed)
+        void destroy();
+
+    private:
+        struct Slot {
+            bool pending = false;
+            FrameTiming timing;
+            std::vector<GLuint> passQueries; // One per pass, grown as needed
+            GLuint frameStart = 0, frameEnd = 0;
+        };
+
+        // Reads the slot's queries if they're ready (or force discards them), returns true if the slot is free again
+        bool resolve(Slot& slot, bool discardIfNotReady);
+        void pushHistory(FrameTiming&& timing);
+
+        static double msBetween(Clock::time_point a, Clock::time_point b) {
+            return std::chrono::duration<double, std::milli>(b - a).count();
+        }
+
+        bool m_active = false; // enabled, latched at beginFrame()
+        uint64_t m_frame = 0;
+
+        std::array<Slot, FrameLatency> m_slots;
+        Slot* m_slot = nullptr;
+
+        FrameTiming m_current;
+        Clock::time_point m_frameStart;
+        Clock::time_point m_passStart;
+
+        std::deque<FrameTiming> m_history;
+    };
+}
+
+#endif //DEXIUM_FRAMEPROFILER_HPP
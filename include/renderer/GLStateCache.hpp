@@ -0,0 +1,129 @@
+//
+// Created by Dextron12 on 17/10/26.
+//
+
+#ifndef DEXIUM_GLSTATECACHE_HPP
+#define DEXIUM_GLSTATECACHE_HPP
+
+#include <glad/gl.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Dexium::Renderer {
+
+    // Shadows the GL state Dexium touches, and only calls into the driver when a value actually changes
+    /*
+     * Every bit of engine code that binds/enables something (Renderer, Mesh, Texture, Shader, InstanceBuffer...)
+     * goes through here, so the shadow copy stays truthful. If you call GL directly from user code, call invalidate()
+     * afterwards so the next call of each kind is re-issued.
+     *
+     * NOTE: GL_ELEMENT_ARRAY_BUFFER is VAO state (not context state), so it is never cached, bindBuffer() always issues it.
+     */
+    class GLStateCache {
+    public:
+        // One cache per GL context. Dexium only ever creates one context
+        static GLStateCache& get();
+
+        struct Stats {
+            uint64_t issued = 0; // Calls that reached the driver
+            uint64_t elided = 0; // Calls skipped because the state already matched
+        };
+
+        // Capabilities (GL_DEPTH_TEST, GL_BLEND, GL_CULL_FACE, GL_SCISSOR_TEST are cached, anything else passes through)
+        void setCapability(GLenum cap, bool enabled);
+
+        void setDepthFunc(GLenum func);
+        void setDepthMask(bool write);
+        void setBlendFunc(GLenum src, GLenum dst);
+        void setClearColour(float r, float g, float b, float a);
+        void setViewport(int x, int y, int w, int h);
+
+        // Binds to GL_FRAMEBUFFER (both draw & read)
+        void bindFramebuffer(GLuint fbo);
+
+        void useProgram(GLuint program);
+        void bindVertexArray(GLuint vao);
+        void bindBuffer(GLenum target, GLuint buffer);
+        // Indexed binding (GL_UNIFORM_BUFFER only is cached). Like GL, this also changes the generic binding of target
+        void bindBufferBase(GLenum target, GLuint index, GLuint buffer);
+
+        // Binds a texture to the given unit (switches the active unit only if needed)
+        void bindTexture(GLuint unit, GLenum target, GLuint texture);
+        // Binds to whatever unit is currently active (used when uploading texture data)
+        void bindTexture(GLenum target, GLuint texture);
+        void activeTexture(GLuint unit);
+
+        // Drop objects from the shadow state when they're deleted (GL unbinds deleted names, so must we)
+        void forgetBuffer(GLuint buffer);
+        void forgetTexture(GLuint texture);
+        void forgetVertexArray(GLuint vao);
+        void forgetProgram(GLuint program);
+        void forgetFramebuffer(GLuint fbo);
+
+        // Forget everything, the next call of each kind is always issued
+        void invalidate();
+
+        const Stats& stats() const { return m_stats; }
+        void resetStats() { m_stats = {}; }
+
+    private:
+        GLStateCache() = default;
+
+        // Returns true (and counts it) if the call should be issued
+        bool changed(bool same) {
+            if (same) { ++m_stats.elided; return false; }
+            ++m_stats.issued;
+            return true;
+        }
+
+        // Index into m_caps for the cached capabilities, or -1
+        static int capIndex(GLenum cap);
+
+        // Cached values are only trusted once they've been set through the cache
+        enum class Tri : int8_t { Unknown = -1, Off = 0, On = 1 };
+
+        std::array<Tri, 4> m_caps{Tri::Unknown, Tri::Unknown, Tri::Unknown, Tri::Unknown};
+
+        bool m_depthFuncKnown = false;
+        GLenum m_depthFunc = 0;
+        Tri m_depthMask = Tri::Unknown;
+
+        bool m_blendKnown = false;
+        GLenum m_blendSrc = 0, m_blendDst = 0;
+
+        bool m_clearKnown = false;
+        std::array<float, 4> m_clearColour{};
+
+        bool m_viewportKnown = false;
+        std::array<int, 4> m_viewport{};
+
+        static constexpr GLuint Unknown = 0xFFFFFFFFu;
+
+        GLuint m_framebuffer = Unknown;
+        GLuint m_program = Unknown;
+        GLuint m_vao = Unknown;
+
+        // Context level buffer bindings (ARRAY, UNIFORM, DRAW_INDIRECT, PIXEL_UNPACK, COPY_READ, COPY_WRITE)
+        std::array<GLuint, 6> m_buffers{Unknown, Unknown, Unknown, Unknown, Unknown, Unknown};
+        static int bufferIndex(GLenum target);
+
+        static constexpr size_t MaxUniformBindings = 16; // Only the first 16 binding points are shadowed, the rest pass through
+        std::array<GLuint, MaxUniformBindings> m_uniformBindings{};
+        bool m_uniformBindingsKnown = false;
+
+        GLuint m_activeUnit = Unknown;
+
+        struct UnitBinding {
+            GLenum target = 0;
+            GLuint texture = Unknown;
+        };
+        std::vector<UnitBinding> m_units; // Sized lazily from GL_MAX_COMBINED_TEXTURE_IMAGE_UNITS
+
+        Stats m_stats;
+    };
+}
+
+#endif //DEXIUM_GLSTATECACHE_HPP
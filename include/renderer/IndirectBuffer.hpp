@@ -0,0 +1,64 @@
+//
+// Created by Dextron12 on 17/10/26.
+//
+
+#ifndef DEXIUM_INDIRECTBUFFER_HPP
+#define DEXIUM_INDIRECTBUFFER_HPP
+
+#include <glad/gl.h>
+
+#include <cstddef>
+#include <vector>
+
+namespace Dexium::Renderer {
+
+    // Submits a list of indexed draws from one VAO in a single glMultiDrawElementsIndirect (GL 4.3 / ARB_multi_draw_indirect)
+    /*
+     * The commands are built on the CPU, streamed into a GL_DRAW_INDIRECT_BUFFER (orphaned like InstanceBuffer) and
+     * drawn with one call. Without multi-draw indirect the same commands are drawn one by one with
+     * glDrawElementsInstancedBaseVertexBaseInstance instead, still no state changes in between.
+     *
+     * Per-draw data comes from baseInstance: it offsets the divisor-1 attributes, so a draw's instances read their
+     * own slice of the InstanceBuffer.
+     */
+    class IndirectBuffer {
+    public:
+        // Layout fixed by GL
+        struct DrawElementsIndirectCommand {
+            GLuint count;
+            GLuint instanceCount;
+            GLuint firstIndex;
+            GLint baseVertex;
+            GLuint baseInstance;
+        };
+
+        IndirectBuffer() = default;
+
+        // Non-copyable (owns a GL buffer), but movable so the Renderer stays movable
+        IndirectBuffer(const IndirectBuffer&) = delete;
+        IndirectBuffer& operator=(const IndirectBuffer&) = delete;
+        // Moves take the buffer, leaving the source empty
+        IndirectBuffer(IndirectBuffer&& other) noexcept;
+        IndirectBuffer& operator=(IndirectBuffer&& other) noexcept;
+
+        // GL 4.3 / ARB_multi_draw_indirect. Checked once, Dexium only ever creates one context
+        static bool multiDrawSupported();
+        // GL 4.2 / ARB_base_instance. Without it draws can't have per-draw data, so there's no multi-draw path at all
+        static bool baseInstanceSupported();
+
+        // Draws commands from the bound VAO. indexType is GL_UNSIGNED_SHORT or GL_UNSIGNED_INT (shared by every command,
+        // firstIndex counts in it)
+        void draw(GLenum mode, GLenum indexType, const std::vector<DrawElementsIndirectCommand>& commands);
+
+        // Frees the buffer (Call before the context is destroyed). The next draw makes a new one
+        void destroy();
+
+        GLuint id() const { return m_buffer; }
+
+    private:
+        GLuint m_buffer = 0;
+        size_t m_capacity = 0; // In commands
+    };
+}
+
+#endif //DEXIUM_INDIRECTBUFFER_HPP
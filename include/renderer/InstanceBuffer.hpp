@@ -0,0 +1,68 @@
+//
+// Created by Dextron12 on 17/10/26.
+//
+
+#ifndef DEXIUM_INSTANCEBUFFER_HPP
+#define DEXIUM_INSTANCEBUFFER_HPP
+
+#include <glad/gl.h>
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+namespace Dexium::Core {
+    class TransformBuffer;
+}
+
+namespace Dexium::Renderer {
+
+    // A per-instance vertex buffer of model matrices, used to draw runs of identical mesh + material
+    // with a single glDrawElementsInstanced.
+    // The matrix is exposed to the vertex shader as a mat4 attribute, which takes 4 consecutive locations
+    // (location, location+1, location+2, location+3) with a divisor of 1.
+    class InstanceBuffer {
+    public:
+        InstanceBuffer() = default;
+
+        // Non-copyable (owns a GL buffer), but movable so the Renderer stays movable
+        InstanceBuffer(const InstanceBuffer&) = delete;
+        InstanceBuffer& operator=(const InstanceBuffer&) = delete;
+        // Moves take the buffer, leaving the source empty
+        InstanceBuffer(InstanceBuffer&& other) noexcept;
+        InstanceBuffer& operator=(InstanceBuffer&& other) noexcept;
+
+        // Uploads count matrices to the GPU. The old storage is orphaned first, so the driver never has to
+        // wait on a draw that is still reading the previous run.
+        void upload(const glm::mat4* matrices, size_t count);
+
+        // Same, but the matrices are computed straight into the (mapped) buffer, in the TransformBuffer's dense order
+        void upload(const Core::TransformBuffer& transforms);
+
+        // Points the instance attribute of a VAO at this buffer. Only touches GL the first time a VAO & location is seen,
+        // after that the VAO remembers the binding (The buffer name never changes, even when it grows)
+        // NOTE: Leaves the VAO bound
+        void attach(GLuint vao, GLuint location);
+
+        // Drops what attach() remembers about a VAO, for every InstanceBuffer. Call it wherever a VAO is deleted (next to
+        // GLStateCache::forgetVertexArray()), GL hands the name out again & the new VAO would never get its attribute
+        static void forget(GLuint vao);
+
+        // Frees the buffer & drops the VAOs attached to it (Call before the context is destroyed). The next upload makes a new one
+        void destroy();
+
+        GLuint id() const { return m_buffer; }
+        size_t capacity() const { return m_capacity; }
+
+    private:
+        GLuint m_buffer = 0;
+        size_t m_capacity = 0; // In matrices
+
+        std::vector<glm::mat4> m_staging; // Only used if mapping fails
+
+        // Binds, creates & grows the buffer for count matrices, then orphans it
+        void orphan(size_t count);
+    };
+}
+
+#endif //DEXIUM_INSTANCEBUFFER_HPP
@@ -0,0 +1,70 @@
+//
+// Created by Dextron12 on 17/10/26.
+//
+
+#ifndef DEXIUM_RECORDINGGL_HPP
+#define DEXIUM_RECORDINGGL_HPP
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace Dexium::Renderer {
+
+    // A headless "GL driver" that records the call stream instead of drawing anything
+    /*
+     * Every GL call in Dexium already goes through glad's function pointer table, so that table is the backend switch.
+     * install() loads glad with the recorder's functions instead of the real driver's, no window or GPU needed.
+     * From then on Renderer, Mesh, Texture, Shader etc run their normal code paths and every call lands here.
+     *
+     * Object names are handed out from per-kind counters (starting at 1) & uniform locations in first-asked order,
+     * pointers are logged as sizes + content hashes. So the same frame always produces the same text, and a stream
+     * can be dumped & diffed between builds. Set logging = false to only keep the counters (for benchmarking).
+     *
+     * Shaders always compile & link, FBOs are always complete, fences are always signalled & queries read back 0.
+     * Functions the engine doesn't use are left null, so new GL usage crashes loudly until it's added here.
+     * To go back to the real driver, reload glad with the real loader (gladLoaderLoadGL) & GLStateCache::invalidate().
+     */
+    class RecordingGL {
+    public:
+        static RecordingGL& get();
+
+        struct Stats {
+            uint64_t calls = 0;
+            uint64_t drawCalls = 0;
+            uint64_t binds = 0; // Program, VAO, buffer, texture & FBO binds
+            uint64_t uniformUploads = 0;
+            uint64_t bytesUploaded = 0; // Buffer & texture data handed to the "driver"
+        };
+
+        // Points glad at the recorder, reporting GL major.minor (lower it to exercise fallback paths). Returns false if glad failed
+        bool install(int major = 4, int minor = 6);
+        bool installed() const { return m_installed; }
+
+        // Record each call as a line of text. Counters are always kept
+        bool logging = true;
+
+        const std::vector<std::string>& calls() const { return m_calls; }
+        const Stats& stats() const { return m_stats; }
+
+        // Drops the recorded calls & counters (objects stay alive, so names keep counting up)
+        void clear();
+
+        // Writes the call stream, one call per line
+        bool dump(const std::filesystem::path& path) const;
+
+        // Used by the recorder's GL functions
+        void record(std::string call);
+        Stats& counters() { return m_stats; }
+
+    private:
+        RecordingGL() = default;
+
+        bool m_installed = false;
+        std::vector<std::string> m_calls;
+        Stats m_stats;
+    };
+}
+
+#endif //DEXIUM_RECORDINGGL_HPP
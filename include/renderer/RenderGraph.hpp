@@ -0,0 +1,135 @@
+//
+// Created by Dextron12 on 17/10/26.
+//
+
+#ifndef DEXIUM_RENDERGRAPH_HPP
+#define DEXIUM_RENDERGRAPH_HPP
+
+#include <renderer/RenderTarget.hpp>
+
+#include <cstdint>
+#include <initializer_list>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace Dexium::Core {
+    class Texture;
+}
+
+namespace Dexium::Renderer {
+
+    class RenderPass;
+    class Renderer;
+
+    // Schedules a frame's RenderPasses from what they read & write
+    /*
+     * Declare the frame's targets (imported ones like the window's, or transient ones the graph allocates), then add each
+     * pass with the target it draws into & the targets it samples. compile() then:
+     *  - culls passes whose output never reaches a frame output (imported targets are outputs by default)
+     *  - orders the surviving passes (dependencies first), preferring to stay on the current framebuffer
+     *  - allocates transient targets from a pool, transients with the same TargetDesc & non-overlapping lifetimes share
+     *    one FBO. Pooled targets nothing used for keepUnusedFrames compiles are freed
+     *
+     * Since transients may share memory, the first pass writing a transient should clear it (PipelineState::buffers).
+     *
+     * Per frame: reset() -> declare targets & passes -> compile() -> (point materials at getTexture()) -> execute() -> Renderer::flush()
+     */
+    class RenderGraph {
+    public:
+        using Resource = uint32_t;
+        static constexpr Resource InvalidResource = 0xFFFFFFFFu;
+
+        RenderGraph() = default;
+        RenderGraph(const RenderGraph&) = delete;
+        RenderGraph& operator=(const RenderGraph&) = delete;
+
+        // An externally owned target (e.g. the window's). When isOutput, passes writing it are never culled
+        Resource importTarget(RenderTarget* target, std::string_view name = {}, bool isOutput = true);
+
+        // A target owned (and possibly shared) by the graph, only allocated if a surviving pass touches it
+        Resource createTarget(const TargetDesc& desc, std::string_view name = {});
+
+        // Keeps the passes writing this resource alive (e.g. a transient read back by user code)
+        void markOutput(Resource resource);
+
+        // pass draws into output & samples inputs. Passes writing the same target keep their declared order
+        void addPass(RenderPass* pass, Resource output, std::initializer_list<Resource> inputs = {});
+        void addPass(RenderPass* pass, Resource output, const std::vector<Resource>& inputs);
+
+        void compile();
+
+        // Hands the scheduled passes to the renderer (with their physical targets). Culled passes have their commands dropped
+        void execute(Renderer& renderer);
+
+        // The target/colour texture a resource was given by compile(). nullptr if nothing live touches it
+        RenderTarget* getTarget(Resource resource) const;
+        Core::Texture* getTexture(Resource resource) const;
+
+        // Forgets this frame's declarations, the target pool survives
+        void reset();
+
+        // Frees every pooled target (Call before the context is destroyed)
+        void destroy();
+
+        // Passes in execution order (after compile)
+        const std::vector<RenderPass*>& schedule() const { return m_schedule; }
+
+        struct Stats {
+            size_t passesDeclared = 0;
+            size_t passesCulled = 0;
+            size_t framebufferSwitches = 0; // Between consecutive scheduled passes
+            size_t transientTargets = 0; // Live transient resources this frame
+            size_t physicalTargets = 0; // Pooled FBOs backing them
+        };
+        const Stats& stats() const { return m_stats; }
+
+        size_t keepUnusedFrames = 3;
+
+    private:
+        struct ResourceNode {
+            std::string name;
+            TargetDesc desc;
+            RenderTarget* imported = nullptr;
+            bool isOutput = false;
+
+            RenderTarget* physical = nullptr; // Resolved by compile()
+        };
+
+        struct PassNode {
+            RenderPass* pass;
+            Resource output;
+            std::vector<Resource> inputs;
+            std::vector<uint32_t> dependsOn; // Earlier passes producing what this one reads/draws over (keeps them alive)
+            std::vector<uint32_t> after; // Earlier passes reading what this one overwrites (ordering only)
+            bool alive = false;
+        };
+
+        struct PooledTarget {
+            std::unique_ptr<RenderTarget> target;
+            size_t busyUntil = 0; // Last schedule slot using it this frame (+1)
+            size_t unusedFrames = 0;
+            bool usedThisFrame = false;
+        };
+
+        bool validResource(Resource resource) const;
+
+        void buildDependencies();
+        void cull();
+        void order();
+        void allocate();
+
+        std::vector<ResourceNode> m_resources;
+        std::vector<PassNode> m_passes;
+
+        std::vector<RenderPass*> m_schedule;
+        std::vector<uint32_t> m_scheduleNodes; // Index into m_passes per schedule slot
+
+        std::vector<PooledTarget> m_pool;
+
+        Stats m_stats;
+    };
+}
+
+#endif //DEXIUM_RENDERGRAPH_HPP
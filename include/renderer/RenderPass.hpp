@@ -8,10 +8,18 @@
 #include <utils/BitwiseFlag.hpp>
 
 #include <core/Colour.h>
+#include <core/SceneGraph.hpp>
 
 #include <glad/gl.h>
 
 #include <renderer/Command.hpp>
+#include <renderer/Culling.hpp>
+#include <renderer/SortKey.hpp>
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
 
 // forward declares
 namespace Dexium::Core {
@@ -19,6 +27,7 @@ namespace Dexium::Core {
     class Mesh;
     class Material;
     class Transform;
+    class SpriteBatch;
 
 }
 namespace Dexium::Renderer{
@@ -58,6 +67,22 @@ namespace Dexium::Renderer {
         bool DepthWrite = true; // Decides if its depth result effects future fragments
         bool blending = false;
 
+        // Draws runs of commands sharing the same Mesh & Material with one glDrawElementsInstanced.
+        // The pass's shaders must read the model matrix from a mat4 attribute at instanceAttrib (see SHADER_2D_INSTANCED_VERTEX)
+        // instead of the Model_uName uniform. So every command in the pass is drawn instanced, even runs of one
+        bool instancing = false;
+        GLuint instanceAttrib = 2; // First of the 4 locations used by the per-instance mat4
+
+        // Draws runs of commands sharing the same Material & VAO (e.g. meshes from one GeometryArena page) with one
+        // glMultiDrawElementsIndirect (see IndirectBuffer.hpp). Uses the same shaders as instancing (and implies it),
+        // each draw's model matrix is picked out of the instance buffer by its base instance.
+        // Needs GL 4.2+ (base instance), otherwise the pass just draws instanced
+        bool multiDraw = false;
+
+        // Drops commands whose Mesh bounds fall outside the camera's view before sorting/drawing (see Culling.hpp)
+        // Off by default, as it assumes the pass's shaders transform by Projection * View * Model like the built-in ones
+        bool culling = false;
+
         std::string Projection_uName; // The uniform name for the Projection(mat4) in the shader program
         std::string View_uName; // The uniform name for the View(mat4) in the shader program
         std::string Model_uName; // The uniform name for Model(mat4) in the shader program
@@ -71,6 +96,12 @@ namespace Dexium::Renderer {
 
         Utils::BufferTarget buffers = Utils::BufferTarget::None;
         Colour passColor = {0,0,0,0};
+
+        // Which SortKey layout the pass's commands are keyed with
+        SortKey::Order sortOrder() const {
+            if (blending) return SortKey::Order::Transparent;
+            return instancing || multiDraw ? SortKey::Order::Batched : SortKey::Order::Opaque;
+        }
     };
 
 
@@ -82,6 +113,55 @@ namespace Dexium::Renderer {
 
         void storeCommand(Core::Mesh* mesh, Core::Material* material, Core::Transform* transform);
         void storeCommand(const Command& cmd);
+        // Stores every node in node's subtree that has a mesh & material, drawn with its world matrix from the last
+        // graph.update(). The commands point into the graph, so leave its structure alone until this pass is flushed
+        void storeCommand(Core::SceneGraph& graph, Core::SceneGraph::Node node);
+
+        // Records commands into the calling thread's own chunk of this pass (no locking per command)
+        /*
+         * storeCommand() is single threaded. For worker threads, grab a Recorder on the thread that'll use it
+         * and record through that instead. Each thread gets its own chunk (registered once, under a lock), chunks are
+         * merged with their sort keys when the Renderer flushes the pass.
+         *
+         * A Recorder must only be used by the thread that created it, and all recording must be finished (joined)
+         * before Renderer::flush() is called.
+         */
+        class Recorder {
+        public:
+            void storeCommand(Core::Mesh* mesh, Core::Material* material, Core::Transform* transform);
+            void storeCommand(const Command& cmd);
+
+            // Commands recorded by this thread (since the last flush)
+            size_t size() const { return m_chunk->size(); }
+
+        private:
+            friend RenderPass;
+            Recorder(std::vector<Command>* chunk, std::atomic<uint64_t>* rejected, SortKey::Order order)
+                : m_chunk(chunk), m_rejected(rejected), m_order(order) {}
+
+            std::vector<Command>* m_chunk;
+            std::atomic<uint64_t>* m_rejected; // The pass's count of invalid commands, logged by mergeRecorded()
+            SortKey::Order m_order;
+        };
+
+        // Returns the calling thread's Recorder for this pass. Cheap after the thread's first call
+        Recorder recorder();
+
+        // Queues a SpriteBatch to be drawn (after the pass's commands) with this pass's camera
+        // The batch renders its own shader, so the pass's uniform names don't apply to it
+        void storeBatch(Core::SpriteBatch* batch);
+
+        // Static commands: stored once into a spatial grid, and every frame only the ones near the camera are drawn
+        /*
+         * Meant for big mostly-static worlds (tile maps, level geometry) where re-storing thousands of commands a frame
+         * just to cull most of them is wasted work. They persist across clearCommands(), remove them yourself.
+         * The grid is made on the first storeStatic() if enableStaticGrid() wasn't called. cellSize is in world units.
+         */
+        void enableStaticGrid(float cellSize = 512.f);
+        UniformGrid::Handle storeStatic(Core::Mesh* mesh, Core::Material* material, Core::Transform* transform);
+        // Re-buckets (and re-keys) a static command after its Transform moved
+        void updateStatic(UniformGrid::Handle handle);
+        void removeStatic(UniformGrid::Handle handle);
 
         void clearCommands();
 
@@ -93,12 +173,30 @@ namespace Dexium::Renderer {
 
     protected:
         std::vector<Command> m_commands;
+        std::vector<Core::SpriteBatch*> m_batches;
+
+        // Per-thread chunks handed out by recorder(). Boxed so the pass stays movable
+        struct ThreadChunks {
+            uint64_t id; // Unique per pass, so a thread's cached chunk can't outlive a destroyed pass's address
+            std::mutex mutex; // Only taken when a new thread registers & when merging
+            std::vector<std::unique_ptr<std::vector<Command>>> chunks;
+            std::atomic<uint64_t> rejected{0}; // Commands the Recorders dropped since the last merge
+
+            ThreadChunks();
+        };
+        std::unique_ptr<ThreadChunks> m_threadChunks = std::make_unique<ThreadChunks>();
+
+        // Appends every thread's recorded commands to m_commands (Called by the Renderer before sorting)
+        void mergeRecorded();
+
+        std::unique_ptr<UniformGrid> m_staticGrid; // Null until static commands are used
 
         RenderTarget* renderTarget = nullptr; // Accessor to VP data and future FBO target
         Core::baseCamera* camera = nullptr; // Accessor to camera View and Proj matrices
 
 
         friend Renderer; // Allow Renderer to access protected vars
+        friend class RenderGraph; // Points passes at the targets it allocates
         // RenderPass ultimately stores such data as protected to prevent end-user modifying state
 
 
@@ -7,20 +7,68 @@
 
 #include <renderer/viewport.hpp>
 
+#include <core/Texture.hpp>
+
+#include <glad/gl.h>
+
 namespace Dexium::Renderer {
 
-    // Eventually plan to add FBOs
+    // Describes the attachments of an offscreen (FBO backed) RenderTarget
+    struct TargetDesc {
+        int width = 0;
+        int height = 0;
+        bool colour = true; // Sampleable colour texture (COLOR_ATTACHMENT0)
+        bool depth = true; // Depth/stencil renderbuffer (not sampleable)
+        GLenum colourFormat = GL_RGBA8; // Internal format of the colour texture
+
+        bool operator==(const TargetDesc& other) const {
+            return width == other.width && height == other.height && colour == other.colour &&
+                depth == other.depth && colourFormat == other.colourFormat;
+        }
+        bool operator!=(const TargetDesc& other) const { return !(*this == other); }
+    };
+
+    // Where a RenderPass draws to. Either the window's default framebuffer (fbo 0) or an offscreen FBO
     class RenderTarget {
     public:
         RenderTarget() = delete;
         RenderTarget(const RenderTarget&) = delete;
 
         //Takes ownership of the viewport, suggest you create the viewport within the param args
+        // Targets the default framebuffer
         explicit RenderTarget(const Viewport&& vp)
             : m_viewport(std::move(vp)) {}
 
+        // Creates an offscreen target with its own FBO & attachments (Needs a live context)
+        explicit RenderTarget(const TargetDesc& desc);
+
+        // Like Mesh & Texture, the GL objects are NOT freed by the dtor (the context may already be gone), call destroy()
+        ~RenderTarget() = default;
+
+        // Frees the FBO & its attachments. The target falls back to the default framebuffer
+        void destroy();
+
+        // Recreates the attachments at the new size (offscreen targets only, the window resizes its own)
+        void resize(int width, int height);
+
+        bool isOffscreen() const { return m_fbo != 0; }
+        GLuint fbo() const { return m_fbo; }
+        const TargetDesc& desc() const { return m_desc; }
+
+        // The colour attachment, for sampling in later passes (nullptr for the default framebuffer or depth only targets)
+        Core::Texture* colourTexture() { return m_colour.texID != 0 ? &m_colour : nullptr; }
+
         Viewport m_viewport;
+
+    private:
+        void createAttachments();
+
+        TargetDesc m_desc;
+
+        GLuint m_fbo = 0;
+        GLuint m_depthRBO = 0;
+        Core::Texture m_colour; // Observed by materials, owned here
     };
 }
 
-#endif //DEXIUM_RENDERTARGET_HPP
\ No newline at end of file
+#endif //DEXIUM_RENDERTARGET_HPP
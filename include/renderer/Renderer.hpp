@@ -6,9 +6,15 @@
 #define DEXIUM_RENDERER_HPP
 
 #include <core/Colour.h>
+#include <core/Shader.hpp>
 #include <utils/BitwiseFlag.hpp>
 
 #include <renderer/RenderTarget.hpp>
+#include <renderer/SortKey.hpp>
+#include <renderer/InstanceBuffer.hpp>
+#include <renderer/IndirectBuffer.hpp>
+#include <renderer/FrameProfiler.hpp>
+#include <renderer/Culling.hpp>
 
 #include "glad/gl.h"
 
@@ -77,20 +83,28 @@ namespace Dexium::Renderer {
         // Updates the renderer (Call this ONCE at the end of each render frame)
         void flush();
 
+        // Access to the pass command sorter (threading thresholds etc)
+        CommandSorter& getCommandSorter() { return m_sorter; }
+
+        // Per-pass GPU/CPU timings of flush() (set enabled to start collecting)
+        FrameProfiler& getProfiler() { return m_profiler; }
+
+        // Frees the renderer's own GL buffers (Call before the context is destroyed)
+        void destroy();
+
     private:
 
         //Store the MAX supported texture units (Polled at Renderer ctor)
         int m_maxTextureSlots;
         int m_nextTextureSlot = 1; // Leave TEXTURE0 for fallack/default texture
-        std::vector<Core::Texture*> m_boundTextures; // Determiens What is CURRENTLY bound to slot N
         std::unordered_map<Core::Texture*, int> m_batchLookup; // Storres the lookups of textures (Stored per batch/drawCall)
 
-        //Store active viewport
-        Dexium::Renderer::Viewport m_activeViewport = {};
         // Store active camera
         Dexium::Core::baseCamera* m_activeCamera = nullptr;
-        //Store active shader
-        int m_activeShader = 0;
+        //Store the shader that has this pass's Projection & View uploaded (The GLStateCache tracks what is actually bound)
+        unsigned int m_activeShader = 0;
+        // The active shader's model uniform (PipelineState::Model_uName), resolved when the shader is bound
+        Core::Shader::UniformHandle<glm::mat4> m_modelUniform;
         // Store active material
         Dexium::Core::Material* m_activeMaterial = nullptr;
         //Store next texture slot
@@ -98,6 +112,22 @@ namespace Dexium::Renderer {
 
         //Store vec of passes. Cleared at end of Renderer::flush
         std::vector<RenderPass*> m_renderPasses;
+
+        // Radix sorts each pass by its commands sort keys
+        CommandSorter m_sorter;
+
+        FrameProfiler m_profiler;
+
+        // Per-pass view culling (PipelineState::culling), keeps its scratch arrays between passes
+        CommandCuller m_culler;
+
+        // Per-instance model matrices for passes with PipelineState::instancing enabled
+        InstanceBuffer m_instances;
+        std::vector<glm::mat4> m_instanceData; // CPU staging, reused between runs
+
+        // Per-run draw lists for passes with PipelineState::multiDraw enabled
+        IndirectBuffer m_indirect;
+        std::vector<IndirectBuffer::DrawElementsIndirectCommand> m_indirectData;
     };
 
 
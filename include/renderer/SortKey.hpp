@@ -0,0 +1,130 @@
+//
+// Created by Dextron12 on 17/10/26.
+//
+
+#ifndef DEXIUM_SORTKEY_HPP
+#define DEXIUM_SORTKEY_HPP
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include <renderer/Command.hpp>
+
+// Packed 64-bit sort keys for RenderPass commands
+/*
+ * Every command gets a single integer key when it's stored in a pass, so the Renderer can sort
+ * by comparing integers instead of chasing material->shader & transform->position on every comparison.
+ *
+ * Layout (MSB -> LSB):
+ *  Opaque      | shader(12) | material(16) | textures(12) | depth(24) |
+ *  Batched     | shader(12) | material(16) | textures(12) | mesh(16) | depth(8) |
+ *  Transparent | shader(12) | depth(24)    | material(16) | textures(12) |
+ *
+ * Transparent passes need correct back-to-front ordering, so depth outranks material there.
+ * Opaque passes only care about state changes, depth is just used to draw front-to-back (less overdraw)
+ * Batched is the opaque layout for instancing/multiDraw passes. The Renderer merges adjacent commands sharing a mesh
+ * (or a VAO), so those have to sort next to each other ahead of depth, which drops to a rough 8 bits.
+ * The mesh field is the VAO over the mesh's sortID, so an arena page's meshes stay together for multi-draw too
+ */
+
+namespace Dexium::Core {
+    class Mesh;
+    class Material;
+    class Transform;
+}
+
+namespace Dexium::Renderer::SortKey {
+
+    constexpr uint32_t ShaderBits = 12;
+    constexpr uint32_t MaterialBits = 16;
+    constexpr uint32_t TextureBits = 12;
+    constexpr uint32_t DepthBits = 24;
+
+    // Batched only
+    constexpr uint32_t MeshVAOBits = 6;
+    constexpr uint32_t MeshIDBits = 10;
+    constexpr uint32_t MeshBits = MeshVAOBits + MeshIDBits;
+    constexpr uint32_t BatchedDepthBits = 8;
+
+    static_assert(ShaderBits + MaterialBits + TextureBits + DepthBits == 64, "SortKey fields must fill exactly 64 bits");
+    static_assert(ShaderBits + MaterialBits + TextureBits + MeshBits + BatchedDepthBits == 64, "Batched SortKey fields must fill exactly 64 bits");
+
+    enum class Order : uint8_t {
+        Opaque,
+        Batched,    // Opaque, for passes drawing runs (PipelineState::instancing/multiDraw)
+        Transparent // PipelineState::blending
+    };
+
+    constexpr uint64_t mask(uint32_t bits) { return (uint64_t(1) << bits) - 1; }
+
+    // Maps a float onto an unsigned int with the same ordering (handles negatives), then keeps the top DepthBits
+    inline uint32_t quantizeDepth(float z) {
+        uint32_t bits;
+        std::memcpy(&bits, &z, sizeof(bits));
+        // Negative floats have their order reversed, so flip every bit. Positives just get the sign bit set
+        bits = (bits & 0x80000000u) ? ~bits : (bits | 0x80000000u);
+        return bits >> (32 - DepthBits);
+    }
+
+    // Builds the key from already compacted ids. Any id wider than its field is masked (so collisions only cost a state change, never correctness)
+    // Depth ordering matches the old comparator: a larger z is treated as further back. mesh is only used by Order::Batched
+    inline uint64_t build(uint32_t shader, uint32_t material, uint32_t textureSet, uint32_t mesh, float z, Order order) {
+        const uint64_t s = shader & mask(ShaderBits);
+        const uint64_t m = material & mask(MaterialBits);
+        const uint64_t t = textureSet & mask(TextureBits);
+        uint64_t d = quantizeDepth(z);
+
+        if (order == Order::Transparent) {
+            // Back to front -> larger z first, so invert depth
+            d = ~d & mask(DepthBits);
+            return (s << (DepthBits + MaterialBits + TextureBits)) | (d << (MaterialBits + TextureBits)) | (m << TextureBits) | t;
+        }
+
+        if (order == Order::Batched) {
+            const uint64_t b = mesh & mask(MeshBits);
+            d >>= DepthBits - BatchedDepthBits;
+            return (s << (MaterialBits + TextureBits + MeshBits + BatchedDepthBits)) | (m << (TextureBits + MeshBits + BatchedDepthBits)) |
+                   (t << (MeshBits + BatchedDepthBits)) | (b << BatchedDepthBits) | d;
+        }
+
+        // Front to back -> smaller z first
+        return (s << (MaterialBits + TextureBits + DepthBits)) | (m << (TextureBits + DepthBits)) | (t << DepthBits) | d;
+    }
+
+    // The mesh field: low VAO bits over the low sortID bits
+    uint32_t meshID(const Core::Mesh& mesh);
+
+    // Builds the key for a command from its mesh, material & transform. Expects the material to hold a valid shader
+    uint64_t build(const Core::Mesh& mesh, const Core::Material& material, const Core::Transform& transform, Order order);
+}
+
+namespace Dexium::Renderer {
+
+    // LSD radix sorter for pass commands. Owned by the Renderer so its scratch buffers survive between frames
+    class CommandSorter {
+    public:
+        // Passes with at least this many commands are split across threads (0 disables threading)
+        size_t parallelThreshold = 32768;
+        // Max worker threads used for a single pass (0 = std::thread::hardware_concurrency)
+        unsigned maxThreads = 0;
+
+        // Stable sort of commands by Command::sortKey (ascending)
+        void sort(std::vector<Command>& commands);
+
+    private:
+        struct KeyIndex {
+            uint64_t key;
+            uint32_t index;
+        };
+
+        // Radix sorts [first, first+count) of data, using scratch as the ping-pong buffer. Result always ends up in data
+        static void radixSort(KeyIndex* data, KeyIndex* scratch, size_t count);
+
+        std::vector<KeyIndex> m_keys;
+        std::vector<KeyIndex> m_keyScratch;
+        std::vector<Command> m_cmdScratch;
+    };
+}
+
+#endif //DEXIUM_SORTKEY_HPP
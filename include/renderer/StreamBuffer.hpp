@@ -0,0 +1,78 @@
+//
+// Created by Dextron12 on 17/10/26.
+//
+
+#ifndef DEXIUM_STREAMBUFFER_HPP
+#define DEXIUM_STREAMBUFFER_HPP
+
+#include <glad/gl.h>
+
+#include <array>
+#include <cstddef>
+#include <vector>
+
+namespace Dexium::Renderer {
+
+    // A ring of N regions inside one GL buffer, for data the CPU rewrites every frame (sprite vertices etc)
+    /*
+     * With GL 4.4 (buffer storage) the whole ring is persistently mapped once, and each region is guarded
+     * by a fence, so we only ever wait if the GPU is still reading a region we're about to overwrite (3 regions back).
+     * Without it, we fall back to orphaning: each region write calls glBufferData(nullptr) + glBufferSubData, which
+     * lets the driver hand us fresh storage instead of syncing.
+     *
+     * Usage per chunk of data:
+     *   void* dst = stream.beginRegion();
+     *   ... write up to regionSize() bytes ...
+     *   stream.endRegion(bytesWritten);
+     *   ... draw using offset stream.regionOffset() ...
+     *   stream.fence();
+     */
+    class StreamBuffer {
+    public:
+        static constexpr int RegionCount = 3; // Triple buffered
+
+        StreamBuffer() = default;
+
+        StreamBuffer(const StreamBuffer&) = delete;
+        StreamBuffer& operator=(const StreamBuffer&) = delete;
+        // Moves take the buffer, the mapping & the fences, leaving the source empty
+        StreamBuffer(StreamBuffer&& other) noexcept;
+        StreamBuffer& operator=(StreamBuffer&& other) noexcept;
+
+        // Allocates the buffer. target is usually GL_ARRAY_BUFFER. forceOrphaning skips persistent mapping even if supported
+        void create(GLenum target, size_t regionSize, bool forceOrphaning = false);
+
+        // Unmaps & frees the buffer and its fences (Call before the context is destroyed). create() can be called again after
+        void destroy();
+
+        // Returns a write ptr to the next region (waits on its fence first if needed)
+        void* beginRegion();
+        // Makes the written bytes visible to GL (a no-op for coherent persistent mappings)
+        void endRegion(size_t bytesWritten);
+        // Fences the current region, call this after the draws reading from it were issued
+        void fence();
+
+        // Byte offset of the current region within the GL buffer (use as the attrib/draw offset)
+        size_t regionOffset() const;
+        size_t regionSize() const { return m_regionSize; }
+
+        GLuint id() const { return m_buffer; }
+        bool isPersistent() const { return m_mapped != nullptr; }
+        bool isValid() const { return m_buffer != 0; }
+
+    private:
+        GLuint m_buffer = 0;
+        GLenum m_target = GL_ARRAY_BUFFER;
+        size_t m_regionSize = 0;
+        int m_region = RegionCount - 1; // beginRegion advances first, so the first region used is 0
+
+        // Persistent path
+        unsigned char* m_mapped = nullptr;
+        std::array<GLsync, RegionCount> m_fences{};
+
+        // Orphaning path, CPU side staging
+        std::vector<unsigned char> m_staging;
+    };
+}
+
+#endif //DEXIUM_STREAMBUFFER_HPP
@@ -0,0 +1,73 @@
+//
+// Created by Dextron12 on 17/10/26.
+//
+
+#ifndef DEXIUM_UNIFORMBLOCKS_HPP
+#define DEXIUM_UNIFORMBLOCKS_HPP
+
+#include <glad/gl.h>
+
+#include <glm/glm.hpp>
+
+// Engine owned uniform blocks (UBOs) & the fixed binding points they live on
+/*
+ * Shader::compile() looks for each of these block names in a linked program and binds it to its fixed binding point,
+ * so every program reads the same buffer without the Renderer touching per-program uniforms.
+ *
+ * GLSL side (instance name left off, so members are used like normal uniforms):
+ *   layout (std140) uniform CameraBlock {
+ *       mat4 u_Projection;
+ *       mat4 u_View;
+ *   };
+ *
+ * MaterialBlock has no fixed members. Shader::compile() reflects whatever the program declares & each Material packs its
+ * uniforms into that layout (see Material::applyBlock()), so a material switch is one buffer bind:
+ *   layout (std140) uniform MaterialBlock {
+ *       vec4 uColor;
+ *       vec4 uvRect;
+ *   };
+ */
+
+namespace Dexium::Renderer::UniformBlocks {
+
+    struct BlockBinding {
+        const char* name;
+        GLuint binding;
+    };
+
+    constexpr BlockBinding Camera = {"CameraBlock", 0};
+    constexpr BlockBinding Material = {"MaterialBlock", 1};
+
+    // Every block Shader::compile() will try to bind
+    constexpr BlockBinding All[] = {Camera, Material};
+}
+
+namespace Dexium::Renderer {
+
+    // The std140 CameraBlock. Written once per pass (and skipped entirely if the matrices haven't changed)
+    class CameraUniformBuffer {
+    public:
+        // One per GL context, shared by every program
+        static CameraUniformBuffer& get();
+
+        // Uploads the matrices if they differ from what the buffer already holds. Also (re)binds it to its binding point
+        void update(const glm::mat4& projection, const glm::mat4& view);
+
+        GLuint id() const { return m_buffer; }
+
+    private:
+        CameraUniformBuffer() = default;
+
+        // std140: mat4 is 4 vec4 columns, so this matches the GLSL block byte for byte
+        struct Data {
+            glm::mat4 projection;
+            glm::mat4 view;
+        };
+
+        GLuint m_buffer = 0;
+        Data m_data{};
+        bool m_hasData = false;
+    };
+}
+
+#endif //DEXIUM_UNIFORMBLOCKS_HPP
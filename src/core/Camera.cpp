@@ -56,8 +56,24 @@ namespace Dexium::Core {
     void Camera2D::update() {
         // Update View from Transform data
         // View matrix is the inverse of the camera positon!!
-        viewMatrix = glm::inverse(transform.ModelMatrix());
+        const glm::mat4& model = transform.ModelMatrix();
+        if (transform.generation() == m_viewGeneration) return; // Camera hasn't moved
+
+        // model is translate * rotate * scale, so its inverse is (1/scale) * transpose(rotate) * -translate.
+        // Column i of model is rotation axis i times scale i, which gives the 3x3 part without a general inverse
+        glm::mat4 view(1.f);
+        for (int i = 0; i < 3; ++i) {
+            const glm::vec3 axis(model[i]);
+            const float lengthSq = glm::dot(axis, axis);
+            const glm::vec3 row = lengthSq > 0.f ? axis / lengthSq : glm::vec3(0.f); // A 0 scale has no inverse, collapse it
+            view[0][i] = row.x;
+            view[1][i] = row.y;
+            view[2][i] = row.z;
+        }
+        view[3] = glm::vec4(-(glm::mat3(view) * glm::vec3(model[3])), 1.f);
 
+        viewMatrix = view;
+        m_viewGeneration = transform.generation();
     }
 
     const glm::mat4& Camera2D::getProjectionMatrix(const Renderer::Viewport& vp) {
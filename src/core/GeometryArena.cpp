@@ -0,0 +1,245 @@
+//
+// Created by Dextron12 on 17/10/26.
+//
+
+#include <core/GeometryArena.hpp>
+#include <core/MeshOptimizer.hpp>
+#include <core/Error.hpp>
+
+#include <renderer/GLStateCache.hpp>
+#include <renderer/InstanceBuffer.hpp>
+
+#include <algorithm>
+
+namespace Dexium::Core {
+
+    GeometryArena::GeometryArena(size_t verticesPerPage, size_t indicesPerPage, VertexLayout layout)
+        : m_verticesPerPage(verticesPerPage > 0 ? verticesPerPage : 1), m_indicesPerPage(indicesPerPage > 0 ? indicesPerPage : 1),
+          m_layout(layout.empty() ? VertexLayout::Default() : std::move(layout)) {}
+
+    GeometryArena::~GeometryArena() {
+        unlinkAll();
+    }
+
+    std::unique_ptr<Mesh> GeometryArena::createMesh(Mesh::_MeshType type) {
+        auto mesh = std::make_unique<Mesh>();
+        std::visit([&mesh](auto value) { mesh->generateMesh(value); }, type);
+
+        if (!add(*mesh)) return nullptr;
+        return mesh;
+    }
+
+    bool GeometryArena::add(Mesh& mesh) {
+        if (contains(mesh)) {
+            TraceLog(LogLevel::WARNING, "[GeometryArena]: Mesh is already in the arena");
+            return false;
+        }
+        if (mesh.m_arena.arena) {
+            TraceLog(LogLevel::WARNING, "[GeometryArena]: Mesh is in another arena, remove() it from that one first");
+            return false;
+        }
+        if (mesh.vertices.empty() || mesh.vertexCount <= 0) {
+            TraceLog(LogLevel::ERROR, "[GeometryArena]: No vertices provided, cannot add the mesh");
+            return false;
+        }
+        if (mesh.optimize) MeshOptimizer::optimize(mesh); // Can drop vertices, so before anything is sized
+
+        const auto vertexCount = static_cast<size_t>(mesh.vertexCount);
+        const auto indexCount = static_cast<size_t>(std::max(mesh.indexCount, 0));
+        if (mesh.vertices.size() != vertexCount * m_layout.sourceFloats() || mesh.indices.size() < indexCount) {
+            TraceLog(LogLevel::ERROR, "[GeometryArena]: Mesh data doesn't match the arena's vertex layout ({} floats for {} vertices, expected {} per vertex)",
+                mesh.vertices.size(), vertexCount, m_layout.sourceFloats());
+            return false;
+        }
+
+        // Indices are relative to the mesh, so it's the mesh's vertex count that decides if 16 bits are enough
+        const GLenum indexType = indexTypeFor(vertexCount);
+
+        // First page with room for both, else a new one
+        Allocation alloc{SIZE_MAX, {SIZE_MAX, vertexCount}, {0, indexCount}};
+        for (size_t p = 0; p < m_pages.size() && alloc.page == SIZE_MAX; ++p) {
+            Page& page = m_pages[p];
+            if (indexType == GL_UNSIGNED_INT && page.indexType == GL_UNSIGNED_SHORT) continue;
+
+            alloc.vertices.offset = allocate(page.freeVertices, vertexCount);
+            if (alloc.vertices.offset == SIZE_MAX) continue;
+
+            if (indexCount > 0) {
+                alloc.indices.offset = allocate(page.freeIndices, indexCount);
+                if (alloc.indices.offset == SIZE_MAX) {
+                    release(page.freeVertices, alloc.vertices);
+                    continue;
+                }
+            }
+            alloc.page = p;
+        }
+        if (alloc.page == SIZE_MAX) {
+            createPage(std::max(m_verticesPerPage, vertexCount), std::max(m_indicesPerPage, indexCount), indexType);
+            alloc.page = m_pages.size() - 1;
+            alloc.vertices.offset = allocate(m_pages.back().freeVertices, vertexCount);
+            if (indexCount > 0) alloc.indices.offset = allocate(m_pages.back().freeIndices, indexCount);
+        }
+
+        const Page& page = m_pages[alloc.page];
+        const size_t stride = m_layout.stride();
+        const size_t indexSize = indexTypeSize(page.indexType);
+
+        auto& gl = Renderer::GLStateCache::get();
+        gl.bindVertexArray(page.VAO); // The page's EBO is VAO state
+
+        std::vector<unsigned char> packed(vertexCount * stride);
+        m_layout.pack(mesh.vertices.data(), vertexCount, packed.data());
+        gl.bindBuffer(GL_ARRAY_BUFFER, page.VBO);
+        glBufferSubData(GL_ARRAY_BUFFER, static_cast<GLintptr>(alloc.vertices.offset * stride),
+                        static_cast<GLsizeiptr>(packed.size()), packed.data());
+
+        if (indexCount > 0) {
+            // Indices stay relative to the mesh, the draw adds baseVertex
+            packed.resize(indexCount * indexSize);
+            packIndices(mesh.indices.data(), indexCount, page.indexType, packed.data());
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, page.EBO);
+            glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, static_cast<GLintptr>(alloc.indices.offset * indexSize),
+                            static_cast<GLsizeiptr>(packed.size()), packed.data());
+        }
+
+        gl.bindBuffer(GL_ARRAY_BUFFER, 0);
+        gl.bindVertexArray(0);
+
+        mesh.VAO = page.VAO;
+        mesh.VBO = page.VBO;
+        mesh.EBO = indexCount > 0 ? page.EBO : 0;
+        mesh.baseVertex = static_cast<GLint>(alloc.vertices.offset);
+        mesh.firstIndex = static_cast<GLuint>(alloc.indices.offset);
+        mesh.layout = m_layout;
+        mesh.indexType = page.indexType;
+        mesh.m_inArena = true;
+        mesh.computeBounds();
+
+        alloc.link = &mesh.m_arena;
+        const uint32_t handle = m_nextHandle++;
+        m_allocations.emplace(handle, alloc);
+        mesh.m_arena.arena = this;
+        mesh.m_arena.handle = handle;
+        return true;
+    }
+
+    void GeometryArena::remove(Mesh& mesh) {
+        if (!contains(mesh)) {
+            TraceLog(LogLevel::WARNING, "[GeometryArena]: Removing a mesh that isn't in the arena");
+            return;
+        }
+
+        mesh.m_arena.release();
+
+        mesh.VAO = mesh.VBO = mesh.EBO = 0;
+        mesh.baseVertex = 0;
+        mesh.firstIndex = 0;
+        mesh.m_inArena = false;
+    }
+
+    void GeometryArena::destroy() {
+        auto& gl = Renderer::GLStateCache::get();
+        for (auto& page : m_pages) {
+            glDeleteVertexArrays(1, &page.VAO);
+            gl.forgetVertexArray(page.VAO);
+            Renderer::InstanceBuffer::forget(page.VAO);
+            glDeleteBuffers(1, &page.VBO);
+            gl.forgetBuffer(page.VBO);
+            glDeleteBuffers(1, &page.EBO);
+            gl.forgetBuffer(page.EBO);
+        }
+        m_pages.clear();
+        unlinkAll(); // Any meshes still pointing in here are stale now
+    }
+
+    void GeometryArena::freeAllocation(uint32_t handle) {
+        auto it = m_allocations.find(handle);
+        if (it == m_allocations.end()) return;
+
+        const Allocation& alloc = it->second;
+        Page& page = m_pages[alloc.page];
+        release(page.freeVertices, alloc.vertices);
+        if (alloc.indices.count > 0) release(page.freeIndices, alloc.indices);
+        m_allocations.erase(it);
+    }
+
+    void GeometryArena::relink(uint32_t handle, Mesh::ArenaLink* link) {
+        auto it = m_allocations.find(handle);
+        if (it != m_allocations.end()) it->second.link = link;
+    }
+
+    void GeometryArena::unlinkAll() {
+        for (auto& entry : m_allocations) {
+            entry.second.link->arena = nullptr;
+            entry.second.link->handle = 0;
+        }
+        m_allocations.clear();
+    }
+
+    GeometryArena::Page& GeometryArena::createPage(size_t vertices, size_t indices, GLenum indexType) {
+        Page page;
+        page.indexType = indexType;
+        page.vertexCapacity = vertices;
+        page.indexCapacity = indices;
+        page.freeVertices.push_back({0, vertices});
+        page.freeIndices.push_back({0, indices});
+
+        const size_t stride = m_layout.stride();
+        auto& gl = Renderer::GLStateCache::get();
+
+        glGenVertexArrays(1, &page.VAO);
+        gl.bindVertexArray(page.VAO);
+
+        glGenBuffers(1, &page.VBO);
+        gl.bindBuffer(GL_ARRAY_BUFFER, page.VBO);
+        glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(vertices * stride), nullptr, GL_STATIC_DRAW);
+
+        glGenBuffers(1, &page.EBO);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, page.EBO);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, static_cast<GLsizeiptr>(indices * indexTypeSize(indexType)), nullptr, GL_STATIC_DRAW);
+
+        // Attrib offsets are from the start of the page, baseVertex does the rest
+        m_layout.apply();
+
+        gl.bindBuffer(GL_ARRAY_BUFFER, 0);
+        gl.bindVertexArray(0);
+
+        TraceLog(LogLevel::DEBUG, "[GeometryArena]: New page ({} vertices, {} {} bit indices)", vertices, indices, indexTypeSize(indexType) * 8);
+        m_pages.push_back(std::move(page));
+        return m_pages.back();
+    }
+
+    size_t GeometryArena::allocate(std::vector<Range>& freeList, size_t count) {
+        for (auto it = freeList.begin(); it != freeList.end(); ++it) {
+            if (it->count < count) continue;
+
+            const size_t offset = it->offset;
+            it->offset += count;
+            it->count -= count;
+            if (it->count == 0) freeList.erase(it);
+            return offset;
+        }
+        return SIZE_MAX;
+    }
+
+    void GeometryArena::release(std::vector<Range>& freeList, Range range) {
+        auto it = std::lower_bound(freeList.begin(), freeList.end(), range.offset, [](const Range& r, size_t offset) {
+            return r.offset < offset;
+        });
+
+        // Merge into the range after, then the one before
+        if (it != freeList.end() && range.offset + range.count == it->offset) {
+            it->offset = range.offset;
+            it->count += range.count;
+        } else {
+            it = freeList.insert(it, range);
+        }
+        if (it != freeList.begin()) {
+            auto prev = it - 1;
+            if (prev->offset + prev->count == it->offset) {
+                prev->count += it->count;
+                freeList.erase(it);
+            }
+        }
+    }
+}
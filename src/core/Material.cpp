@@ -5,18 +5,25 @@
 #include <core/Material.hpp>
 
 #include <core/Texture.hpp>
+#include <renderer/GLStateCache.hpp>
+#include <renderer/UniformBlocks.hpp>
+
+#include <atomic>
+#include <cstring>
 
 namespace Dexium::Core {
 
     void Material::remUniform(const std::string &name) {
         if (uniforms.find(name) != uniforms.end()) {
             uniforms.erase(name);
+            m_blockDirty = true;
             TraceLog(LogLevel::STATUS, "[Material]: Removed the uniform '{}' from material", name);
         }
     }
 
     void Material::clearUniforms() {
         uniforms.clear();
+        m_blockDirty = true;
     }
 
     const std::unordered_map<std::string, Material::UniformValue> &Material::getUniforms() const {
@@ -57,6 +64,122 @@ namespace Dexium::Core {
         return textures;
     }
 
+    uint32_t Material::getTextureSetKey() const {
+        // Sum of mixed ids, so unordered_map iteration order doesn't matter
+        uint32_t key = 0;
+        for (const auto& [name, tex] : textures) {
+            if (!tex) continue;
+            uint32_t h = tex->texID * 0x9E3779B1u;
+            key += h ^ (h >> 16);
+        }
+        return key;
+    }
+
+    namespace {
+        // GL type a stored value packs as, so it can be checked against the block member
+        GLenum glType(const Material::UniformValue& value) {
+            switch (value.index()) {
+                case 0: return GL_INT;
+                case 1: return GL_FLOAT;
+                case 2: return GL_FLOAT_VEC2;
+                case 3: return GL_FLOAT_VEC3;
+                case 4: return GL_FLOAT_VEC4;
+                default: return GL_FLOAT_MAT4;
+            }
+        }
+    }
+
+    void Material::applyBlock() {
+        if (!shader) return;
+
+        if (m_blockDirty || m_blockBuffer.reflection != shader->reflectionGeneration()) packBlock();
+        if (m_block.empty()) return; // No MaterialBlock, everything is loose
+
+        Renderer::GLStateCache::get().bindBufferBase(GL_UNIFORM_BUFFER, Renderer::UniformBlocks::Material.binding, m_blockBuffer.id);
+    }
+
+    void Material::packBlock() {
+        m_blockDirty = false;
+        m_blockBuffer.reflection = shader->reflectionGeneration();
+        m_loose.clear();
+
+        const GLint size = shader->materialBlockSize();
+        const auto& members = shader->materialBlockMembers();
+        m_block.assign(static_cast<size_t>(size), 0);
+
+        for (const auto& entry : uniforms) {
+            const auto& [name, value] = entry;
+
+            const Shader::BlockMember* member = nullptr;
+            if (size > 0) {
+                const uint32_t hash = Shader::uniformHash(name);
+                for (const auto& m : members) {
+                    if (m.hash == hash && m.name == name) {
+                        member = &m;
+                        break;
+                    }
+                }
+            }
+
+            if (!member) {
+                m_loose.push_back({&name, &value});
+                continue;
+            }
+
+            // bools & uints are 4 bytes in std140 too, so an int covers them
+            const GLenum type = glType(value);
+            const bool intLike = member->type == GL_INT || member->type == GL_BOOL || member->type == GL_UNSIGNED_INT;
+            if (member->type != type && !(type == GL_INT && intLike)) {
+                TraceLog(LogLevel::WARNING, "[Material]: Uniform '{}' doesn't match its MaterialBlock member's type, it won't be set", name);
+                continue;
+            }
+
+            std::visit([&](const auto& v) {
+                if (static_cast<size_t>(member->offset) + sizeof(v) <= m_block.size()) {
+                    std::memcpy(m_block.data() + member->offset, &v, sizeof(v));
+                }
+            }, value);
+        }
+
+        if (m_block.empty()) return;
+
+        // The buffer only grows, a different (bigger) layout just reallocates it
+        auto& gl = Renderer::GLStateCache::get();
+        if (m_blockBuffer.id == 0) glGenBuffers(1, &m_blockBuffer.id);
+        gl.bindBuffer(GL_UNIFORM_BUFFER, m_blockBuffer.id);
+        if (static_cast<GLsizeiptr>(m_block.size()) > m_blockBuffer.capacity) {
+            m_blockBuffer.capacity = static_cast<GLsizeiptr>(m_block.size());
+            glBufferData(GL_UNIFORM_BUFFER, m_blockBuffer.capacity, m_block.data(), GL_DYNAMIC_DRAW);
+        } else {
+            glBufferSubData(GL_UNIFORM_BUFFER, 0, static_cast<GLsizeiptr>(m_block.size()), m_block.data());
+        }
+    }
+
+    void Material::destroy() {
+        m_blockBuffer = BlockBuffer{}; // Deletes the old buffer
+        m_block.clear();
+        m_loose.clear();
+        m_blockDirty = true;
+    }
+
+    Material::BlockBuffer& Material::BlockBuffer::operator=(BlockBuffer&& other) noexcept {
+        if (this != &other) {
+            if (id) glDeleteBuffers(1, &id);
+            id = other.id;
+            capacity = other.capacity;
+            reflection = other.reflection;
+            other.id = 0;
+            other.capacity = 0;
+            other.reflection = 0;
+        }
+        return *this;
+    }
+
+    uint32_t Material::nextSortID() {
+        static std::atomic<uint32_t> counter{1}; // Materials can be created from worker threads
+        return counter.fetch_add(1, std::memory_order_relaxed);
+    }
+
 
 
 
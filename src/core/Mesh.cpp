@@ -3,23 +3,127 @@
 //
 
 #include <core/Mesh.hpp>
+#include <core/GeometryArena.hpp>
+#include <core/MeshOptimizer.hpp>
 
 #include <core/Error.hpp>
 
+#include <renderer/GLStateCache.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+
 namespace Dexium::Core {
 
+    namespace {
+        // Writes ranges (elemSize bytes each) into the bound buffer at base. write(dst, first, count) fills in the data,
+        // converted to however the buffer stores it
+        template <typename Ranges, typename Write>
+        void writeRanges(GLenum target, const Ranges& ranges, size_t elemSize, size_t base, const Write& write) {
+            if (ranges.empty()) return;
+
+            const size_t spanFirst = ranges.front().first;
+            const size_t spanBytes = (ranges.back().first + ranges.back().count - spanFirst) * elemSize;
+
+            // The region's fence has passed, so nothing on the GPU reads it & the map doesn't need to sync
+            const GLbitfield access = GL_MAP_WRITE_BIT | GL_MAP_FLUSH_EXPLICIT_BIT | GL_MAP_UNSYNCHRONIZED_BIT;
+            auto* mapped = static_cast<unsigned char*>(glMapBufferRange(target, static_cast<GLintptr>(base + spanFirst * elemSize),
+                                                                         static_cast<GLsizeiptr>(spanBytes), access));
+            if (mapped) {
+                for (const auto& r : ranges) {
+                    const size_t offset = (r.first - spanFirst) * elemSize;
+                    write(mapped + offset, r.first, r.count);
+                    glFlushMappedBufferRange(target, static_cast<GLintptr>(offset), static_cast<GLsizeiptr>(r.count * elemSize));
+                }
+                if (glUnmapBuffer(target)) return;
+                // Storage was lost, so write it the slow way
+            }
+
+            std::vector<unsigned char> scratch;
+            for (const auto& r : ranges) {
+                scratch.resize(r.count * elemSize);
+                write(scratch.data(), r.first, r.count);
+                glBufferSubData(target, static_cast<GLintptr>(base + r.first * elemSize), static_cast<GLsizeiptr>(scratch.size()),
+                                scratch.data());
+            }
+        }
+    }
+
+    uint32_t Mesh::nextSortID() {
+        static std::atomic<uint32_t> counter{1};
+        return counter.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void Mesh::StreamHolder::reset() {
+        if (!state) return;
+        for (GLsync& fence : state->fences) {
+            if (fence) glDeleteSync(fence);
+            fence = nullptr;
+        }
+        state.reset();
+    }
+
+    Mesh::ArenaLink::ArenaLink(ArenaLink&& other) noexcept : arena(other.arena), handle(other.handle) {
+        if (arena) arena->relink(handle, this);
+        other.arena = nullptr;
+        other.handle = 0;
+    }
+
+    Mesh::ArenaLink& Mesh::ArenaLink::operator=(ArenaLink&& other) noexcept {
+        if (this != &other) {
+            release();
+            arena = other.arena;
+            handle = other.handle;
+            if (arena) arena->relink(handle, this);
+            other.arena = nullptr;
+            other.handle = 0;
+        }
+        return *this;
+    }
+
+    void Mesh::ArenaLink::release() {
+        if (arena) arena->freeAllocation(handle);
+        arena = nullptr;
+        handle = 0;
+    }
+
     void Mesh::destroy() {
+        // Arena meshes give their ranges back (the pages are the arena's to delete)
+        m_arena.release();
+
         // I think because Mesh is managed by a unique_ptr, calliung glDelete on the buffers is a double delete -> SEGFAULT
         //if (VBO) glDeleteBuffers(1, &VBO);
         //if (VAO) glDeleteVertexArrays(1, &VAO);
         //if (EBO) glDeleteBuffers(1, &EBO);
 
+        // The fences are ours though, even when the buffers aren't
+        m_stream.reset();
+
         // 0 assign ID's, so stale meshes dont accidentally use other buffer ID's
         VBO = 0;
         VAO = 0;
         EBO = 0;
     }
 
+    void Mesh::computeBounds() {
+        hasBounds = false;
+        if (vertexCount <= 0 || vertices.size() < static_cast<size_t>(vertexCount) * 3) return;
+
+        // Floats per vertex, whatever the attrib layout is (position is expected first)
+        const size_t stride = vertices.size() / static_cast<size_t>(vertexCount);
+
+        boundsMin = glm::vec3(vertices[0], vertices[1], vertices[2]);
+        boundsMax = boundsMin;
+        for (size_t v = 1; v < static_cast<size_t>(vertexCount); ++v) {
+            const float* p = &vertices[v * stride];
+            const glm::vec3 pos(p[0], p[1], p[2]);
+            boundsMin = glm::min(boundsMin, pos);
+            boundsMax = glm::max(boundsMax, pos);
+        }
+        hasBounds = true;
+    }
+
     // Generate Mesh (2D Variant)
     void Mesh::generateMesh(MeshType::Mesh2D type) {
         switch (type) {
@@ -57,33 +161,61 @@ namespace Dexium::Core {
             TraceLog(LogLevel::ERROR, "[Mesh]: vertices provided, but no count on custom profile");
             return;
         }
+        // Without a callback the layout says what every vertex holds, so the data has to agree with it
+        if (!setupAttribs && vertices.size() != static_cast<size_t>(vertexCount) * layout.sourceFloats()) {
+            TraceLog(LogLevel::ERROR, "[Mesh]: {} floats for {} vertices doesn't match the vertex layout ({} floats per vertex)",
+                vertices.size(), vertexCount, layout.sourceFloats());
+            return;
+        }
+        if (indices.size() < static_cast<size_t>(std::max(indexCount, 0))) {
+            TraceLog(LogLevel::ERROR, "[Mesh]: indexCount is {}, but only {} indices were provided", indexCount, indices.size());
+            return;
+        }
         //Can still build a mesh without indices, just dont sue EBO
 
+        if (optimize) MeshOptimizer::optimize(*this);
+
+        computeBounds();
+
+        // Fresh buffers, so any streaming ring (and its offsets) is gone
+        m_stream.reset();
+        baseVertex = 0;
+        firstIndex = 0;
+
+        m_rawVertices = static_cast<bool>(setupAttribs);
+        indexType = indexTypeFor(static_cast<size_t>(vertexCount));
+
+        auto& gl = Renderer::GLStateCache::get();
+
         // Generate & bind VAO
         glGenVertexArrays(1, &VAO);
-        glBindVertexArray(VAO);
+        gl.bindVertexArray(VAO);
 
         // Generate & bind VBO
         glGenBuffers(1, &VBO);
-        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        gl.bindBuffer(GL_ARRAY_BUFFER, VBO);
 
-        // Uplaod buffer data
-        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), usageHint);
+        // Convert to the GPU layout & uplaod
+        std::vector<unsigned char> packed(static_cast<size_t>(vertexCount) * vertexStride());
+        packVertices(0, static_cast<size_t>(vertexCount), packed.data());
+        glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(packed.size()), packed.data(), usageHint);
 
         // Generate an EBO if provided
         if (indices.size() > 0) {
             glGenBuffers(1, &EBO);
         }
 
-        // Uplaod EBO
+        // Uplaod EBO (16 bit indices for anything up to 65536 vertices)
         if (usingEBO()) {
+            packed.resize(static_cast<size_t>(std::max(indexCount, 0)) * indexSize());
+            packIndices(indices.data(), static_cast<size_t>(std::max(indexCount, 0)), indexType, packed.data());
             glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-            glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexCount * sizeof(unsigned int), indices.data(), usageHint);
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, static_cast<GLsizeiptr>(packed.size()), packed.data(), usageHint);
         }
 
         // WARNING: THIS FN IS ALSO USED FOR CUSTOM MESHES, CANNOT OUTPUT A NY LOGS THOUGH AS THE PRE-GENERATED MESHES ALSO USE THIS FN
         // SO IT IS ENTIRELY UP TO THE END-USER TO ENSURE THEY ARE CORRECTLY CONFIGURING THESE ATTRIBS
-        // IF NO ATTRIBS (setupAttribs) ARE PROVIDED, WE WILL USE THE DEFAULT:
+        // IF NO ATTRIBS (setupAttribs) ARE PROVIDED, THE MESH'S LAYOUT IS USED. By default:
         // Position (vert 3) attrib 0
         // UVs (vert 2) attrib 1
         // In this default case, vertice data should be 5 comps long per vertex. So for a single triangle under this default, the vertices should be 3*5=15 in size
@@ -91,22 +223,181 @@ namespace Dexium::Core {
         if (setupAttribs) {
             setupAttribs();
         } else {
-            // Use defaults
-            // Pos (0-3)
-            glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)0);
-            glEnableVertexAttribArray(0);
-
-            // UVs (4-5)
-            glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(3 * sizeof(float)));
-            glEnableVertexAttribArray(1);
+            layout.apply();
         }
 
         // Unbind buffers to prevent unintended editing
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
-        glBindVertexArray(0);
+        gl.bindBuffer(GL_ARRAY_BUFFER, 0);
+        gl.bindVertexArray(0);
+    }
+
+    size_t Mesh::vertexStride() const {
+        if (!m_rawVertices) return layout.stride();
+        return vertices.size() / static_cast<size_t>(vertexCount) * sizeof(float);
+    }
+
+    void Mesh::packVertices(size_t first, size_t count, void* dst) const {
+        const size_t floats = vertices.size() / static_cast<size_t>(vertexCount);
+        if (m_rawVertices) {
+            std::memcpy(dst, vertices.data() + first * floats, count * floats * sizeof(float));
+        } else {
+            layout.pack(vertices.data() + first * floats, count, dst);
+        }
+    }
+
+    Mesh::StreamState& Mesh::stream() {
+        if (!m_stream.state) m_stream.state = std::make_unique<StreamState>();
+        return *m_stream.state;
+    }
+
+    void Mesh::markRange(std::vector<DirtyRange>& ranges, DirtyRange range) {
+        // Insert sorted, then swallow anything it overlaps or touches
+        auto it = std::lower_bound(ranges.begin(), ranges.end(), range.first, [](const DirtyRange& r, size_t first) {
+            return r.first < first;
+        });
+        if (it != ranges.begin() && (it - 1)->first + (it - 1)->count >= range.first) --it;
+        else it = ranges.insert(it, range);
+
+        size_t end = std::max(it->first + it->count, range.first + range.count);
+        it->first = std::min(it->first, range.first);
+        auto next = it + 1;
+        while (next != ranges.end() && next->first <= end) {
+            end = std::max(end, next->first + next->count);
+            ++next;
+        }
+        it->count = end - it->first;
+        ranges.erase(it + 1, next);
+
+        // Lots of little ranges cost more in map flushes than just sending the span
+        constexpr size_t MaxRanges = 32;
+        if (ranges.size() > MaxRanges) {
+            const size_t first = ranges.front().first;
+            ranges = {{first, ranges.back().first + ranges.back().count - first}};
+        }
+    }
+
+    void Mesh::markVerticesDirty(size_t firstVertex, size_t count) {
+        const auto total = static_cast<size_t>(std::max(vertexCount, 0));
+        if (firstVertex >= total || count == 0) return;
+        count = std::min(count, total - firstVertex);
+
+        auto& s = stream();
+        for (auto& stale : s.staleVertices) markRange(stale, {firstVertex, count});
+        s.pending = true;
+    }
+
+    void Mesh::markIndicesDirty(size_t first, size_t count) {
+        const auto total = static_cast<size_t>(std::max(indexCount, 0));
+        if (first >= total || count == 0) return;
+        count = std::min(count, total - first);
+
+        auto& s = stream();
+        for (auto& stale : s.staleIndices) markRange(stale, {first, count});
+        s.pending = true;
+    }
+
+    void Mesh::updateVertices(size_t firstVertex, const float* data, size_t count) {
+        if (vertexCount <= 0 || !data) return;
+        const size_t stride = vertices.size() / static_cast<size_t>(vertexCount);
+        if (firstVertex + count > static_cast<size_t>(vertexCount)) {
+            TraceLog(LogLevel::WARNING, "[Mesh]: Vertex update [{}, {}) is past the end of the mesh ({} vertices)", firstVertex, firstVertex + count, vertexCount);
+            return;
+        }
+
+        std::memcpy(vertices.data() + firstVertex * stride, data, count * stride * sizeof(float));
+        markVerticesDirty(firstVertex, count);
+    }
+
+    void Mesh::updateIndices(size_t first, const unsigned int* data, size_t count) {
+        if (!data) return;
+        if (first + count > static_cast<size_t>(std::max(indexCount, 0))) {
+            TraceLog(LogLevel::WARNING, "[Mesh]: Index update [{}, {}) is past the end of the mesh ({} indices)", first, first + count, indexCount);
+            return;
+        }
+
+        std::memcpy(indices.data() + first, data, count * sizeof(unsigned int));
+        markIndicesDirty(first, count);
     }
 
+    void Mesh::uploadDirty() {
+        if (!isDirty()) return;
+        if (VBO == 0 || vertexCount <= 0) {
+            TraceLog(LogLevel::WARNING, "[Mesh]: Cannot upload changes to a mesh that hasn't been built");
+            return;
+        }
+
+        auto& s = *m_stream.state;
+        if (m_inArena) {
+            // Growing the buffers would wipe every other mesh in the page
+            TraceLog(LogLevel::WARNING, "[Mesh]: Mesh is sub-allocated by a GeometryArena, it can't stream partial updates");
+            return;
+        }
+
+        auto& gl = Renderer::GLStateCache::get();
+
+        // Sizes as the buffers store them, each range is converted on the way in
+        const size_t stride = vertexStride();
+        const size_t vertexBytes = static_cast<size_t>(vertexCount) * stride;
+        const size_t indexBytes = static_cast<size_t>(std::max(indexCount, 0)) * indexSize();
+
+        // The EBO binding is VAO state
+        gl.bindVertexArray(VAO);
+        gl.bindBuffer(GL_ARRAY_BUFFER, VBO);
+
+        if (!s.allocated) {
+            // Re-specifying the storage keeps the buffer names (so the VAO), but drops the contents: every copy needs everything
+            glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(vertexBytes * StreamRegions), nullptr, usageHint);
+            if (usingEBO()) {
+                glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+                glBufferData(GL_ELEMENT_ARRAY_BUFFER, static_cast<GLsizeiptr>(indexBytes * StreamRegions), nullptr, usageHint);
+            }
+            for (int r = 0; r < StreamRegions; ++r) {
+                s.staleVertices[r] = {{0, static_cast<size_t>(vertexCount)}};
+                s.staleIndices[r].clear();
+                if (usingEBO()) s.staleIndices[r] = {{0, static_cast<size_t>(indexCount)}};
+            }
+            s.region = StreamRegions - 1; // So the first upload lands in copy 0
+            s.allocated = true;
+        } else {
+            // Every draw reading the current copy has been issued by now
+            GLsync& current = s.fences[s.region];
+            if (current) glDeleteSync(current);
+            current = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        }
+
+        const int next = (s.region + 1) % StreamRegions;
+
+        // Normally long done (it was drawn StreamRegions uploads ago), so this rarely blocks
+        GLsync& sync = s.fences[next];
+        if (sync) {
+            GLenum result = glClientWaitSync(sync, 0, 0);
+            while (result == GL_TIMEOUT_EXPIRED) {
+                result = glClientWaitSync(sync, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000); // 1ms slices
+            }
+            glDeleteSync(sync);
+            sync = nullptr;
+        }
+
+        writeRanges(GL_ARRAY_BUFFER, s.staleVertices[next], stride, vertexBytes * next, [this](void* dst, size_t first, size_t count) {
+            packVertices(first, count, dst);
+        });
+        if (usingEBO()) {
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+            writeRanges(GL_ELEMENT_ARRAY_BUFFER, s.staleIndices[next], indexSize(), indexBytes * next, [this](void* dst, size_t first, size_t count) {
+                packIndices(indices.data() + first, count, indexType, dst);
+            });
+        }
+        s.staleVertices[next].clear();
+        s.staleIndices[next].clear();
+
+        gl.bindBuffer(GL_ARRAY_BUFFER, 0);
+        gl.bindVertexArray(0);
 
+        s.region = next;
+        s.pending = false;
+        baseVertex = static_cast<GLint>(static_cast<size_t>(vertexCount) * next);
+        firstIndex = static_cast<GLuint>(static_cast<size_t>(std::max(indexCount, 0)) * next);
+    }
 
     // The creme de la creme
     std::unique_ptr<Mesh> createMesh(Mesh::_MeshType type, const std::function<void()>& setupAttribs) {
@@ -124,51 +415,18 @@ namespace Dexium::Core {
             mesh->generateMesh(value);
         }
 
-        // No validation of Meshdata needeed, as these are internal engine functions
-
-        // Generaye &  bind VAO
-        glGenVertexArrays(1, &mesh->VAO);
-        glBindVertexArray(mesh->VAO);
-
-        // Generate + bind VBO
-        glGenBuffers(1, &mesh->VBO);
-        glBindBuffer(GL_ARRAY_BUFFER, mesh->VBO);
-
-        // Upload buffer data
-        glBufferData(GL_ARRAY_BUFFER, mesh->vertices.size() * sizeof(float), mesh->vertices.data(), mesh->usageHint);
-
-        // Generate an EBO if indice data exists
-        if (mesh->indexCount > 0) {
-            glGenBuffers(1, &mesh->EBO);
-        }
-
-        // Upload EBO
-        if (mesh->usingEBO()) {
-            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh->EBO);
-            glBufferData(GL_ELEMENT_ARRAY_BUFFER, mesh->indexCount * sizeof(unsigned int), mesh->indices.data(), mesh->usageHint);
-        }
-
-        // Bind Vertex data(pos) to attrib 0
-        // Bind UV data to          attrib 1
-        // Unless overridden
-        if (setupAttribs) {
-            setupAttribs();
-        } else {
-            // Vertex data (Based off the layout of the default 2D shader)
-            // x, y, z, u, v
-            glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)0);
-            glEnableVertexAttribArray(0);
-
-            // UV data
-            glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(3 * sizeof(float)));
-            glEnableVertexAttribArray(1);
-        }
-
-        // Unbind buffers (so they are not accidentally modified by state)
-        glBindBuffer(GL_ARRAY_BUFFER, 0); // Unbinds VBO (Does not unbind the internal VAO from the buffer)
-        glBindVertexArray(0); // Unbinds the VAO
+        // Same upload as a custom mesh: pos to attrib 0, UVs to attrib 1 (through the mesh's layout), unless overridden
+        mesh->buildMesh(setupAttribs);
 
         // Return the generated mesh
         return mesh;
     }
+
+    std::unique_ptr<Mesh> createMesh(Mesh::_MeshType type, const VertexLayout& layout) {
+        auto mesh = std::make_unique<Mesh>();
+        mesh->layout = layout;
+        std::visit([&mesh](auto value) { mesh->generateMesh(value); }, type);
+        mesh->buildMesh();
+        return mesh;
+    }
 }
\ No newline at end of file
@@ -0,0 +1,356 @@
+//
+// Created by Dextron12 on 17/10/26.
+//
+
+#include <core/MeshOptimizer.hpp>
+#include <core/Mesh.hpp>
+#include <core/Error.hpp>
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <numeric>
+
+namespace Dexium::Core::MeshOptimizer {
+
+    namespace {
+        constexpr size_t NoTriangle = SIZE_MAX;
+
+        // Forsyth's tuned constants
+        constexpr size_t LruSize = 32;
+        constexpr float CacheDecayPower = 1.5f;
+        constexpr float LastTriangleScore = 0.75f;
+        constexpr float ValenceBoostScale = 2.f;
+        constexpr float ValenceBoostPower = 0.5f;
+        constexpr size_t ValenceTableSize = 32;
+
+        struct ScoreTable {
+            std::array<float, LruSize> cache{};
+            std::array<float, ValenceTableSize> valence{};
+
+            ScoreTable() {
+                for (size_t i = 0; i < LruSize; ++i) {
+                    // The last triangle's 3 vertices score the same, so it isn't favoured to re-emit in the same winding
+                    cache[i] = i < 3 ? LastTriangleScore
+                                     : std::pow(1.f - static_cast<float>(i - 3) / static_cast<float>(LruSize - 3), CacheDecayPower);
+                }
+                for (size_t i = 1; i < ValenceTableSize; ++i) {
+                    valence[i] = ValenceBoostScale * std::pow(static_cast<float>(i), -ValenceBoostPower);
+                }
+            }
+        };
+
+        float vertexScore(int cachePosition, uint32_t liveTriangles) {
+            static const ScoreTable table;
+            if (liveTriangles == 0) return -1.f; // Done with, nothing to gain
+
+            float score = cachePosition >= 0 ? table.cache[static_cast<size_t>(cachePosition)] : 0.f;
+            // Vertices with few triangles left get a boost, so lone triangles aren't left behind as dead ends
+            score += liveTriangles < ValenceTableSize ? table.valence[liveTriangles]
+                                                      : ValenceBoostScale * std::pow(static_cast<float>(liveTriangles), -ValenceBoostPower);
+            return score;
+        }
+
+        // Timestamp FIFO: a vertex is cached if fewer than size misses happened since it was loaded
+        class FifoCache {
+        public:
+            FifoCache(size_t vertexCount, unsigned int size) : m_stamps(vertexCount, 0), m_time(size + 1), m_size(size) {}
+
+            unsigned int misses(const unsigned int* triangle) {
+                unsigned int count = 0;
+                for (int c = 0; c < 3; ++c) {
+                    uint32_t& stamp = m_stamps[triangle[c]];
+                    if (m_time - stamp > m_size) {
+                        stamp = m_time++;
+                        ++count;
+                    }
+                }
+                return count;
+            }
+
+            void flush() { m_time += m_size + 1; }
+
+        private:
+            std::vector<uint32_t> m_stamps;
+            uint32_t m_time;
+            uint32_t m_size;
+        };
+
+        glm::vec3 position(const std::vector<float>& vertices, size_t stride, unsigned int vertex) {
+            const float* p = &vertices[vertex * stride];
+            return {p[0], p[1], p[2]};
+        }
+    }
+
+    float computeACMR(const std::vector<unsigned int>& indices, size_t vertexCount, unsigned int cacheSize) {
+        const size_t triangles = indices.size() / 3;
+        if (triangles == 0 || vertexCount == 0) return 0.f;
+
+        FifoCache cache(vertexCount, cacheSize);
+        size_t misses = 0;
+        for (size_t t = 0; t < triangles; ++t) misses += cache.misses(&indices[t * 3]);
+        return static_cast<float>(misses) / static_cast<float>(triangles);
+    }
+
+    void optimizeVertexCache(std::vector<unsigned int>& indices, size_t vertexCount) {
+        const size_t triangles = indices.size() / 3;
+        if (triangles < 2 || vertexCount == 0) return;
+
+        // Triangles using each vertex, the live (not yet emitted) ones kept at the front of each vertex's slice
+        std::vector<uint32_t> live(vertexCount, 0), offsets(vertexCount + 1, 0);
+        for (size_t i = 0; i < triangles * 3; ++i) ++live[indices[i]];
+        for (size_t v = 0; v < vertexCount; ++v) offsets[v + 1] = offsets[v] + live[v];
+
+        std::vector<uint32_t> adjacency(triangles * 3);
+        {
+            std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+            for (size_t i = 0; i < triangles * 3; ++i) adjacency[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+        }
+
+        std::vector<int> cachePosition(vertexCount, -1);
+        std::vector<float> scores(vertexCount);
+        for (size_t v = 0; v < vertexCount; ++v) scores[v] = vertexScore(-1, live[v]);
+
+        // Triangle scores are only compared for triangles touching the cache, so they're summed when needed instead of kept up to date
+        const auto triangleScore = [&indices, &scores](size_t t) {
+            return scores[indices[t * 3]] + scores[indices[t * 3 + 1]] + scores[indices[t * 3 + 2]];
+        };
+
+        std::vector<char> emitted(triangles, 0);
+        std::vector<unsigned int> sorted;
+        sorted.reserve(indices.size());
+
+        // +3 so the entries pushed out by a triangle still get rescored
+        std::array<uint32_t, LruSize + 3> cache{}, next{};
+        size_t cacheCount = 0;
+
+        size_t best = 0;
+        for (size_t t = 1; t < triangles; ++t) {
+            if (triangleScore(t) > triangleScore(best)) best = t;
+        }
+        size_t scan = 0;
+
+        for (size_t n = 0; n < triangles; ++n) {
+            if (best == NoTriangle) {
+                // Dead end, nothing in the cache touches a live triangle. Carry on from the input order
+                while (emitted[scan]) ++scan;
+                best = scan;
+            }
+
+            const unsigned int* triangle = &indices[best * 3];
+            emitted[best] = 1;
+            sorted.insert(sorted.end(), triangle, triangle + 3);
+
+            for (int c = 0; c < 3; ++c) {
+                const unsigned int v = triangle[c];
+                uint32_t* begin = &adjacency[offsets[v]];
+                uint32_t* end = begin + live[v];
+                *std::find(begin, end, static_cast<uint32_t>(best)) = *(end - 1);
+                --live[v];
+            }
+
+            // The triangle's vertices go to the front, everything else shuffles back
+            size_t nextCount = 0;
+            for (int c = 0; c < 3; ++c) {
+                if (std::find(next.begin(), next.begin() + static_cast<std::ptrdiff_t>(nextCount), triangle[c]) ==
+                    next.begin() + static_cast<std::ptrdiff_t>(nextCount)) {
+                    next[nextCount++] = triangle[c];
+                }
+            }
+            for (size_t i = 0; i < cacheCount; ++i) {
+                const uint32_t v = cache[i];
+                if (v != triangle[0] && v != triangle[1] && v != triangle[2]) next[nextCount++] = v;
+            }
+            for (size_t i = 0; i < nextCount; ++i) cachePosition[next[i]] = i < LruSize ? static_cast<int>(i) : -1;
+
+            // Rescore whatever moved, then pick the best triangle touching the cache
+            for (size_t i = 0; i < nextCount; ++i) scores[next[i]] = vertexScore(cachePosition[next[i]], live[next[i]]);
+
+            best = NoTriangle;
+            float bestScore = -1.f;
+            cacheCount = std::min(nextCount, LruSize);
+            for (size_t i = 0; i < cacheCount; ++i) {
+                const uint32_t v = next[i];
+                cache[i] = v;
+                for (uint32_t a = offsets[v]; a < offsets[v] + live[v]; ++a) {
+                    const float score = triangleScore(adjacency[a]);
+                    if (score > bestScore) {
+                        bestScore = score;
+                        best = adjacency[a];
+                    }
+                }
+            }
+        }
+
+        indices.swap(sorted);
+    }
+
+    void optimizeOverdraw(std::vector<unsigned int>& indices, const std::vector<float>& vertices, size_t vertexCount,
+                          unsigned int cacheSize, float threshold) {
+        const size_t triangles = indices.size() / 3;
+        if (triangles < 2 || vertexCount == 0) return;
+        const size_t stride = vertices.size() / vertexCount;
+        if (stride < 3) return;
+
+        FifoCache cache(vertexCount, cacheSize);
+
+        // A triangle missing on all 3 corners is where the cache order already starts over, so clusters can split there for free
+        std::vector<size_t> hard;
+        for (size_t t = 0; t < triangles; ++t) {
+            if (cache.misses(&indices[t * 3]) == 3 || t == 0) hard.push_back(t);
+        }
+        hard.push_back(triangles);
+
+        // Split further wherever the cluster so far is within threshold of the whole hard cluster's ACMR
+        std::vector<size_t> clusters;
+        for (size_t h = 0; h + 1 < hard.size(); ++h) {
+            const size_t first = hard[h], last = hard[h + 1];
+
+            cache.flush();
+            size_t misses = 0;
+            for (size_t t = first; t < last; ++t) misses += cache.misses(&indices[t * 3]);
+            const float target = threshold * static_cast<float>(misses) / static_cast<float>(last - first);
+
+            cache.flush();
+            size_t start = first;
+            misses = 0;
+            for (size_t t = first; t < last; ++t) {
+                misses += cache.misses(&indices[t * 3]);
+                if (t + 1 < last && static_cast<float>(misses) <= target * static_cast<float>(t + 1 - start)) {
+                    clusters.push_back(start);
+                    start = t + 1;
+                    misses = 0;
+                    cache.flush(); // The next cluster may be drawn after anything, so it starts cold
+                }
+            }
+            clusters.push_back(start);
+        }
+        clusters.push_back(triangles);
+
+        // Area weighted centroids & normals
+        const size_t clusterCount = clusters.size() - 1;
+        std::vector<glm::vec3> centroids(clusterCount, glm::vec3(0.f)), normals(clusterCount, glm::vec3(0.f));
+        std::vector<float> areas(clusterCount, 0.f);
+        glm::vec3 meshCentroid(0.f);
+        float meshArea = 0.f;
+
+        for (size_t c = 0; c < clusterCount; ++c) {
+            for (size_t t = clusters[c]; t < clusters[c + 1]; ++t) {
+                const glm::vec3 a = position(vertices, stride, indices[t * 3]);
+                const glm::vec3 b = position(vertices, stride, indices[t * 3 + 1]);
+                const glm::vec3 d = position(vertices, stride, indices[t * 3 + 2]);
+
+                const glm::vec3 normal = glm::cross(b - a, d - a);
+                const float area = glm::length(normal);
+                centroids[c] += (a + b + d) * (area / 3.f);
+                normals[c] += normal;
+                areas[c] += area;
+            }
+            meshCentroid += centroids[c];
+            meshArea += areas[c];
+        }
+        if (meshArea > 0.f) meshCentroid /= meshArea;
+
+        // Clusters furthest out along their own normal are the likeliest occluders, so go first
+        std::vector<float> keys(clusterCount, 0.f);
+        for (size_t c = 0; c < clusterCount; ++c) {
+            const float length = glm::length(normals[c]);
+            if (areas[c] <= 0.f || length <= 0.f) continue;
+            keys[c] = glm::dot(centroids[c] / areas[c] - meshCentroid, normals[c] / length);
+        }
+
+        std::vector<size_t> order(clusterCount);
+        std::iota(order.begin(), order.end(), size_t{0});
+        std::stable_sort(order.begin(), order.end(), [&keys](size_t a, size_t b) { return keys[a] > keys[b]; });
+
+        std::vector<unsigned int> sorted;
+        sorted.reserve(indices.size());
+        for (size_t c : order) {
+            sorted.insert(sorted.end(), indices.begin() + static_cast<std::ptrdiff_t>(clusters[c] * 3),
+                          indices.begin() + static_cast<std::ptrdiff_t>(clusters[c + 1] * 3));
+        }
+
+        // Clusters were measured from a cold cache, which the order they end up in doesn't always match.
+        // Keep threshold a real limit, rather than trading more cache efficiency than asked for
+        if (computeACMR(sorted, vertexCount, cacheSize) > threshold * computeACMR(indices, vertexCount, cacheSize)) return;
+        indices.swap(sorted);
+    }
+
+    std::vector<unsigned int> optimizeVertexFetch(std::vector<float>& vertices, std::vector<unsigned int>& indices, size_t vertexCount) {
+        std::vector<unsigned int> remap(vertexCount, UINT32_MAX);
+        if (vertexCount == 0) return remap;
+        const size_t stride = vertices.size() / vertexCount;
+
+        unsigned int used = 0;
+        for (auto& index : indices) {
+            if (remap[index] == UINT32_MAX) remap[index] = used++;
+            index = remap[index];
+        }
+
+        std::vector<float> sorted(used * stride);
+        for (size_t v = 0; v < vertexCount; ++v) {
+            if (remap[v] == UINT32_MAX) continue;
+            std::copy_n(vertices.begin() + static_cast<std::ptrdiff_t>(v * stride), stride,
+                        sorted.begin() + static_cast<std::ptrdiff_t>(remap[v] * stride));
+        }
+        vertices.swap(sorted);
+        return remap;
+    }
+
+    Report optimize(Mesh& mesh, const Options& options) {
+        Report report;
+
+        if (mesh.drawMode != GL_TRIANGLES || mesh.indexCount < 3 || mesh.vertexCount <= 0) {
+            TraceLog(LogLevel::DEBUG, "[MeshOptimizer]: Only indexed GL_TRIANGLES meshes are optimized, leaving the mesh as is");
+            return report;
+        }
+
+        const auto vertexCount = static_cast<size_t>(mesh.vertexCount);
+        const auto indexCount = static_cast<size_t>(mesh.indexCount);
+        if (indexCount % 3 != 0 || mesh.indices.size() < indexCount || mesh.vertices.size() % vertexCount != 0) {
+            TraceLog(LogLevel::WARNING, "[MeshOptimizer]: Mesh data is malformed ({} indices, {} floats for {} vertices), not optimizing",
+                indexCount, mesh.vertices.size(), vertexCount);
+            return report;
+        }
+        if (std::any_of(mesh.indices.begin(), mesh.indices.begin() + static_cast<std::ptrdiff_t>(indexCount),
+                        [vertexCount](unsigned int i) { return i >= vertexCount; })) {
+            TraceLog(LogLevel::WARNING, "[MeshOptimizer]: Mesh has indices past its {} vertices, not optimizing", vertexCount);
+            return report;
+        }
+
+        // Anything past indexCount is never drawn, so it doesn't survive reordering
+        mesh.indices.resize(indexCount);
+
+        const auto stage = [&](StageReport& result, const char* name, auto&& run) {
+            result.ran = true;
+            result.acmrBefore = computeACMR(mesh.indices, static_cast<size_t>(mesh.vertexCount), options.cacheSize);
+            run();
+            result.acmrAfter = computeACMR(mesh.indices, static_cast<size_t>(mesh.vertexCount), options.cacheSize);
+            TraceLog(LogLevel::DEBUG, "[MeshOptimizer]: {}: ACMR {:.3f} -> {:.3f}", name, result.acmrBefore, result.acmrAfter);
+        };
+
+        if (options.vertexCache) {
+            stage(report.vertexCache, "Vertex cache", [&] { optimizeVertexCache(mesh.indices, vertexCount); });
+        }
+        if (options.overdraw) {
+            stage(report.overdraw, "Overdraw", [&] {
+                optimizeOverdraw(mesh.indices, mesh.vertices, vertexCount, options.cacheSize, options.overdrawThreshold);
+            });
+        }
+        if (options.vertexFetch) {
+            const size_t stride = mesh.vertices.size() / vertexCount;
+            stage(report.vertexFetch, "Vertex fetch", [&] {
+                report.remap = optimizeVertexFetch(mesh.vertices, mesh.indices, vertexCount);
+                mesh.vertexCount = static_cast<int>(mesh.vertices.size() / stride);
+            });
+            if (static_cast<size_t>(mesh.vertexCount) < vertexCount) {
+                TraceLog(LogLevel::DEBUG, "[MeshOptimizer]: Dropped {} unused vertices", vertexCount - static_cast<size_t>(mesh.vertexCount));
+            }
+        }
+
+        return report;
+    }
+}
@@ -0,0 +1,238 @@
+//
+// Created by Dextron12 on 17/10/26.
+//
+
+#include <core/SceneGraph.hpp>
+#include <core/Error.hpp>
+
+#include <algorithm>
+#include <type_traits>
+
+namespace Dexium::Core {
+
+    namespace {
+        constexpr uint32_t NoIndex = UINT32_MAX;
+    }
+
+    SceneGraph::Node SceneGraph::create(const Transform& local, Node parent) {
+        if (parent != InvalidNode && !valid(parent)) {
+            TraceLog(LogLevel::WARNING, "[SceneGraph]: Cannot create a node under an invalid parent ({})", parent);
+            return InvalidNode;
+        }
+
+        Node handle;
+        if (!m_freeHandles.empty()) {
+            handle = m_freeHandles.back();
+            m_freeHandles.pop_back();
+        } else {
+            handle = static_cast<Node>(m_indices.size());
+            m_indices.push_back(NoIndex);
+        }
+
+        // Last child of parent = just past the end of its subtree
+        const size_t at = parent == InvalidNode ? size() : m_indices[parent] + m_sizes[m_indices[parent]];
+        forEachArray([at](auto& array) {
+            array.insert(array.begin() + static_cast<std::ptrdiff_t>(at), typename std::decay_t<decltype(array)>::value_type{});
+        });
+        m_handles[at] = handle;
+        m_parents[at] = parent;
+        m_sizes[at] = 1;
+        m_locals[at] = local;
+        m_worlds[at] = glm::mat4(1.f);
+
+        resizeAncestors(parent, 1);
+        reindex(at, size());
+        markDirty(at);
+        return handle;
+    }
+
+    void SceneGraph::destroy(Node node) {
+        if (!valid(node)) {
+            TraceLog(LogLevel::WARNING, "[SceneGraph]: Destroying an invalid node ({})", node);
+            return;
+        }
+
+        const size_t first = m_indices[node];
+        const size_t count = m_sizes[first];
+        const Node parent = m_parents[first];
+
+        for (size_t i = first; i < first + count; ++i) {
+            m_indices[m_handles[i]] = NoIndex;
+            m_freeHandles.push_back(m_handles[i]);
+        }
+
+        forEachArray([first, count](auto& array) {
+            const auto begin = array.begin() + static_cast<std::ptrdiff_t>(first);
+            array.erase(begin, begin + static_cast<std::ptrdiff_t>(count));
+        });
+
+        resizeAncestors(parent, -static_cast<int64_t>(count));
+        reindex(first, size());
+    }
+
+    void SceneGraph::clear() {
+        forEachArray([](auto& array) { array.clear(); });
+        m_indices.clear();
+        m_freeHandles.clear();
+    }
+
+    void SceneGraph::reserve(size_t count) {
+        forEachArray([count](auto& array) { array.reserve(count); });
+        m_indices.reserve(count);
+    }
+
+    bool SceneGraph::setParent(Node node, Node parent) {
+        if (!valid(node) || (parent != InvalidNode && !valid(parent))) {
+            TraceLog(LogLevel::WARNING, "[SceneGraph]: Cannot parent node {} to node {}, one of them is invalid", node, parent);
+            return false;
+        }
+
+        const size_t first = m_indices[node];
+        const size_t count = m_sizes[first];
+
+        size_t dest = size(); // Roots go on the end
+        if (parent != InvalidNode) {
+            const size_t p = m_indices[parent];
+            if (p >= first && p < first + count) {
+                TraceLog(LogLevel::WARNING, "[SceneGraph]: Cannot parent node {} to its own descendant ({})", node, parent);
+                return false;
+            }
+            dest = p + m_sizes[p]; // Sizes from before the move, so this is right even when node is already under parent
+        }
+
+        if (m_parents[first] == parent) return true;
+
+        resizeAncestors(m_parents[first], -static_cast<int64_t>(count));
+        m_parents[first] = parent;
+
+        // Rotate the subtree's range to dest, only the nodes between the two positions shift
+        size_t moved;
+        if (dest > first) {
+            forEachArray([first, count, dest](auto& array) {
+                const auto begin = array.begin();
+                std::rotate(begin + static_cast<std::ptrdiff_t>(first), begin + static_cast<std::ptrdiff_t>(first + count),
+                            begin + static_cast<std::ptrdiff_t>(dest));
+            });
+            reindex(first, dest);
+            moved = dest - count;
+        } else {
+            forEachArray([first, count, dest](auto& array) {
+                const auto begin = array.begin();
+                std::rotate(begin + static_cast<std::ptrdiff_t>(dest), begin + static_cast<std::ptrdiff_t>(first),
+                            begin + static_cast<std::ptrdiff_t>(first + count));
+            });
+            reindex(dest, first + count);
+            moved = dest;
+        }
+
+        resizeAncestors(parent, static_cast<int64_t>(count));
+        markDirty(moved); // New parent space, so the whole subtree needs new world matrices
+        return true;
+    }
+
+    SceneGraph::Node SceneGraph::getParent(Node node) const {
+        return valid(node) ? m_parents[m_indices[node]] : InvalidNode;
+    }
+
+    bool SceneGraph::valid(Node node) const {
+        return node < m_indices.size() && m_indices[node] != NoIndex;
+    }
+
+    Transform& SceneGraph::local(Node node) {
+        if (!valid(node)) {
+            TraceLog(LogLevel::WARNING, "[SceneGraph]: Editing the transform of an invalid node ({})", node);
+            static Transform scratch(glm::vec3(0.f));
+            scratch = Transform(glm::vec3(0.f));
+            return scratch;
+        }
+        const size_t index = m_indices[node];
+        markDirty(index);
+        return m_locals[index];
+    }
+
+    void SceneGraph::setLocal(Node node, const Transform& local) {
+        if (!valid(node)) {
+            TraceLog(LogLevel::WARNING, "[SceneGraph]: Setting the transform of an invalid node ({})", node);
+            return;
+        }
+        const size_t index = m_indices[node];
+        m_locals[index] = local;
+        markDirty(index);
+    }
+
+    void SceneGraph::setRenderable(Node node, Mesh* mesh, Material* material) {
+        if (!valid(node)) {
+            TraceLog(LogLevel::WARNING, "[SceneGraph]: Setting the renderable of an invalid node ({})", node);
+            return;
+        }
+        const size_t index = m_indices[node];
+        m_meshes[index] = mesh;
+        m_materials[index] = material;
+    }
+
+    void SceneGraph::update() {
+        const size_t count = size();
+        size_t rebuildEnd = 0; // Nodes before this index sit under a node rebuilt this sweep, so are rebuilt too
+
+        for (size_t i = 0; i < count;) {
+            const bool inherited = i < rebuildEnd;
+            if (!inherited && !(m_flags[i] & SubtreeDirty)) {
+                i += m_sizes[i]; // Nothing edited in here, skip the whole range
+                continue;
+            }
+
+            if (inherited || (m_flags[i] & Dirty)) {
+                // Parents come first, so theirs is already this frame's
+                const Node parent = m_parents[i];
+                const glm::mat4& model = m_locals[i].ModelMatrix();
+                m_worlds[i] = parent == InvalidNode ? model : m_worlds[m_indices[parent]] * model;
+                if (!inherited) rebuildEnd = i + m_sizes[i];
+            }
+
+            m_flags[i] = 0;
+            ++i;
+        }
+    }
+
+    const glm::mat4& SceneGraph::world(Node node) const {
+        if (!valid(node)) {
+            TraceLog(LogLevel::WARNING, "[SceneGraph]: Getting the world matrix of an invalid node ({})", node);
+            static const glm::mat4 identity(1.f);
+            return identity;
+        }
+        return m_worlds[m_indices[node]];
+    }
+
+    size_t SceneGraph::indexOf(Node node) const {
+        return valid(node) ? m_indices[node] : SIZE_MAX;
+    }
+
+    size_t SceneGraph::subtreeSize(Node node) const {
+        return valid(node) ? m_sizes[m_indices[node]] : 0;
+    }
+
+    void SceneGraph::markDirty(size_t index) {
+        m_flags[index] |= Dirty | SubtreeDirty;
+
+        // Stop at the first ancestor already flagged, everything above it is too
+        Node parent = m_parents[index];
+        while (parent != InvalidNode) {
+            const size_t p = m_indices[parent];
+            if (m_flags[p] & SubtreeDirty) break;
+            m_flags[p] |= SubtreeDirty;
+            parent = m_parents[p];
+        }
+    }
+
+    void SceneGraph::resizeAncestors(Node parent, int64_t delta) {
+        while (parent != InvalidNode) {
+            const size_t p = m_indices[parent];
+            m_sizes[p] = static_cast<uint32_t>(m_sizes[p] + delta);
+            parent = m_parents[p];
+        }
+    }
+
+    void SceneGraph::reindex(size_t first, size_t last) {
+        for (size_t i = first; i < last; ++i) m_indices[m_handles[i]] = static_cast<uint32_t>(i);
+    }
+}
@@ -4,8 +4,13 @@
 
 #include <core/Shader.hpp>
 #include <core/Error.hpp>
+#include <core/ShaderCache.hpp>
 #include <core/VFS.hpp>
+#include <renderer/GLStateCache.hpp>
+#include <renderer/UniformBlocks.hpp>
 
+#include <atomic>
+#include <cstring>
 #include <fstream>
 #include <sstream>
 
@@ -71,85 +76,263 @@ namespace Dexium::Core {
         }
     }
 
+    namespace {
+        // GL_COMPLETION_STATUS_KHR (GL_KHR_parallel_shader_compile / GL_ARB_parallel_shader_compile), glad is core only
+        constexpr GLenum CompletionStatus = 0x91B1;
+
+        // Checked once, Dexium only ever creates one context
+        bool parallelCompileSupported() {
+            static const bool supported = [] {
+                GLint count = 0;
+                glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+                for (GLint i = 0; i < count; ++i) {
+                    const auto* ext = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, static_cast<GLuint>(i)));
+                    if (!ext) continue;
+                    if (std::strcmp(ext, "GL_KHR_parallel_shader_compile") == 0 || std::strcmp(ext, "GL_ARB_parallel_shader_compile") == 0) return true;
+                }
+                return false;
+            }();
+            return supported;
+        }
+    }
+
     void Shader::compile() {
+        if (beginCompile()) finishCompile(); // The status queries block until the driver is done
+    }
+
+    void Shader::compileAsync() {
+        beginCompile(); // Finished by isCompiled() once the driver says it's done
+    }
+
+    bool Shader::isCompiled() {
+        if (m_pending) {
+            // Without the extension there's no way to ask without blocking, so the first poll just waits.
+            // Still cheaper than compile(): drivers with compiler threads have had a frame or more to get on with it
+            GLint done = GL_TRUE;
+            if (parallelCompileSupported()) glGetProgramiv(ID, CompletionStatus, &done);
+            if (done) finishCompile();
+        }
+        return compiled;
+    }
+
+    bool Shader::beginCompile() {
         if (vertexCode.empty()) {
             TraceLog(LogLevel::ERROR, "[Shader][Vertex]: Vertex buffer is empty, cannot compile shader with no vertex");
-            return;
+            return false;
         }
         if (fragmentCode.empty()) {
             TraceLog(LogLevel::ERROR, "[Shader][Fragment]: Fragment buffer is empty, cannot compile shader with no fragment");
-            return;
+            return false;
         }
 
-        // Clear the uniform cache (if hot-relaoding, stale cache will reflect old locations, if not cleared)
-        uniformCache.clear();
+        // Clear the uniform table (if hot-relaoding, stale entries will reflect old locations, if not cleared)
+        m_uniforms.clear();
+        compiled = false;
+
+        // A cached binary skips compiling & linking entirely (See core/ShaderCache.hpp)
+        m_caching = ShaderCache::enabled();
+        m_cacheKey = m_caching ? ShaderCache::key(vertexCode, fragmentCode) : 0;
+        if (m_caching) {
+            if (GLuint program = ShaderCache::load(m_cacheKey)) {
+                ID = program;
+                bindUniformBlocks();
+                reflectUniforms();
+
+                compiled = true;
+                TraceLog(LogLevel::DEBUG, "[Shader]: Loaded shader program from the binary cache");
+                return false;
+            }
+            // Missed, compile normally
+        }
 
-        // ZCompile sahders
+        // ZCompile sahders. No status checks here, each one would stall until the driver has finished
         const char* vShaderSource = vertexCode.c_str();
         const char* fShaderSource = fragmentCode.c_str();
 
-        unsigned int vertex, fragment;
-        int success;
-        char infoLog[512]; // Error msg buffer
-
         //Vertex
-        vertex = glCreateShader(GL_VERTEX_SHADER);
-        glShaderSource(vertex, 1, &vShaderSource, NULL);
-        glCompileShader(vertex);
-        glGetShaderiv(vertex, GL_COMPILE_STATUS, &success);
-        if (!success) {
-            glGetShaderInfoLog(vertex, 512, NULL, infoLog);
-            TraceLog(LogLevel::ERROR, "[Shader Compiler](Vertex): ---VERTEX ERROR STACK: ---\n{}", infoLog);
-            glDeleteShader(vertex);
-            return;
-        }
+        m_vertex = glCreateShader(GL_VERTEX_SHADER);
+        glShaderSource(m_vertex, 1, &vShaderSource, NULL);
+        glCompileShader(m_vertex);
 
         // Fragment
-        fragment = glCreateShader(GL_FRAGMENT_SHADER);
-        glShaderSource(fragment, 1, &fShaderSource, NULL);
-        glCompileShader(fragment);
-        glGetShaderiv(fragment, GL_COMPILE_STATUS, &success);
-        if (!success) {
-            glGetShaderInfoLog(fragment, 512, NULL, infoLog);
-            TraceLog(LogLevel::ERROR, "[Shader Compiler](Fragment): --- FRAGMENT ERROR STACK: ---\n{}", infoLog);
-            glDeleteShader(vertex);
-            glDeleteShader(fragment);
-            return;
-        }
+        m_fragment = glCreateShader(GL_FRAGMENT_SHADER);
+        glShaderSource(m_fragment, 1, &fShaderSource, NULL);
+        glCompileShader(m_fragment);
 
-        // Create and Link program
+        // Create and Link program (a stage that failed to compile just fails the link, finishCompile() sorts out which)
         ID = glCreateProgram();
-        glAttachShader(ID, vertex);
-        glAttachShader(ID, fragment);
+        glAttachShader(ID, m_vertex);
+        glAttachShader(ID, m_fragment);
+        if (m_caching) glProgramParameteri(ID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
         glLinkProgram(ID);
+
+        m_pending = true;
+        return true;
+    }
+
+    void Shader::finishCompile() {
+        m_pending = false;
+
+        int success;
+        char infoLog[512]; // Error msg buffer
+
         glGetProgramiv(ID, GL_LINK_STATUS, &success);
         if (!success) {
-            glGetProgramInfoLog(ID, 512, NULL, infoLog);
-            TraceLog(LogLevel::ERROR, "[Shader Compiler](Program): --- PROGRAM ERROR STACK: ---\n{}", infoLog);
+            // Report the first stage that failed, or the link itself
+            glGetShaderiv(m_vertex, GL_COMPILE_STATUS, &success);
+            if (!success) {
+                glGetShaderInfoLog(m_vertex, 512, NULL, infoLog);
+                TraceLog(LogLevel::ERROR, "[Shader Compiler](Vertex): ---VERTEX ERROR STACK: ---\n{}", infoLog);
+            } else {
+                glGetShaderiv(m_fragment, GL_COMPILE_STATUS, &success);
+                if (!success) {
+                    glGetShaderInfoLog(m_fragment, 512, NULL, infoLog);
+                    TraceLog(LogLevel::ERROR, "[Shader Compiler](Fragment): --- FRAGMENT ERROR STACK: ---\n{}", infoLog);
+                } else {
+                    glGetProgramInfoLog(ID, 512, NULL, infoLog);
+                    TraceLog(LogLevel::ERROR, "[Shader Compiler](Program): --- PROGRAM ERROR STACK: ---\n{}", infoLog);
+                }
+            }
+
+            glDeleteShader(m_vertex);
+            glDeleteShader(m_fragment);
+            m_vertex = m_fragment = 0;
             glDeleteProgram(ID); // Forces the Shader obj to become invalid
             ID = 0;
             return;
         }
 
         // Detach sahders (not strictly required since we delete them afterwards)
-        glDetachShader(ID, vertex);
-        glDetachShader(ID, fragment);
+        glDetachShader(ID, m_vertex);
+        glDetachShader(ID, m_fragment);
 
         // Delete shader components now that they're linked!
-        glDeleteShader(vertex);
-        glDeleteShader(fragment);
+        glDeleteShader(m_vertex);
+        glDeleteShader(m_fragment);
+        m_vertex = m_fragment = 0;
+
+        bindUniformBlocks();
+        reflectUniforms();
+
+        if (m_caching) ShaderCache::store(ID, m_cacheKey);
 
         compiled = true;
         TraceLog(LogLevel::DEBUG, "[Shader]: Successfully compiled shader program");
     }
 
+    void Shader::bindUniformBlocks() {
+        cameraBlock = false;
+
+        for (const auto& block : Renderer::UniformBlocks::All) {
+            GLuint index = glGetUniformBlockIndex(ID, block.name);
+            if (index == GL_INVALID_INDEX) continue; // Not declared (or optimized out)
+
+            glUniformBlockBinding(ID, index, block.binding);
+
+            if (block.binding == Renderer::UniformBlocks::Camera.binding) cameraBlock = true;
+        }
+    }
+
+    void Shader::reflectUniforms() {
+        GLint count = 0, maxLength = 0;
+        glGetProgramiv(ID, GL_ACTIVE_UNIFORMS, &count);
+        glGetProgramiv(ID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+
+        std::string name(static_cast<size_t>(maxLength > 0 ? maxLength : 256), '\0');
+        m_uniforms.reserve(static_cast<size_t>(count));
+
+        m_materialBlock.clear();
+        m_materialBlockSize = 0;
+        const GLuint materialIndex = glGetUniformBlockIndex(ID, Renderer::UniformBlocks::Material.name);
+        if (materialIndex != GL_INVALID_INDEX) {
+            glGetActiveUniformBlockiv(ID, materialIndex, GL_UNIFORM_BLOCK_DATA_SIZE, &m_materialBlockSize);
+        }
+
+        for (GLint i = 0; i < count; ++i) {
+            GLsizei length = 0;
+            GLint size = 0;
+            GLenum type = 0;
+            glGetActiveUniform(ID, static_cast<GLuint>(i), static_cast<GLsizei>(name.size()), &length, &size, &type, name.data());
+
+            UniformSlot slot;
+            slot.name.assign(name.data(), static_cast<size_t>(length));
+            // Arrays are reported as "name[0]", but set (like everywhere else in Dexium) by their plain name
+            if (slot.name.size() > 3 && slot.name.compare(slot.name.size() - 3, 3, "[0]") == 0) slot.name.resize(slot.name.size() - 3);
+
+            if (materialIndex != GL_INVALID_INDEX) {
+                const GLuint index = static_cast<GLuint>(i);
+                GLint block = -1;
+                glGetActiveUniformsiv(ID, 1, &index, GL_UNIFORM_BLOCK_INDEX, &block);
+                if (block == static_cast<GLint>(materialIndex)) {
+                    BlockMember member;
+                    glGetActiveUniformsiv(ID, 1, &index, GL_UNIFORM_OFFSET, &member.offset);
+                    member.hash = uniformHash(slot.name);
+                    member.type = type;
+                    member.name = std::move(slot.name);
+                    m_materialBlock.push_back(std::move(member));
+                    continue;
+                }
+            }
+
+            slot.location = glGetUniformLocation(ID, slot.name.c_str());
+            if (slot.location < 0) continue; // Other uniform block members live in their buffer, not here
+
+            slot.hash = uniformHash(slot.name);
+            slot.type = type;
+            m_uniforms.push_back(std::move(slot));
+        }
+
+        // Shared, so a Material switched to another Shader can't mistake it for the one it packed for
+        static std::atomic<uint32_t> s_reflectionGeneration{0};
+        m_reflectionGeneration = s_reflectionGeneration.fetch_add(1, std::memory_order_relaxed) + 1;
+    }
+
+    int32_t Shader::findUniform(std::string_view name) {
+        const uint32_t hash = uniformHash(name);
+
+        for (size_t i = 0; i < m_uniforms.size(); ++i) {
+            const auto& slot = m_uniforms[i];
+            if (slot.hash == hash && slot.name == name) return slot.location >= 0 ? static_cast<int32_t>(i) : -1;
+        }
+
+        // Not reflected (array elements, struct members, or a compile() that never happened), so ask GL once and remember the answer
+        UniformSlot slot;
+        slot.name = std::string(name);
+        slot.hash = hash;
+        slot.location = ID != 0 ? glGetUniformLocation(ID, slot.name.c_str()) : -1;
+        m_uniforms.push_back(std::move(slot));
+
+        if (m_uniforms.back().location < 0) {
+            // Only warned about the first time, the -1 entry answers every later lookup
+            TraceLog(LogLevel::WARNING, "[Shader]: Uniform '{}' not found in shader", name);
+            return -1;
+        }
+        return static_cast<int32_t>(m_uniforms.size() - 1);
+    }
+
+    void Shader::invalidateUniforms() {
+        for (auto& slot : m_uniforms) slot.shadowValid = false;
+    }
+
+    bool Shader::isFloatType(GLenum type) {
+        switch (type) {
+            case GL_FLOAT: case GL_FLOAT_VEC2: case GL_FLOAT_VEC3: case GL_FLOAT_VEC4:
+            case GL_FLOAT_MAT2: case GL_FLOAT_MAT3: case GL_FLOAT_MAT4:
+            case GL_FLOAT_MAT2x3: case GL_FLOAT_MAT2x4: case GL_FLOAT_MAT3x2:
+            case GL_FLOAT_MAT3x4: case GL_FLOAT_MAT4x2: case GL_FLOAT_MAT4x3:
+                return true;
+            default:
+                return false;
+        }
+    }
+
     void Shader::bind() const {
         if (ID == 0) {
             TraceLog(LogLevel::WARNING, "[Shader]: Attempting to bind an invalid shader");
             return;
         }
 
-        glUseProgram(ID);
+        Renderer::GLStateCache::get().useProgram(ID);
     }
 
     namespace Shaders {
@@ -166,7 +349,11 @@ namespace Dexium::Core {
                 uniform mat4 model;
                 uniform mat4 projection;
 
-                uniform vec4 uvRect; // x=left, y=top, z=right, w=bottom
+                layout (std140) uniform MaterialBlock {
+                    vec4 uColor;
+                    vec4 uvRect; // x=left, y=top, z=right, w=bottom
+                    int u_Layer;
+                };
 
                 void main() {
                     gl_Position = projection * model * vec4(aPos, 1.0);
@@ -192,7 +379,12 @@ namespace Dexium::Core {
                 out vec4 FragColor;
 
                 uniform sampler2D texture1;
-                uniform vec4 uColor;
+
+                layout (std140) uniform MaterialBlock {
+                    vec4 uColor;
+                    vec4 uvRect; // x=left, y=top, z=right, w=bottom
+                    int u_Layer;
+                };
 
                 void main(){
 	                vec4 fragCol = texture(texture1, TexCoord);
@@ -200,12 +392,130 @@ namespace Dexium::Core {
                 }
             )";
 
+            const std::string SHADER_2D_INSTANCED_VERTEX = R"(
+                #version 330 core
+                layout (location = 0) in vec3 aPos;
+                layout (location = 1) in vec2 aUV;
+                layout (location = 2) in mat4 aModel; // Per-instance, occupies locations 2-5
+
+                out vec2 TexCoord;
+
+                layout (std140) uniform CameraBlock {
+                    mat4 u_Projection;
+                    mat4 u_View;
+                };
+
+                layout (std140) uniform MaterialBlock {
+                    vec4 uColor;
+                    vec4 uvRect; // x=left, y=top, z=right, w=bottom
+                    int u_Layer;
+                };
+
+                void main() {
+                    gl_Position = u_Projection * u_View * aModel * vec4(aPos, 1.0);
+
+                    if (uvRect.z > uvRect.x && uvRect.w > uvRect.y){
+                        TexCoord = vec2(
+                            uvRect.x + aUV.x * (uvRect.z - uvRect.x),
+                            uvRect.y + aUV.y * (uvRect.w - uvRect.y)
+                        );
+                    } else {
+                        TexCoord = aUV + vec2(0.5);
+                    }
+                }
+            )";
+
+            const std::string SHADER_2D_BATCH_VERTEX = R"(
+                #version 330 core
+                layout (location = 0) in vec3 aPos;
+                layout (location = 1) in vec2 aUV;
+                layout (location = 2) in vec4 aColour;
+                layout (location = 3) in float aLayer;
+
+                out vec2 TexCoord;
+                out vec4 Tint;
+                flat out float Layer;
+
+                layout (std140) uniform CameraBlock {
+                    mat4 u_Projection;
+                    mat4 u_View;
+                };
+
+                void main() {
+                    gl_Position = u_Projection * u_View * vec4(aPos, 1.0);
+                    TexCoord = aUV;
+                    Tint = aColour;
+                    Layer = aLayer;
+                }
+            )";
+
+            const std::string SHADER_2D_BATCH_FRAGMENT = R"(#version 330 core
+                in vec2 TexCoord;
+                in vec4 Tint;
+
+                out vec4 FragColor;
+
+                uniform sampler2D u_Texture;
+
+                void main(){
+                    FragColor = texture(u_Texture, TexCoord) * Tint;
+                }
+            )";
+
+            const std::string SHADER_2D_BATCH_ARRAY_FRAGMENT = R"(#version 330 core
+                in vec2 TexCoord;
+                in vec4 Tint;
+                flat in float Layer;
+
+                out vec4 FragColor;
+
+                uniform sampler2DArray u_Texture;
+
+                void main(){
+                    FragColor = texture(u_Texture, vec3(TexCoord, Layer)) * Tint;
+                }
+            )";
+
+            const std::string SHADER_2D_ARRAY_FRAGMENT = R"(#version 330 core
+                in vec2 TexCoord;
+
+                out vec4 FragColor;
+
+                uniform sampler2DArray texture1;
+
+                layout (std140) uniform MaterialBlock {
+                    vec4 uColor;
+                    vec4 uvRect; // x=left, y=top, z=right, w=bottom
+                    int u_Layer;
+                };
+
+                void main(){
+                    FragColor = texture(texture1, vec3(TexCoord, float(u_Layer))) * uColor;
+                }
+            )";
+
         }
 
         Shader generateDefault2DShader() {
             return Shader(PREBUILT_2D::SHADER_2D_VERTEX, PREBUILT_2D::SHADER_2D_FRAGMENT, false);
         }
 
+        Shader generateDefault2DInstancedShader() {
+            return Shader(PREBUILT_2D::SHADER_2D_INSTANCED_VERTEX, PREBUILT_2D::SHADER_2D_FRAGMENT, false);
+        }
+
+        Shader generateDefault2DBatchShader() {
+            return Shader(PREBUILT_2D::SHADER_2D_BATCH_VERTEX, PREBUILT_2D::SHADER_2D_BATCH_FRAGMENT, false);
+        }
+
+        Shader generateDefault2DArrayShader() {
+            return Shader(PREBUILT_2D::SHADER_2D_VERTEX, PREBUILT_2D::SHADER_2D_ARRAY_FRAGMENT, false);
+        }
+
+        Shader generateDefault2DBatchArrayShader() {
+            return Shader(PREBUILT_2D::SHADER_2D_BATCH_VERTEX, PREBUILT_2D::SHADER_2D_BATCH_ARRAY_FRAGMENT, false);
+        }
+
     }
 
 }
\ No newline at end of file
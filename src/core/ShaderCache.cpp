@@ -0,0 +1,185 @@
+//
+// Created by Dextron12 on 17/10/26.
+//
+
+#include <core/ShaderCache.hpp>
+#include <core/Error.hpp>
+#include <core/VFS.hpp>
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <fstream>
+#include <system_error>
+#include <vector>
+
+namespace Dexium::Core {
+
+    // Static definitions
+    bool ShaderCache::m_enabled = false;
+    std::filesystem::path ShaderCache::m_dir;
+    std::string ShaderCache::m_driver;
+
+    namespace {
+        // Bumped whenever the file layout changes, so old caches just miss
+        constexpr uint32_t FileVersion = 1;
+        constexpr char Magic[4] = {'D', 'X', 'P', 'B'};
+        constexpr uint32_t MaxBinarySize = 64u << 20; // Anything bigger is a corrupt header
+
+        struct Header {
+            char magic[4];
+            uint32_t version;
+            uint64_t key; // Guards against renamed/colliding files
+            uint32_t format; // GLenum binaryFormat
+            uint32_t length;
+        };
+
+        uint64_t fnv1a(uint64_t hash, const std::string& data) {
+            for (char c : data) {
+                hash ^= static_cast<uint8_t>(c);
+                hash *= 1099511628211ull;
+            }
+            // Separator, so ("ab", "c") & ("a", "bc") don't hash the same
+            hash ^= 0xFF;
+            hash *= 1099511628211ull;
+            return hash;
+        }
+
+        std::string glString(GLenum name) {
+            const auto* str = glGetString(name);
+            return str ? reinterpret_cast<const char*>(str) : "";
+        }
+    }
+
+    bool ShaderCache::enable(const std::filesystem::path& dir) {
+        // Program binaries are core in 4.1 & some drivers still support zero formats
+        GLint formats = 0;
+        if (GLAD_GL_VERSION_4_1) glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+        if (formats <= 0) {
+            TraceLog(LogLevel::WARNING, "[ShaderCache]: The driver doesn't support program binaries, shaders will always be compiled");
+            m_enabled = false;
+            return false;
+        }
+
+        if (VFS::getExecutablePath().empty()) {
+            TraceLog(LogLevel::ERROR, "[ShaderCache]: Engine root directoy is NOT defined.\nDid you forget to call VFS::init()?");
+            m_enabled = false;
+            return false;
+        }
+
+        // VFS::resolve() wants the path to exist already, so join it ourselves
+        m_dir = (VFS::getExecutablePath() / dir).lexically_normal();
+        std::error_code ec;
+        std::filesystem::create_directories(m_dir, ec);
+        if (ec) {
+            TraceLog(LogLevel::ERROR, "[ShaderCache]: Cannot create the cache directory '{}', Reason: {}", m_dir.string(), ec.message());
+            m_enabled = false;
+            return false;
+        }
+
+        m_driver = glString(GL_VENDOR) + "|" + glString(GL_RENDERER) + "|" + glString(GL_VERSION);
+        m_enabled = true;
+        TraceLog(LogLevel::DEBUG, "[ShaderCache]: Caching program binaries in '{}'", m_dir.string());
+        return true;
+    }
+
+    void ShaderCache::disable() {
+        m_enabled = false;
+    }
+
+    uint64_t ShaderCache::key(const std::string& vertex, const std::string& fragment) {
+        uint64_t hash = 14695981039346656037ull;
+        hash = fnv1a(hash, m_driver);
+        hash = fnv1a(hash, vertex);
+        hash = fnv1a(hash, fragment);
+        return hash;
+    }
+
+    std::filesystem::path ShaderCache::entryPath(uint64_t key) {
+        return m_dir / fmt::format("{:016x}.bin", key);
+    }
+
+    GLuint ShaderCache::load(uint64_t key) {
+        if (!m_enabled) return 0;
+
+        const auto path = entryPath(key);
+        std::ifstream file(path, std::ios::binary);
+        if (!file) return 0; // Plain miss
+
+        Header header{};
+        std::vector<char> binary;
+        if (file.read(reinterpret_cast<char*>(&header), sizeof(header)) &&
+            std::equal(std::begin(Magic), std::end(Magic), header.magic) && header.version == FileVersion && header.key == key &&
+            header.length <= MaxBinarySize) {
+            binary.resize(header.length);
+            if (!file.read(binary.data(), static_cast<std::streamsize>(binary.size()))) binary.clear();
+        }
+        file.close();
+
+        if (!binary.empty()) {
+            GLuint program = glCreateProgram();
+            glProgramBinary(program, static_cast<GLenum>(header.format), binary.data(), static_cast<GLsizei>(binary.size()));
+
+            GLint success = 0;
+            glGetProgramiv(program, GL_LINK_STATUS, &success);
+            if (success) return program;
+            glDeleteProgram(program);
+        }
+
+        // Truncated, from another build or rejected by the driver. Drop it so the normal compile can replace it
+        TraceLog(LogLevel::DEBUG, "[ShaderCache]: Discarding unusable cache entry '{}'", path.string());
+        std::error_code ec;
+        std::filesystem::remove(path, ec);
+        return 0;
+    }
+
+    void ShaderCache::store(GLuint program, uint64_t key) {
+        if (!m_enabled) return;
+
+        GLint length = 0;
+        glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+        if (length <= 0) return;
+
+        std::vector<char> binary(static_cast<size_t>(length));
+        GLsizei written = 0;
+        GLenum format = 0;
+        glGetProgramBinary(program, length, &written, &format, binary.data());
+        if (written <= 0) return;
+
+        Header header{};
+        std::copy(std::begin(Magic), std::end(Magic), header.magic);
+        header.version = FileVersion;
+        header.key = key;
+        header.format = format;
+        header.length = static_cast<uint32_t>(written);
+
+        // Write to a temp file first, so a crash mid write can't leave a truncated entry behind
+        const auto path = entryPath(key);
+        auto temp = path;
+        temp += ".tmp";
+        std::error_code ec;
+        {
+            std::ofstream file(temp, std::ios::binary | std::ios::trunc);
+            if (!file) {
+                TraceLog(LogLevel::WARNING, "[ShaderCache]: Cannot write cache entry '{}'", temp.string());
+                return;
+            }
+            file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            file.write(binary.data(), written);
+            file.close(); // Flushes, so a full disk shows up here rather than as a short entry
+
+            if (!file) {
+                // Never rename a partial entry into place
+                TraceLog(LogLevel::WARNING, "[ShaderCache]: Failed writing cache entry '{}'", temp.string());
+                std::filesystem::remove(temp, ec);
+                return;
+            }
+        }
+
+        std::filesystem::rename(temp, path, ec);
+        if (ec) {
+            TraceLog(LogLevel::WARNING, "[ShaderCache]: Cannot write cache entry '{}', Reason: {}", path.string(), ec.message());
+            std::filesystem::remove(temp, ec);
+        }
+    }
+}
@@ -0,0 +1,304 @@
+//
+// Created by Dextron12 on 17/10/26.
+//
+
+#include <core/SpriteBatch.hpp>
+
+#include <core/Texture.hpp>
+#include <core/Transform.h>
+#include <core/Error.hpp>
+
+#include <renderer/GLStateCache.hpp>
+#include <renderer/UniformBlocks.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+namespace Dexium::Core {
+
+    namespace {
+        uint32_t packColour(const Colour& c) {
+            return static_cast<uint32_t>(c.rByte()) |
+                   (static_cast<uint32_t>(c.gByte()) << 8) |
+                   (static_cast<uint32_t>(c.bByte()) << 16) |
+                   (static_cast<uint32_t>(c.aByte()) << 24);
+        }
+    }
+
+    SpriteBatch::SpriteBatch(size_t maxSprites)
+        : m_maxSprites(maxSprites == 0 ? 1 : maxSprites) {}
+
+    SpriteBatch::SpriteBatch(SpriteBatch&& other) noexcept
+        : sortByTexture(other.sortByTexture), shader(other.shader), arrayShader(other.arrayShader),
+          m_maxSprites(other.m_maxSprites), m_sprites(std::move(other.m_sprites)), m_order(std::move(other.m_order)),
+          m_vertices(std::move(other.m_vertices)), m_VAO(other.m_VAO), m_EBO(other.m_EBO),
+          m_defaultShader(std::move(other.m_defaultShader)), m_defaultArrayShader(std::move(other.m_defaultArrayShader)) {
+        other.m_VAO = 0;
+        other.m_EBO = 0;
+        // The defaults moved with us, so the source makes fresh ones if it's used again
+        if (other.shader == m_defaultShader.get()) other.shader = nullptr;
+        if (other.arrayShader == m_defaultArrayShader.get()) other.arrayShader = nullptr;
+    }
+
+    SpriteBatch& SpriteBatch::operator=(SpriteBatch&& other) noexcept {
+        if (this != &other) {
+            destroy();
+            sortByTexture = other.sortByTexture;
+            shader = other.shader;
+            arrayShader = other.arrayShader;
+            m_maxSprites = other.m_maxSprites;
+            m_sprites = std::move(other.m_sprites);
+            m_order = std::move(other.m_order);
+            m_vertices = std::move(other.m_vertices);
+            m_VAO = other.m_VAO;
+            m_EBO = other.m_EBO;
+            m_defaultShader = std::move(other.m_defaultShader);
+            m_defaultArrayShader = std::move(other.m_defaultArrayShader);
+            m_activeShader = nullptr;
+
+            other.m_VAO = 0;
+            other.m_EBO = 0;
+            if (other.shader == m_defaultShader.get()) other.shader = nullptr;
+            if (other.arrayShader == m_defaultArrayShader.get()) other.arrayShader = nullptr;
+        }
+        return *this;
+    }
+
+    void SpriteBatch::destroy() {
+        auto& gl = Renderer::GLStateCache::get();
+        if (m_VAO != 0) {
+            glDeleteVertexArrays(1, &m_VAO);
+            gl.forgetVertexArray(m_VAO);
+            m_VAO = 0;
+        }
+        if (m_EBO != 0) {
+            glDeleteBuffers(1, &m_EBO);
+            gl.forgetBuffer(m_EBO);
+            m_EBO = 0;
+        }
+        m_vertices.destroy();
+        m_activeShader = nullptr;
+    }
+
+    void SpriteBatch::draw(Texture* texture, const glm::vec2& pos, const glm::vec2& size, const glm::vec4& uvRect,
+                           const Colour& colour, float rotation, const glm::vec2& origin, float depth) {
+        if (!texture) {
+            TraceLog(LogLevel::DEBUG, "[SpriteBatch]: Texture ptr is invalid. Cannot queue sprite");
+            return;
+        }
+        queue(texture, 0.f, pos, size, uvRect, colour, rotation, origin, depth);
+    }
+
+    void SpriteBatch::draw(const TextureArrayPool::Layer& layer, const glm::vec2& pos, const glm::vec2& size,
+                           const glm::vec4& uvRect, const Colour& colour, float rotation, const glm::vec2& origin, float depth) {
+        if (!layer.valid()) {
+            TraceLog(LogLevel::DEBUG, "[SpriteBatch]: Array layer is invalid. Cannot queue sprite");
+            return;
+        }
+        queue(layer.array, static_cast<float>(layer.layer), pos, size, uvRect, colour, rotation, origin, depth);
+    }
+
+    void SpriteBatch::queue(Texture* texture, float layer, const glm::vec2& pos, const glm::vec2& size, const glm::vec4& uvRect,
+                            const Colour& colour, float rotation, const glm::vec2& origin, float depth) {
+        QueuedSprite sprite;
+        sprite.texture = texture;
+        sprite.uvRect = uvRect;
+        sprite.colour = packColour(colour);
+        sprite.layer = layer;
+
+        // Local corners relative to the origin
+        const glm::vec2 local[4] = {
+            {-origin.x, -origin.y},
+            {size.x - origin.x, -origin.y},
+            {size.x - origin.x, size.y - origin.y},
+            {-origin.x, size.y - origin.y}
+        };
+
+        if (rotation == 0.f) {
+            for (int c = 0; c < 4; ++c) {
+                sprite.corners[c] = {pos.x + origin.x + local[c].x, pos.y + origin.y + local[c].y, depth};
+            }
+        } else {
+            const float rad = glm::radians(rotation);
+            const float s = std::sin(rad), co = std::cos(rad);
+            for (int c = 0; c < 4; ++c) {
+                sprite.corners[c] = {
+                    pos.x + origin.x + local[c].x * co - local[c].y * s,
+                    pos.y + origin.y + local[c].x * s + local[c].y * co,
+                    depth
+                };
+            }
+        }
+
+        m_sprites.push_back(sprite);
+    }
+
+    void SpriteBatch::draw(Texture* texture, Transform& transform, const glm::vec4& uvRect, const Colour& colour) {
+        if (!texture) {
+            TraceLog(LogLevel::DEBUG, "[SpriteBatch]: Texture ptr is invalid. Cannot queue sprite");
+            return;
+        }
+
+        const glm::mat4 model = transform.ModelMatrix();
+
+        QueuedSprite sprite;
+        sprite.texture = texture;
+        sprite.uvRect = uvRect;
+        sprite.colour = packColour(colour);
+        sprite.layer = 0.f;
+
+        // Unit quad corners, same space as MeshData::quadVertices
+        const glm::vec4 local[4] = {
+            {0.f, 0.f, 0.f, 1.f}, {1.f, 0.f, 0.f, 1.f}, {1.f, 1.f, 0.f, 1.f}, {0.f, 1.f, 0.f, 1.f}
+        };
+        for (int c = 0; c < 4; ++c) {
+            const glm::vec4 p = model * local[c];
+            sprite.corners[c] = {p.x, p.y, p.z};
+        }
+
+        m_sprites.push_back(sprite);
+    }
+
+    void SpriteBatch::clear() {
+        m_sprites.clear();
+    }
+
+    void SpriteBatch::initGL() {
+        // Default shader (compiled on first use, as it needs a live context)
+        if (!shader) {
+            m_defaultShader = std::make_unique<Shader>(Shaders::generateDefault2DBatchShader());
+            m_defaultShader->compile();
+            shader = m_defaultShader.get();
+        }
+
+        auto& gl = Renderer::GLStateCache::get();
+
+        glGenVertexArrays(1, &m_VAO);
+        gl.bindVertexArray(m_VAO);
+
+        m_vertices.create(GL_ARRAY_BUFFER, m_maxSprites * 4 * sizeof(Vertex));
+
+        // Quad index pattern (0,1,2, 2,3,0), chunks offset into it with the base vertex instead of new indices
+        std::vector<uint32_t> indices(m_maxSprites * 6);
+        for (size_t q = 0; q < m_maxSprites; ++q) {
+            const auto v = static_cast<uint32_t>(q * 4);
+            uint32_t* idx = &indices[q * 6];
+            idx[0] = v; idx[1] = v + 1; idx[2] = v + 2;
+            idx[3] = v + 2; idx[4] = v + 3; idx[5] = v;
+        }
+
+        glGenBuffers(1, &m_EBO);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_EBO);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(uint32_t), indices.data(), GL_STATIC_DRAW);
+
+        gl.bindBuffer(GL_ARRAY_BUFFER, m_vertices.id());
+        // Pos
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, position));
+        glEnableVertexAttribArray(0);
+        // UVs
+        glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, uv));
+        glEnableVertexAttribArray(1);
+        // Colour (normalized bytes)
+        glVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(Vertex), (void*)offsetof(Vertex, colour));
+        glEnableVertexAttribArray(2);
+        // Array layer
+        glVertexAttribPointer(3, 1, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, layer));
+        glEnableVertexAttribArray(3);
+
+        gl.bindBuffer(GL_ARRAY_BUFFER, 0);
+        gl.bindVertexArray(0);
+    }
+
+    void SpriteBatch::render(const glm::mat4& projection, const glm::mat4& view) {
+        if (m_sprites.empty()) return;
+
+        if (m_VAO == 0) initGL();
+
+        if (!shader->isCompiled()) {
+            TraceLog(LogLevel::WARNING, "[SpriteBatch]: Batch shader isn't compiled, dropping {} sprites", m_sprites.size());
+            m_sprites.clear();
+            return;
+        }
+
+        // Draw order, grouped by texture if requested (stable so equal textures keep submission order)
+        m_order.resize(m_sprites.size());
+        for (uint32_t i = 0; i < m_order.size(); ++i) m_order[i] = i;
+        if (sortByTexture) {
+            std::stable_sort(m_order.begin(), m_order.end(), [this](uint32_t a, uint32_t b) {
+                return m_sprites[a].texture < m_sprites[b].texture;
+            });
+        }
+
+        m_activeShader = nullptr;
+
+        auto& gl = Renderer::GLStateCache::get();
+        gl.bindVertexArray(m_VAO);
+
+        // Stream the sprites one region (chunk) at a time
+        for (size_t chunkStart = 0; chunkStart < m_order.size(); chunkStart += m_maxSprites) {
+            const size_t chunkCount = std::min(m_maxSprites, m_order.size() - chunkStart);
+
+            auto* dst = static_cast<Vertex*>(m_vertices.beginRegion());
+            for (size_t i = 0; i < chunkCount; ++i) {
+                const auto& s = m_sprites[m_order[chunkStart + i]];
+                const auto& uv = s.uvRect;
+                // Corners are tl, tr, br, bl. Textures are flipped on load, so the top edge samples uv.w
+                dst[0] = {s.corners[0], {uv.x, uv.w}, s.colour, s.layer};
+                dst[1] = {s.corners[1], {uv.z, uv.w}, s.colour, s.layer};
+                dst[2] = {s.corners[2], {uv.z, uv.y}, s.colour, s.layer};
+                dst[3] = {s.corners[3], {uv.x, uv.y}, s.colour, s.layer};
+                dst += 4;
+            }
+            m_vertices.endRegion(chunkCount * 4 * sizeof(Vertex));
+
+            const auto baseVertex = static_cast<GLint>(m_vertices.regionOffset() / sizeof(Vertex));
+
+            // One draw per run of the same texture
+            size_t runStart = 0;
+            while (runStart < chunkCount) {
+                Texture* tex = m_sprites[m_order[chunkStart + runStart]].texture;
+                size_t runEnd = runStart + 1;
+                while (runEnd < chunkCount && m_sprites[m_order[chunkStart + runEnd]].texture == tex) ++runEnd;
+
+                if (tex->target == GL_TEXTURE_2D_ARRAY) {
+                    if (!arrayShader) {
+                        m_defaultArrayShader = std::make_unique<Shader>(Shaders::generateDefault2DBatchArrayShader());
+                        m_defaultArrayShader->compile();
+                        arrayShader = m_defaultArrayShader.get();
+                    }
+                    useShader(arrayShader, projection, view);
+                } else {
+                    useShader(shader, projection, view);
+                }
+
+                gl.bindTexture(0, tex->target, tex->texID);
+                glDrawElementsBaseVertex(GL_TRIANGLES, static_cast<GLsizei>((runEnd - runStart) * 6), GL_UNSIGNED_INT,
+                                         (void*)(runStart * 6 * sizeof(uint32_t)), baseVertex);
+
+                runStart = runEnd;
+            }
+
+            m_vertices.fence();
+        }
+
+        gl.bindVertexArray(0);
+
+        m_sprites.clear();
+    }
+
+    void SpriteBatch::useShader(Shader* next, const glm::mat4& projection, const glm::mat4& view) {
+        if (next == m_activeShader) return;
+        m_activeShader = next;
+
+        next->bind();
+        if (next->usesCameraBlock()) {
+            // No-op when a RenderPass already wrote these matrices
+            Renderer::CameraUniformBuffer::get().update(projection, view);
+        } else {
+            next->setUniform("u_Projection", projection);
+            next->setUniform("u_View", view);
+        }
+        next->setUniform("u_Texture", 0);
+    }
+}
@@ -9,6 +9,7 @@
 
 #include <core/VFS.hpp>
 #include <core/Error.hpp>
+#include <renderer/GLStateCache.hpp>
 
 #include <glad/gl.h> // Not sure what donkey defined this in the header ;{, so to any future donkeys... keep it here!!
 
@@ -23,25 +24,25 @@ void Dexium::Core::Texture::uploadParameters() const {
     //Filtering
     if (hasFlag(flags, Utils::TexFlags::Linear)) {
         GLint minFilter = hasFlag(flags, Utils::TexFlags::Mipmaps) ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR;
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, minFilter);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(target, GL_TEXTURE_MIN_FILTER, minFilter);
+        glTexParameteri(target, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
     } else if (hasFlag(flags, Utils::TexFlags::Nearest)) {
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(target, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(target, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
     }
 
     // Wrapping
     if (hasFlag(flags, Utils::TexFlags::Repeat)) {
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glTexParameteri(target, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(target, GL_TEXTURE_WRAP_T, GL_REPEAT);
     } else {
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(target, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(target, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
     }
 
     // mIPMAPS
     if (hasFlag(flags, Utils::TexFlags::Mipmaps)) {
-        glGenerateMipmap(GL_TEXTURE_2D);
+        glGenerateMipmap(target);
     }
 }
 
@@ -66,7 +67,7 @@ bool Dexium::Core::Texture::load(const std::filesystem::path& path) {
 
     //Generate & bind new texID
     glGenTextures(1, &texID);
-    glBindTexture(GL_TEXTURE_2D, texID);
+    Dexium::Renderer::GLStateCache::get().bindTexture(target, texID);
 
     //Get internal format of texture
     GLenum format = GL_RGB;
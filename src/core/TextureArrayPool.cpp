@@ -0,0 +1,171 @@
+//
+// Created by Dextron12 on 17/10/26.
+//
+
+#include <core/TextureArrayPool.hpp>
+#include <core/Material.hpp>
+#include <core/VFS.hpp>
+#include <core/Error.hpp>
+
+#include <renderer/GLStateCache.hpp>
+
+#include <glad/gl.h>
+
+#include <stb_image.h> // Implemented in Texture.cpp
+
+#include <algorithm>
+
+namespace Dexium::Core {
+
+    TextureArrayPool::TextureArrayPool(int layersPerArray, Utils::TexFlags flags)
+        : m_layersPerArray(layersPerArray > 0 ? layersPerArray : 1), m_flags(flags) {}
+
+    TextureArrayPool::Layer TextureArrayPool::insert(const std::filesystem::path& path) {
+        auto p = VFS::resolve(path);
+        if (p.empty()) {
+            TraceLog(LogLevel::ERROR, "[TextureArrayPool]: Failed to resolve '{}'", path.string());
+            return {};
+        }
+
+        stbi_set_flip_vertically_on_load(true);
+
+        int width = 0, height = 0, channels = 0;
+        unsigned char* data = stbi_load(p.string().c_str(), &width, &height, &channels, 4);
+        if (!data) {
+            TraceLog(LogLevel::ERROR, "[TextureArrayPool]: Failed to load image from: '{}'", p.string());
+            return {};
+        }
+
+        Layer layer = insert(data, width, height);
+        stbi_image_free(data);
+        return layer;
+    }
+
+    TextureArrayPool::Layer TextureArrayPool::insert(const unsigned char* rgba, int width, int height) {
+        if (!rgba || width <= 0 || height <= 0) {
+            TraceLog(LogLevel::ERROR, "[TextureArrayPool]: Cannot insert an empty image ({}x{})", width, height);
+            return {};
+        }
+
+        auto bucketIt = std::find_if(m_buckets.begin(), m_buckets.end(), [&](const Bucket& b) {
+            return b.width == width && b.height == height;
+        });
+        if (bucketIt == m_buckets.end()) {
+            m_buckets.push_back({width, height, {}});
+            bucketIt = m_buckets.end() - 1;
+        }
+        Bucket& bucket = *bucketIt;
+
+        // First array with room, else a new one
+        Array* array = nullptr;
+        for (auto& a : bucket.arrays) {
+            if (!a->freeLayers.empty() || a->nextLayer < a->texture->layers) {
+                array = a.get();
+                break;
+            }
+        }
+        if (!array) array = &createArray(bucket);
+
+        int layer;
+        if (!array->freeLayers.empty()) {
+            layer = array->freeLayers.back();
+            array->freeLayers.pop_back();
+        } else {
+            layer = array->nextLayer++;
+        }
+        ++array->used;
+
+        Texture& tex = *array->texture;
+        Renderer::GLStateCache::get().bindTexture(tex.target, tex.texID);
+        glTexSubImage3D(tex.target, 0, 0, 0, layer, width, height, 1, GL_RGBA, GL_UNSIGNED_BYTE, rgba);
+        if (Utils::hasFlag(m_flags, Utils::TexFlags::Mipmaps)) glGenerateMipmap(tex.target);
+
+        return {&tex, layer};
+    }
+
+    TextureArrayPool::Array& TextureArrayPool::createArray(Bucket& bucket) {
+        static GLint maxLayers = 0;
+        if (maxLayers == 0) glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &maxLayers);
+
+        auto array = std::make_unique<Array>();
+        array->texture = std::make_unique<Texture>();
+
+        Texture& tex = *array->texture;
+        tex.target = GL_TEXTURE_2D_ARRAY;
+        tex.width = bucket.width;
+        tex.height = bucket.height;
+        tex.nrChannels = 4;
+        tex.layers = std::min(m_layersPerArray, maxLayers > 0 ? static_cast<int>(maxLayers) : m_layersPerArray);
+        tex.flags = m_flags;
+
+        glGenTextures(1, &tex.texID);
+        Renderer::GLStateCache::get().bindTexture(tex.target, tex.texID);
+        glTexImage3D(tex.target, 0, GL_RGBA8, tex.width, tex.height, tex.layers, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+
+        // Mipmaps are regenerated per insert instead (there's no data to build them from yet)
+        tex.flags = m_flags & ~Utils::TexFlags::Mipmaps;
+        tex.uploadParameters();
+        tex.flags = m_flags;
+        if (Utils::hasFlag(m_flags, Utils::TexFlags::Mipmaps)) {
+            glTexParameteri(tex.target, GL_TEXTURE_MIN_FILTER, Utils::hasFlag(m_flags, Utils::TexFlags::Nearest) ? GL_NEAREST_MIPMAP_NEAREST : GL_LINEAR_MIPMAP_LINEAR);
+        }
+
+        TraceLog(LogLevel::DEBUG, "[TextureArrayPool]: Created a {}x{} array with {} layers", tex.width, tex.height, tex.layers);
+
+        bucket.arrays.push_back(std::move(array));
+        return *bucket.arrays.back();
+    }
+
+    bool TextureArrayPool::remove(const Layer& layer) {
+        for (auto& bucket : m_buckets) {
+            for (auto& array : bucket.arrays) {
+                if (array->texture.get() != layer.array) continue;
+
+                if (layer.layer < 0 || layer.layer >= array->nextLayer ||
+                    std::find(array->freeLayers.begin(), array->freeLayers.end(), layer.layer) != array->freeLayers.end()) {
+                    TraceLog(LogLevel::WARNING, "[TextureArrayPool]: Layer {} isn't in use", layer.layer);
+                    return false;
+                }
+
+                array->freeLayers.push_back(layer.layer);
+                --array->used;
+                return true;
+            }
+        }
+
+        TraceLog(LogLevel::WARNING, "[TextureArrayPool]: Layer's array doesn't belong to this pool");
+        return false;
+    }
+
+    bool TextureArrayPool::apply(const Layer& layer, Material& material, const std::string& samplerName,
+                                 const std::string& layerUniform) const {
+        if (!layer.valid()) {
+            TraceLog(LogLevel::WARNING, "[TextureArrayPool]: Cannot apply an invalid layer");
+            return false;
+        }
+
+        material.setTexture(samplerName, layer.array);
+        material.setUniform(layerUniform, layer.layer);
+        return true;
+    }
+
+    void TextureArrayPool::destroy() {
+        auto& gl = Renderer::GLStateCache::get();
+        for (auto& bucket : m_buckets) {
+            for (auto& array : bucket.arrays) {
+                GLuint id = array->texture->texID;
+                if (id == 0) continue;
+                glDeleteTextures(1, &id);
+                gl.forgetTexture(id);
+                array->texture->texID = 0;
+            }
+        }
+        m_buckets.clear();
+    }
+
+    size_t TextureArrayPool::arrayCount() const {
+        size_t count = 0;
+        for (const auto& bucket : m_buckets) count += bucket.arrays.size();
+        return count;
+    }
+}
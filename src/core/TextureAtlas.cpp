@@ -0,0 +1,316 @@
+//
+// Created by Dextron12 on 17/10/26.
+//
+
+#include <core/TextureAtlas.hpp>
+#include <core/Material.hpp>
+#include <core/VFS.hpp>
+#include <core/Error.hpp>
+
+#include <renderer/GLStateCache.hpp>
+
+#include <glad/gl.h>
+
+#include <stb_image.h> // Implemented in Texture.cpp
+
+#include <algorithm>
+#include <cstring>
+
+namespace Dexium::Core {
+
+    TextureAtlas::TextureAtlas(int pageSize, int padding)
+        : m_pageSize(pageSize > 0 ? pageSize : 2048), m_padding(padding > 0 ? padding : 0) {}
+
+    TextureAtlas::Handle TextureAtlas::insert(const std::filesystem::path& path) {
+        auto p = VFS::resolve(path);
+        if (p.empty()) {
+            TraceLog(LogLevel::ERROR, "[TextureAtlas]: Failed to resolve '{}'", path.string());
+            return InvalidHandle;
+        }
+
+        // Same orientation as Texture::load()
+        stbi_set_flip_vertically_on_load(true);
+
+        int width = 0, height = 0, channels = 0;
+        unsigned char* data = stbi_load(p.string().c_str(), &width, &height, &channels, 4); // Always expand to RGBA
+        if (!data) {
+            TraceLog(LogLevel::ERROR, "[TextureAtlas]: Failed to load image from: '{}'", p.string());
+            return InvalidHandle;
+        }
+
+        Handle handle = insert(data, width, height);
+        stbi_image_free(data);
+        return handle;
+    }
+
+    TextureAtlas::Handle TextureAtlas::insert(const unsigned char* rgba, int width, int height) {
+        if (!rgba || width <= 0 || height <= 0) {
+            TraceLog(LogLevel::ERROR, "[TextureAtlas]: Cannot insert an empty image ({}x{})", width, height);
+            return InvalidHandle;
+        }
+
+        const int pw = width + m_padding * 2;
+        const int ph = height + m_padding * 2;
+        if (pw > m_pageSize || ph > m_pageSize) {
+            TraceLog(LogLevel::ERROR, "[TextureAtlas]: Image ({}x{}) is larger than a page ({}x{})", width, height, m_pageSize, m_pageSize);
+            return InvalidHandle;
+        }
+
+        Entry entry;
+        entry.alive = true;
+        entry.paddedWidth = pw;
+        entry.paddedHeight = ph;
+        entry.region.width = width;
+        entry.region.height = height;
+
+        // Copy with the edge texels extruded into the padding
+        entry.pixels.resize(static_cast<size_t>(pw) * ph * 4);
+        for (int py = 0; py < ph; ++py) {
+            const int sy = std::clamp(py - m_padding, 0, height - 1);
+            for (int px = 0; px < pw; ++px) {
+                const int sx = std::clamp(px - m_padding, 0, width - 1);
+                std::memcpy(&entry.pixels[(static_cast<size_t>(py) * pw + px) * 4], &rgba[(static_cast<size_t>(sy) * width + sx) * 4], 4);
+            }
+        }
+
+        if (!place(entry)) return InvalidHandle;
+        upload(entry, *m_pages[entry.region.pageIndex]);
+
+        Handle handle;
+        if (!m_freeHandles.empty()) {
+            handle = m_freeHandles.back();
+            m_freeHandles.pop_back();
+            m_entries[handle] = std::move(entry);
+        } else {
+            handle = static_cast<Handle>(m_entries.size());
+            m_entries.push_back(std::move(entry));
+        }
+        return handle;
+    }
+
+    bool TextureAtlas::remove(Handle handle) {
+        if (handle >= m_entries.size() || !m_entries[handle].alive) {
+            TraceLog(LogLevel::WARNING, "[TextureAtlas]: Handle({}) isn't in the atlas", handle);
+            return false;
+        }
+
+        auto& entry = m_entries[handle];
+        entry.alive = false;
+        entry.pixels.clear();
+        entry.pixels.shrink_to_fit();
+        entry.region = {};
+        m_freeHandles.push_back(handle);
+        return true;
+    }
+
+    const TextureAtlas::Region* TextureAtlas::get(Handle handle) const {
+        if (handle >= m_entries.size() || !m_entries[handle].alive) return nullptr;
+        return &m_entries[handle].region;
+    }
+
+    bool TextureAtlas::apply(Handle handle, Material& material, const std::string& samplerName) const {
+        const Region* region = get(handle);
+        if (!region) {
+            TraceLog(LogLevel::WARNING, "[TextureAtlas]: Cannot apply Handle({}), it isn't in the atlas", handle);
+            return false;
+        }
+
+        material.setTexture(samplerName, region->page);
+        material.setUniform("uvRect", region->uvRect);
+        return true;
+    }
+
+    int TextureAtlas::findPosition(const Page& page, int w, int h, int& outX, int& outY) const {
+        int best = -1;
+        int bestY = m_pageSize;
+
+        for (size_t i = 0; i < page.skyline.size(); ++i) {
+            const int x = page.skyline[i].x;
+            if (x + w > m_pageSize) break; // Nodes are sorted by x
+
+            // The rect rests on the highest node it spans
+            int y = 0;
+            int widthLeft = w;
+            size_t j = i;
+            bool fits = true;
+            while (widthLeft > 0) {
+                if (j >= page.skyline.size()) { fits = false; break; }
+                y = std::max(y, page.skyline[j].y);
+                if (y + h > m_pageSize) { fits = false; break; }
+                widthLeft -= page.skyline[j].width;
+                ++j;
+            }
+
+            if (fits && y < bestY) {
+                best = static_cast<int>(i);
+                bestY = y;
+                outX = x;
+                outY = y;
+            }
+        }
+
+        return best;
+    }
+
+    void TextureAtlas::addSkylineLevel(Page& page, int nodeIndex, int x, int y, int w, int h) {
+        auto& sky = page.skyline;
+        sky.insert(sky.begin() + nodeIndex, SkylineNode{x, y + h, w});
+
+        // Trim (or drop) the nodes now under the new level
+        for (size_t i = nodeIndex + 1; i < sky.size(); ) {
+            const auto& prev = sky[i - 1];
+            const int prevEnd = prev.x + prev.width;
+            if (sky[i].x >= prevEnd) break;
+
+            const int shrink = prevEnd - sky[i].x;
+            sky[i].x += shrink;
+            sky[i].width -= shrink;
+            if (sky[i].width <= 0) {
+                sky.erase(sky.begin() + i);
+            } else {
+                break;
+            }
+        }
+
+        // Merge neighbours at the same height
+        for (size_t i = 0; i + 1 < sky.size(); ) {
+            if (sky[i].y == sky[i + 1].y) {
+                sky[i].width += sky[i + 1].width;
+                sky.erase(sky.begin() + i + 1);
+            } else {
+                ++i;
+            }
+        }
+
+        page.usedArea = 0;
+        for (const auto& node : sky) page.usedArea += static_cast<size_t>(node.width) * node.y;
+    }
+
+    bool TextureAtlas::place(Entry& entry) {
+        const int w = entry.paddedWidth;
+        const int h = entry.paddedHeight;
+
+        int x = 0, y = 0;
+        const auto existing = static_cast<uint32_t>(m_pages.size());
+        for (uint32_t p = 0; p <= existing; ++p) {
+            Page& page = (p == existing) ? newPage() : *m_pages[p];
+
+            int node = findPosition(page, w, h, x, y);
+            if (node < 0) continue;
+
+            addSkylineLevel(page, node, x, y, w, h);
+
+            auto& region = entry.region;
+            region.page = page.texture.get();
+            region.pageIndex = p;
+            region.x = x + m_padding;
+            region.y = y + m_padding;
+
+            const float size = static_cast<float>(m_pageSize);
+            region.uvRect = {
+                region.x / size, region.y / size,
+                (region.x + region.width) / size, (region.y + region.height) / size
+            };
+            return true;
+        }
+
+        // Only reachable if a brand new page can't hold it, which insert() already rules out
+        TraceLog(LogLevel::ERROR, "[TextureAtlas]: Failed to place a {}x{} image", w, h);
+        return false;
+    }
+
+    TextureAtlas::Page& TextureAtlas::newPage() {
+        auto page = std::make_unique<Page>();
+        page->skyline.push_back({0, 0, m_pageSize});
+
+        page->texture = std::make_unique<Texture>();
+        Texture& tex = *page->texture;
+        tex.width = m_pageSize;
+        tex.height = m_pageSize;
+        tex.nrChannels = 4;
+        tex.flags = Utils::TexFlags::Linear | Utils::TexFlags::ClampEdge;
+
+        glGenTextures(1, &tex.texID);
+        Renderer::GLStateCache::get().bindTexture(GL_TEXTURE_2D, tex.texID);
+        tex.uploadParameters();
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, m_pageSize, m_pageSize, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+
+        TraceLog(LogLevel::DEBUG, "[TextureAtlas]: Created page {} ({}x{})", m_pages.size(), m_pageSize, m_pageSize);
+
+        m_pages.push_back(std::move(page));
+        return *m_pages.back();
+    }
+
+    void TextureAtlas::upload(const Entry& entry, const Page& page) const {
+        Renderer::GLStateCache::get().bindTexture(GL_TEXTURE_2D, page.texture->texID);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, entry.region.x - m_padding, entry.region.y - m_padding,
+                        entry.paddedWidth, entry.paddedHeight, GL_RGBA, GL_UNSIGNED_BYTE, entry.pixels.data());
+    }
+
+    void TextureAtlas::defragment() {
+        std::vector<Handle> live;
+        for (Handle h = 0; h < m_entries.size(); ++h) {
+            if (m_entries[h].alive) live.push_back(h);
+        }
+
+        // Tallest first packs a skyline far tighter than insertion order
+        std::sort(live.begin(), live.end(), [this](Handle a, Handle b) {
+            const auto& ea = m_entries[a];
+            const auto& eb = m_entries[b];
+            if (ea.paddedHeight != eb.paddedHeight) return ea.paddedHeight > eb.paddedHeight;
+            return ea.paddedWidth > eb.paddedWidth;
+        });
+
+        // Reuse the existing page textures, only the skylines start over
+        for (auto& page : m_pages) {
+            page->skyline.assign(1, SkylineNode{0, 0, m_pageSize});
+            page->usedArea = 0;
+        }
+
+        for (Handle h : live) {
+            auto& entry = m_entries[h];
+            if (place(entry)) upload(entry, *m_pages[entry.region.pageIndex]);
+        }
+
+        // Drop the pages left empty (always at the back, pages are filled in order)
+        auto& gl = Renderer::GLStateCache::get();
+        while (!m_pages.empty() && m_pages.back()->usedArea == 0) {
+            GLuint id = m_pages.back()->texture->texID;
+            glDeleteTextures(1, &id);
+            gl.forgetTexture(id);
+            m_pages.back()->texture->texID = 0;
+            m_pages.pop_back();
+        }
+
+        ++m_generation;
+        TraceLog(LogLevel::DEBUG, "[TextureAtlas]: Defragmented {} images into {} pages", live.size(), m_pages.size());
+    }
+
+    void TextureAtlas::destroy() {
+        auto& gl = Renderer::GLStateCache::get();
+        for (auto& page : m_pages) {
+            GLuint id = page->texture->texID;
+            if (id != 0) {
+                glDeleteTextures(1, &id);
+                gl.forgetTexture(id);
+                page->texture->texID = 0;
+            }
+        }
+        m_pages.clear();
+        m_entries.clear();
+        m_freeHandles.clear();
+        ++m_generation;
+    }
+
+    float TextureAtlas::occupancy() const {
+        size_t used = 0;
+        for (const auto& page : m_pages) used += page->usedArea;
+        if (used == 0) return 1.f;
+
+        size_t live = 0;
+        for (const auto& entry : m_entries) {
+            if (entry.alive) live += static_cast<size_t>(entry.paddedWidth) * entry.paddedHeight;
+        }
+        return static_cast<float>(live) / static_cast<float>(used);
+    }
+}
@@ -4,30 +4,47 @@
 
 #include <core/Transform.h>
 
-#include <glm/gtc/matrix_transform.hpp>
+#include <atomic>
+#include <cmath>
 
 namespace Dexium::Core {
 
-    glm::mat4 Transform::ModelMatrix() {
-        //The model
-        glm::mat4 model(1.0f);
+    namespace {
+        std::atomic<uint32_t> s_generation{0}; // Transforms can be rebuilt from worker threads
+
+        uint32_t nextGeneration() {
+            uint32_t generation = s_generation.fetch_add(1, std::memory_order_relaxed) + 1;
+            if (generation == 0) generation = s_generation.fetch_add(1, std::memory_order_relaxed) + 1; // Wrapped, 0 means never built
+            return generation;
+        }
+    }
+
+    const glm::mat4& Transform::ModelMatrix() {
+        if (m_cached && position == m_cachedPosition && rotation == m_cachedRotation && scale == m_cachedScale) return m_model;
 
         // Some tranform boundry checks were needed to mitigate bug #04
         // but they simply just output warnings if the model was too small or alrge for the viewport/camera
         // In fuuture, we could reimplement this, but from here on we assume its the end-users problem if they render something outside of the viewport
 
-        // Translation
-        model = glm::translate(model, position);
-
+        // translate * rotZ * rotY * rotX * scale, written out directly rather than as 5 matrix multiplies
         // Rotation -> In the ZYX order (common for graphics engines)
-        model = glm::rotate(model, glm::radians(rotation.z), glm::vec3(0,0,1));
-        model = glm::rotate(model, glm::radians(rotation.y), glm::vec3(0,1,0));
-        model = glm::rotate(model, glm::radians(rotation.x), glm::vec3(1,0,0));
-
-        // Scale
-        model = glm::scale(model, scale);
-
-        return model;
+        const glm::vec3 rad = glm::radians(rotation);
+        const float sx = std::sin(rad.x), cx = std::cos(rad.x);
+        const float sy = std::sin(rad.y), cy = std::cos(rad.y);
+        const float sz = std::sin(rad.z), cz = std::cos(rad.z);
+
+        m_model[0] = glm::vec4(cz * cy, sz * cy, -sy, 0.f) * scale.x;
+        m_model[1] = glm::vec4(cz * sy * sx - sz * cx, sz * sy * sx + cz * cx, cy * sx, 0.f) * scale.y;
+        m_model[2] = glm::vec4(cz * sy * cx + sz * sx, sz * sy * cx - cz * sx, cy * cx, 0.f) * scale.z;
+        m_model[3] = glm::vec4(position, 1.f);
+
+        m_cachedPosition = position;
+        m_cachedRotation = rotation;
+        m_cachedScale = scale;
+        m_cached = true;
+        m_generation = nextGeneration();
+
+        return m_model;
     }
 
 
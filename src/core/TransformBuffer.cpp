@@ -0,0 +1,316 @@
+//
+// Created by Dextron12 on 17/10/26.
+//
+
+#include <core/TransformBuffer.hpp>
+#include <core/Error.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #include <emmintrin.h>
+    #define DEXIUM_TRANSFORM_SSE 1
+#endif
+
+namespace Dexium::Core {
+
+    namespace {
+        constexpr uint32_t NoIndex = UINT32_MAX;
+        constexpr float DegToRad = 0.017453292519943295f;
+
+        // sin/cos as in Cephes sinf/cosf: reduce to [-pi/4, pi/4] around the nearest multiple of pi/2 (in 3 parts, so
+        // the reduction stays accurate for big angles), then minimax polynomials. The SSE version below is the same maths
+        constexpr float FourOverPi = 1.27323954473516f;
+        constexpr float DP1 = 0.78515625f, DP2 = 2.4187564849853515625e-4f, DP3 = 3.77489497744594108e-8f;
+        constexpr float S1 = -1.6666654611e-1f, S2 = 8.3321608736e-3f, S3 = -1.9515295891e-4f;
+        constexpr float C1 = 4.166664568298827e-2f, C2 = -1.388731625493765e-3f, C3 = 2.443315711809948e-5f;
+
+        void sinCos(float x, float& s, float& c) {
+            const bool negative = x < 0.f;
+            float ax = std::fabs(x);
+
+            const int j = (static_cast<int>(ax * FourOverPi) + 1) & ~1;
+            const float y = static_cast<float>(j);
+            ax = ((ax - y * DP1) - y * DP2) - y * DP3;
+
+            const float z = ax * ax;
+            const float sinP = ax + ax * z * (S1 + z * (S2 + z * S3));
+            const float cosP = 1.f - 0.5f * z + z * z * (C1 + z * (C2 + z * C3));
+
+            // Which quarter turn we reduced from picks the polynomial & the signs
+            const int q = (j >> 1) & 3;
+            s = (q & 1) ? cosP : sinP;
+            c = (q & 1) ? sinP : cosP;
+            if (q & 2) s = -s;
+            if ((q + 1) & 2) c = -c;
+            if (negative) s = -s;
+        }
+
+        // One transform, same layout as Transform::ModelMatrix()
+        void buildMatrix(float* m, float px, float py, float pz, float rx, float ry, float rz, float scx, float scy, float scz) {
+            float sinZ, cosZ;
+            sinCos(rz * DegToRad, sinZ, cosZ);
+
+            if (rx == 0.f && ry == 0.f) {
+                // 2D: Z rotation & scale only
+                m[0] = cosZ * scx;  m[1] = sinZ * scx; m[2] = 0.f;  m[3] = 0.f;
+                m[4] = -sinZ * scy; m[5] = cosZ * scy; m[6] = 0.f;  m[7] = 0.f;
+                m[8] = 0.f;         m[9] = 0.f;        m[10] = scz; m[11] = 0.f;
+            } else {
+                float sinX, cosX, sinY, cosY;
+                sinCos(rx * DegToRad, sinX, cosX);
+                sinCos(ry * DegToRad, sinY, cosY);
+
+                m[0] = cosZ * cosY * scx;
+                m[1] = sinZ * cosY * scx;
+                m[2] = -sinY * scx;
+                m[3] = 0.f;
+                m[4] = (cosZ * sinY * sinX - sinZ * cosX) * scy;
+                m[5] = (sinZ * sinY * sinX + cosZ * cosX) * scy;
+                m[6] = cosY * sinX * scy;
+                m[7] = 0.f;
+                m[8] = (cosZ * sinY * cosX + sinZ * sinX) * scz;
+                m[9] = (sinZ * sinY * cosX - cosZ * sinX) * scz;
+                m[10] = cosY * cosX * scz;
+                m[11] = 0.f;
+            }
+            m[12] = px; m[13] = py; m[14] = pz; m[15] = 1.f;
+        }
+
+#ifdef DEXIUM_TRANSFORM_SSE
+        void sinCos4(__m128 x, __m128& s, __m128& c) {
+            const __m128 signMask = _mm_castsi128_ps(_mm_set1_epi32(static_cast<int>(0x80000000u)));
+            const __m128 sign = _mm_and_ps(x, signMask);
+            __m128 ax = _mm_andnot_ps(signMask, x);
+
+            __m128i j = _mm_cvttps_epi32(_mm_mul_ps(ax, _mm_set1_ps(FourOverPi)));
+            j = _mm_and_si128(_mm_add_epi32(j, _mm_set1_epi32(1)), _mm_set1_epi32(~1));
+            const __m128 y = _mm_cvtepi32_ps(j);
+            ax = _mm_sub_ps(ax, _mm_mul_ps(y, _mm_set1_ps(DP1)));
+            ax = _mm_sub_ps(ax, _mm_mul_ps(y, _mm_set1_ps(DP2)));
+            ax = _mm_sub_ps(ax, _mm_mul_ps(y, _mm_set1_ps(DP3)));
+
+            const __m128 z = _mm_mul_ps(ax, ax);
+            __m128 sinP = _mm_add_ps(_mm_mul_ps(z, _mm_set1_ps(S3)), _mm_set1_ps(S2));
+            sinP = _mm_add_ps(_mm_mul_ps(sinP, z), _mm_set1_ps(S1));
+            sinP = _mm_add_ps(ax, _mm_mul_ps(_mm_mul_ps(ax, z), sinP));
+
+            __m128 cosP = _mm_add_ps(_mm_mul_ps(z, _mm_set1_ps(C3)), _mm_set1_ps(C2));
+            cosP = _mm_add_ps(_mm_mul_ps(cosP, z), _mm_set1_ps(C1));
+            cosP = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(z, z), cosP), _mm_sub_ps(_mm_set1_ps(1.f), _mm_mul_ps(z, _mm_set1_ps(0.5f))));
+
+            const __m128i q = _mm_srli_epi32(j, 1);
+            const __m128i zero = _mm_setzero_si128();
+            const __m128 swap = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(q, _mm_set1_epi32(1)), zero)); // All ones = don't swap
+            const __m128 sinNeg = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(q, _mm_set1_epi32(2)), 30));
+            const __m128 cosNeg = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(_mm_add_epi32(q, _mm_set1_epi32(1)), _mm_set1_epi32(2)), 30));
+
+            s = _mm_or_ps(_mm_and_ps(swap, sinP), _mm_andnot_ps(swap, cosP));
+            c = _mm_or_ps(_mm_and_ps(swap, cosP), _mm_andnot_ps(swap, sinP));
+            s = _mm_xor_ps(s, _mm_xor_ps(sinNeg, sign));
+            c = _mm_xor_ps(c, cosNeg);
+        }
+
+        // Turns 4 lanes of (x, y, z, w) into column col of the 4 matrices at out
+        inline void storeColumn(float* out, int col, __m128 x, __m128 y, __m128 z, __m128 w) {
+            _MM_TRANSPOSE4_PS(x, y, z, w);
+            _mm_storeu_ps(out + col * 4, x);
+            _mm_storeu_ps(out + 16 + col * 4, y);
+            _mm_storeu_ps(out + 32 + col * 4, z);
+            _mm_storeu_ps(out + 48 + col * 4, w);
+        }
+#endif
+    }
+
+    TransformBuffer::Handle TransformBuffer::add(const Transform& transform) {
+        Handle handle;
+        if (!m_freeHandles.empty()) {
+            handle = m_freeHandles.back();
+            m_freeHandles.pop_back();
+        } else {
+            handle = static_cast<Handle>(m_indices.size());
+            m_indices.push_back(NoIndex);
+        }
+
+        m_indices[handle] = static_cast<uint32_t>(m_handles.size());
+        m_handles.push_back(handle);
+
+        m_px.push_back(transform.position.x); m_py.push_back(transform.position.y); m_pz.push_back(transform.position.z);
+        m_rx.push_back(transform.rotation.x); m_ry.push_back(transform.rotation.y); m_rz.push_back(transform.rotation.z);
+        m_sx.push_back(transform.scale.x); m_sy.push_back(transform.scale.y); m_sz.push_back(transform.scale.z);
+        return handle;
+    }
+
+    void TransformBuffer::remove(Handle handle) {
+        if (!valid(handle)) {
+            TraceLog(LogLevel::WARNING, "[TransformBuffer]: Removing an invalid handle ({})", handle);
+            return;
+        }
+
+        // Swap the last transform into the hole, so the arrays stay dense
+        const uint32_t index = m_indices[handle];
+        const size_t last = m_handles.size() - 1;
+        for (auto* array : {&m_px, &m_py, &m_pz, &m_rx, &m_ry, &m_rz, &m_sx, &m_sy, &m_sz}) {
+            (*array)[index] = (*array)[last];
+            array->pop_back();
+        }
+        m_handles[index] = m_handles[last];
+        m_handles.pop_back();
+        if (index != last) m_indices[m_handles[index]] = index;
+
+        m_indices[handle] = NoIndex;
+        m_freeHandles.push_back(handle);
+    }
+
+    void TransformBuffer::clear() {
+        for (auto* array : {&m_px, &m_py, &m_pz, &m_rx, &m_ry, &m_rz, &m_sx, &m_sy, &m_sz}) array->clear();
+        m_handles.clear();
+        m_indices.clear();
+        m_freeHandles.clear();
+    }
+
+    void TransformBuffer::reserve(size_t count) {
+        for (auto* array : {&m_px, &m_py, &m_pz, &m_rx, &m_ry, &m_rz, &m_sx, &m_sy, &m_sz}) array->reserve(count);
+        m_handles.reserve(count);
+        m_indices.reserve(count);
+    }
+
+    bool TransformBuffer::valid(Handle handle) const {
+        return handle < m_indices.size() && m_indices[handle] != NoIndex;
+    }
+
+    size_t TransformBuffer::indexOf(Handle handle) const {
+        return valid(handle) ? m_indices[handle] : SIZE_MAX;
+    }
+
+    Transform TransformBuffer::get(Handle handle) const {
+        if (!valid(handle)) {
+            TraceLog(LogLevel::ERROR, "[TransformBuffer]: No transform for handle ({})", handle);
+            return Transform(glm::vec3(0.f));
+        }
+        const uint32_t i = m_indices[handle];
+        return Transform(glm::vec3(m_px[i], m_py[i], m_pz[i]), glm::vec3(m_rx[i], m_ry[i], m_rz[i]), glm::vec3(m_sx[i], m_sy[i], m_sz[i]));
+    }
+
+    void TransformBuffer::set(Handle handle, const Transform& transform) {
+        setPosition(handle, transform.position);
+        setRotation(handle, transform.rotation);
+        setScale(handle, transform.scale);
+    }
+
+    void TransformBuffer::setPosition(Handle handle, const glm::vec3& position) {
+        if (!valid(handle)) return;
+        const uint32_t i = m_indices[handle];
+        m_px[i] = position.x; m_py[i] = position.y; m_pz[i] = position.z;
+    }
+
+    void TransformBuffer::setRotation(Handle handle, const glm::vec3& rotation) {
+        if (!valid(handle)) return;
+        const uint32_t i = m_indices[handle];
+        m_rx[i] = rotation.x; m_ry[i] = rotation.y; m_rz[i] = rotation.z;
+    }
+
+    void TransformBuffer::setScale(Handle handle, const glm::vec3& scale) {
+        if (!valid(handle)) return;
+        const uint32_t i = m_indices[handle];
+        m_sx[i] = scale.x; m_sy[i] = scale.y; m_sz[i] = scale.z;
+    }
+
+    void TransformBuffer::computeMatrices(glm::mat4* out) const {
+        computeMatrices(out, 0, size());
+    }
+
+    void TransformBuffer::computeMatrices(glm::mat4* out, size_t first, size_t count) const {
+        if (first >= size()) return;
+        count = std::min(count, size() - first);
+
+        unsigned threads = 1;
+        if (parallelThreshold != 0 && count >= parallelThreshold) {
+            threads = maxThreads != 0 ? maxThreads : std::max(1u, std::thread::hardware_concurrency());
+            // Don't bother splitting into chunks smaller than half the threshold
+            threads = static_cast<unsigned>(std::min<size_t>(threads, std::max<size_t>(1, count / std::max<size_t>(1, parallelThreshold / 2))));
+        }
+
+        if (threads <= 1) {
+            computeRange(out, first, count);
+            return;
+        }
+
+        // Chunks start on multiples of 4, so only the last one has a scalar tail
+        std::vector<size_t> bounds(threads + 1);
+        for (unsigned t = 0; t < threads; ++t) bounds[t] = (count * t / threads) & ~size_t(3);
+        bounds[threads] = count;
+
+        std::vector<std::thread> workers;
+        workers.reserve(threads - 1);
+        for (unsigned t = 1; t < threads; ++t) {
+            workers.emplace_back([this, out, first, &bounds, t] {
+                computeRange(out + bounds[t], first + bounds[t], bounds[t + 1] - bounds[t]);
+            });
+        }
+        computeRange(out, first, bounds[1]);
+        for (auto& w : workers) w.join();
+    }
+
+    void TransformBuffer::computeRange(glm::mat4* out, size_t first, size_t count) const {
+        auto* dst = reinterpret_cast<float*>(out); // glm::mat4 is 16 packed floats, column major
+        size_t i = 0;
+
+#ifdef DEXIUM_TRANSFORM_SSE
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 one = _mm_set1_ps(1.f);
+        const __m128 degToRad = _mm_set1_ps(DegToRad);
+
+        for (; i + 4 <= count; i += 4, dst += 64) {
+            const size_t s = first + i;
+            const __m128 rx = _mm_loadu_ps(&m_rx[s]);
+            const __m128 ry = _mm_loadu_ps(&m_ry[s]);
+            const __m128 scx = _mm_loadu_ps(&m_sx[s]);
+            const __m128 scy = _mm_loadu_ps(&m_sy[s]);
+            const __m128 scz = _mm_loadu_ps(&m_sz[s]);
+
+            __m128 sinZ, cosZ;
+            sinCos4(_mm_mul_ps(_mm_loadu_ps(&m_rz[s]), degToRad), sinZ, cosZ);
+
+            const bool flat = _mm_movemask_ps(_mm_and_ps(_mm_cmpeq_ps(rx, zero), _mm_cmpeq_ps(ry, zero))) == 0xF;
+            if (flat) {
+                // 2D: Z rotation & scale only
+                storeColumn(dst, 0, _mm_mul_ps(cosZ, scx), _mm_mul_ps(sinZ, scx), zero, zero);
+                storeColumn(dst, 1, _mm_sub_ps(zero, _mm_mul_ps(sinZ, scy)), _mm_mul_ps(cosZ, scy), zero, zero);
+                storeColumn(dst, 2, zero, zero, scz, zero);
+            } else {
+                __m128 sinX, cosX, sinY, cosY;
+                sinCos4(_mm_mul_ps(rx, degToRad), sinX, cosX);
+                sinCos4(_mm_mul_ps(ry, degToRad), sinY, cosY);
+
+                const __m128 czsy = _mm_mul_ps(cosZ, sinY);
+                const __m128 szsy = _mm_mul_ps(sinZ, sinY);
+
+                storeColumn(dst, 0,
+                            _mm_mul_ps(_mm_mul_ps(cosZ, cosY), scx),
+                            _mm_mul_ps(_mm_mul_ps(sinZ, cosY), scx),
+                            _mm_sub_ps(zero, _mm_mul_ps(sinY, scx)),
+                            zero);
+                storeColumn(dst, 1,
+                            _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(czsy, sinX), _mm_mul_ps(sinZ, cosX)), scy),
+                            _mm_mul_ps(_mm_add_ps(_mm_mul_ps(szsy, sinX), _mm_mul_ps(cosZ, cosX)), scy),
+                            _mm_mul_ps(_mm_mul_ps(cosY, sinX), scy),
+                            zero);
+                storeColumn(dst, 2,
+                            _mm_mul_ps(_mm_add_ps(_mm_mul_ps(czsy, cosX), _mm_mul_ps(sinZ, sinX)), scz),
+                            _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(szsy, cosX), _mm_mul_ps(cosZ, sinX)), scz),
+                            _mm_mul_ps(_mm_mul_ps(cosY, cosX), scz),
+                            zero);
+            }
+            storeColumn(dst, 3, _mm_loadu_ps(&m_px[s]), _mm_loadu_ps(&m_py[s]), _mm_loadu_ps(&m_pz[s]), one);
+        }
+#endif
+
+        for (; i < count; ++i, dst += 16) {
+            const size_t s = first + i;
+            buildMatrix(dst, m_px[s], m_py[s], m_pz[s], m_rx[s], m_ry[s], m_rz[s], m_sx[s], m_sy[s], m_sz[s]);
+        }
+    }
+}
@@ -0,0 +1,185 @@
+//
+// Created by Dextron12 on 17/10/26.
+//
+
+#include <core/VertexLayout.hpp>
+
+#include <algorithm>
+#include <cstring>
+
+namespace Dexium::Core {
+
+    namespace {
+        struct FormatInfo {
+            GLint components; // As glVertexAttribPointer sees them
+            GLenum type;
+            GLboolean normalized;
+            uint32_t bytes;
+            uint32_t sourceFloats;
+        };
+
+        FormatInfo info(VertexFormat format) {
+            switch (format) {
+                case VertexFormat::Float:     return {1, GL_FLOAT, GL_FALSE, 4, 1};
+                case VertexFormat::Float2:    return {2, GL_FLOAT, GL_FALSE, 8, 2};
+                case VertexFormat::Float3:    return {3, GL_FLOAT, GL_FALSE, 12, 3};
+                case VertexFormat::Float4:    return {4, GL_FLOAT, GL_FALSE, 16, 4};
+                case VertexFormat::Half2:     return {2, GL_HALF_FLOAT, GL_FALSE, 4, 2};
+                case VertexFormat::Half3:     return {3, GL_HALF_FLOAT, GL_FALSE, 8, 3};
+                case VertexFormat::Half4:     return {4, GL_HALF_FLOAT, GL_FALSE, 8, 4};
+                case VertexFormat::UNorm16x2: return {2, GL_UNSIGNED_SHORT, GL_TRUE, 4, 2};
+                case VertexFormat::UNorm8x4:  return {4, GL_UNSIGNED_BYTE, GL_TRUE, 4, 4};
+                case VertexFormat::SNorm10x3: return {4, GL_INT_2_10_10_10_REV, GL_TRUE, 4, 3}; // Packed types must be size 4
+            }
+            return {1, GL_FLOAT, GL_FALSE, 4, 1};
+        }
+
+        template <typename T>
+        T unorm(float value, float scale) {
+            return static_cast<T>(std::clamp(value, 0.f, 1.f) * scale + 0.5f);
+        }
+
+        uint32_t snorm10(float value) {
+            // Two's complement in 10 bits, GL 4.2+ maps -511..511 onto -1..1
+            const float scaled = std::clamp(value, -1.f, 1.f) * 511.f;
+            return static_cast<uint32_t>(static_cast<int32_t>(scaled + (scaled < 0.f ? -0.5f : 0.5f))) & 0x3FFu;
+        }
+    }
+
+    VertexLayout& VertexLayout::add(GLuint location, VertexFormat format) {
+        const FormatInfo fmt = info(format);
+        m_attributes.push_back({location, format, m_stride});
+        m_stride += fmt.bytes;
+        m_sourceFloats += fmt.sourceFloats;
+        return *this;
+    }
+
+    VertexLayout VertexLayout::Default() {
+        VertexLayout layout;
+        layout.add(0, VertexFormat::Float3).add(1, VertexFormat::Float2);
+        return layout;
+    }
+
+    VertexLayout VertexLayout::Compact() {
+        VertexLayout layout;
+        layout.add(0, VertexFormat::Half3).add(1, VertexFormat::UNorm16x2);
+        return layout;
+    }
+
+    void VertexLayout::pack(const float* src, size_t count, void* dst) const {
+        auto* out = static_cast<unsigned char*>(dst);
+
+        // The default layout is the floats as they are
+        if (m_stride == m_sourceFloats * sizeof(float) &&
+            std::all_of(m_attributes.begin(), m_attributes.end(), [](const Attribute& a) { return info(a.format).type == GL_FLOAT; })) {
+            std::memcpy(out, src, count * m_stride);
+            return;
+        }
+
+        for (size_t v = 0; v < count; ++v) {
+            for (const auto& attrib : m_attributes) {
+                unsigned char* at = out + attrib.offset;
+                switch (attrib.format) {
+                    case VertexFormat::Float:
+                    case VertexFormat::Float2:
+                    case VertexFormat::Float3:
+                    case VertexFormat::Float4: {
+                        const uint32_t n = info(attrib.format).sourceFloats;
+                        std::memcpy(at, src, n * sizeof(float));
+                        src += n;
+                        break;
+                    }
+                    case VertexFormat::Half2:
+                    case VertexFormat::Half3:
+                    case VertexFormat::Half4: {
+                        const uint32_t n = info(attrib.format).sourceFloats;
+                        uint16_t halves[4] = {};
+                        for (uint32_t c = 0; c < n; ++c) halves[c] = floatToHalf(src[c]);
+                        std::memcpy(at, halves, info(attrib.format).bytes); // Half3's padding goes out as 0
+                        src += n;
+                        break;
+                    }
+                    case VertexFormat::UNorm16x2: {
+                        const uint16_t uv[2] = {unorm<uint16_t>(src[0], 65535.f), unorm<uint16_t>(src[1], 65535.f)};
+                        std::memcpy(at, uv, sizeof(uv));
+                        src += 2;
+                        break;
+                    }
+                    case VertexFormat::UNorm8x4: {
+                        for (int c = 0; c < 4; ++c) at[c] = unorm<uint8_t>(src[c], 255.f);
+                        src += 4;
+                        break;
+                    }
+                    case VertexFormat::SNorm10x3: {
+                        const uint32_t packed = snorm10(src[0]) | (snorm10(src[1]) << 10) | (snorm10(src[2]) << 20);
+                        std::memcpy(at, &packed, sizeof(packed));
+                        src += 3;
+                        break;
+                    }
+                }
+            }
+            out += m_stride;
+        }
+    }
+
+    void VertexLayout::apply() const {
+        for (const auto& attrib : m_attributes) {
+            const FormatInfo fmt = info(attrib.format);
+            glVertexAttribPointer(attrib.location, fmt.components, fmt.type, fmt.normalized, static_cast<GLsizei>(m_stride),
+                                  reinterpret_cast<void*>(static_cast<uintptr_t>(attrib.offset)));
+            glEnableVertexAttribArray(attrib.location);
+        }
+    }
+
+    bool VertexLayout::operator==(const VertexLayout& other) const {
+        return m_attributes.size() == other.m_attributes.size() &&
+            std::equal(m_attributes.begin(), m_attributes.end(), other.m_attributes.begin(), [](const Attribute& a, const Attribute& b) {
+                return a.location == b.location && a.format == b.format;
+            });
+    }
+
+    GLenum indexTypeFor(size_t vertexCount) {
+        return vertexCount <= 65536 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+    }
+
+    size_t indexTypeSize(GLenum type) {
+        return type == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(uint32_t);
+    }
+
+    void packIndices(const unsigned int* src, size_t count, GLenum type, void* dst) {
+        if (type != GL_UNSIGNED_SHORT) {
+            std::memcpy(dst, src, count * sizeof(unsigned int));
+            return;
+        }
+        auto* out = static_cast<uint16_t*>(dst);
+        for (size_t i = 0; i < count; ++i) out[i] = static_cast<uint16_t>(src[i]);
+    }
+
+    uint16_t floatToHalf(float value) {
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+
+        const auto sign = static_cast<uint16_t>((bits >> 16) & 0x8000u);
+        bits &= 0x7FFFFFFFu;
+
+        if (bits >= 0x7F800000u) return static_cast<uint16_t>(sign | 0x7C00u | (bits > 0x7F800000u ? 0x200u : 0u)); // Inf / NaN
+        if (bits >= 0x477FF000u) return static_cast<uint16_t>(sign | 0x7C00u); // Rounds past 65504
+
+        if (bits < 0x38800000u) {
+            // Below the smallest normal half, so a denormal (or 0)
+            if (bits < 0x33000000u) return sign;
+            const uint32_t mantissa = (bits & 0x7FFFFFu) | 0x800000u;
+            const uint32_t shift = 126u - (bits >> 23);
+            uint32_t half = mantissa >> shift;
+            const uint32_t rest = mantissa & ((1u << shift) - 1u), mid = 1u << (shift - 1u);
+            if (rest > mid || (rest == mid && (half & 1u))) ++half;
+            return static_cast<uint16_t>(sign | half);
+        }
+
+        // Rebias the exponent & round to nearest even (a carry into the exponent is still right)
+        uint32_t half = (bits - 0x38000000u) >> 13;
+        const uint32_t rest = bits & 0x1FFFu;
+        if (rest > 0x1000u || (rest == 0x1000u && (half & 1u))) ++half;
+        return static_cast<uint16_t>(sign | half);
+    }
+}
@@ -4,5 +4,14 @@
 
 #include <renderer/Command.hpp>
 
+#include <core/Transform.h>
+
 Dexium::Renderer::Command::Command(Core::Mesh* mesh, Core::Material* material, Core::Transform* transform)
     : mesh(mesh), material(material), transform(transform) {}
+
+Dexium::Renderer::Command::Command(Core::Mesh* mesh, Core::Material* material, Core::Transform* transform, uint64_t sortKey)
+    : mesh(mesh), material(material), transform(transform), sortKey(sortKey) {}
+
+const glm::mat4& Dexium::Renderer::Command::modelMatrix() const {
+    return world ? *world : transform->ModelMatrix();
+}
@@ -0,0 +1,265 @@
+//
+// Created by Dextron12 on 17/10/26.
+//
+
+#include <renderer/Culling.hpp>
+
+#include <core/Mesh.hpp>
+#include <core/Transform.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #include <emmintrin.h>
+    #define DEXIUM_CULL_SSE 1
+#endif
+
+namespace Dexium::Renderer {
+
+    AABB computeViewBounds(const glm::mat4& projection, const glm::mat4& view) {
+        const glm::mat4 inv = glm::inverse(projection * view);
+
+        AABB bounds;
+        bool first = true;
+        for (int corner = 0; corner < 8; ++corner) {
+            const glm::vec4 ndc((corner & 1) ? 1.f : -1.f, (corner & 2) ? 1.f : -1.f, (corner & 4) ? 1.f : -1.f, 1.f);
+            glm::vec4 world = inv * ndc;
+            const glm::vec3 p = glm::vec3(world) / world.w;
+
+            if (first) {
+                bounds.min = bounds.max = p;
+                first = false;
+            } else {
+                bounds.min = glm::min(bounds.min, p);
+                bounds.max = glm::max(bounds.max, p);
+            }
+        }
+        return bounds;
+    }
+
+    AABB transformBounds(const glm::vec3& localMin, const glm::vec3& localMax, const glm::mat4& model) {
+        const glm::vec3 centre = (localMin + localMax) * 0.5f;
+        const glm::vec3 extent = (localMax - localMin) * 0.5f;
+
+        const glm::vec3 worldCentre = glm::vec3(model * glm::vec4(centre, 1.f));
+
+        // |M| * extent, the box's half size along each world axis
+        glm::vec3 worldExtent(0.f);
+        for (int col = 0; col < 3; ++col) {
+            for (int row = 0; row < 3; ++row) {
+                worldExtent[row] += std::abs(model[col][row]) * extent[col];
+            }
+        }
+
+        return {worldCentre - worldExtent, worldCentre + worldExtent};
+    }
+
+    size_t CommandCuller::cull(std::vector<Command>& commands, const AABB& view) {
+        const size_t count = commands.size();
+        if (count == 0) return 0;
+
+        // Padded to a multiple of 4, the padding is never read back
+        const size_t padded = (count + 3) & ~static_cast<size_t>(3);
+        for (auto* v : {&m_minX, &m_minY, &m_minZ, &m_maxX, &m_maxY, &m_maxZ}) v->resize(padded);
+        m_visible.resize(padded);
+
+        constexpr float inf = std::numeric_limits<float>::infinity();
+
+        // Gather world bounds (SoA)
+        for (size_t i = 0; i < count; ++i) {
+            const auto& cmd = commands[i];
+            AABB box;
+            if (cmd.mesh->hasBounds) {
+                box = transformBounds(cmd.mesh->boundsMin, cmd.mesh->boundsMax, cmd.modelMatrix());
+            } else {
+                box = {glm::vec3(-inf), glm::vec3(inf)}; // Unknown size, always drawn
+            }
+            m_minX[i] = box.min.x; m_minY[i] = box.min.y; m_minZ[i] = box.min.z;
+            m_maxX[i] = box.max.x; m_maxY[i] = box.max.y; m_maxZ[i] = box.max.z;
+        }
+
+        size_t i = 0;
+#ifdef DEXIUM_CULL_SSE
+        const __m128 viewMinX = _mm_set1_ps(view.min.x), viewMaxX = _mm_set1_ps(view.max.x);
+        const __m128 viewMinY = _mm_set1_ps(view.min.y), viewMaxY = _mm_set1_ps(view.max.y);
+        const __m128 viewMinZ = _mm_set1_ps(view.min.z), viewMaxZ = _mm_set1_ps(view.max.z);
+
+        for (; i + 4 <= count; i += 4) {
+            __m128 in = _mm_and_ps(_mm_cmple_ps(_mm_loadu_ps(&m_minX[i]), viewMaxX), _mm_cmpge_ps(_mm_loadu_ps(&m_maxX[i]), viewMinX));
+            in = _mm_and_ps(in, _mm_and_ps(_mm_cmple_ps(_mm_loadu_ps(&m_minY[i]), viewMaxY), _mm_cmpge_ps(_mm_loadu_ps(&m_maxY[i]), viewMinY)));
+            in = _mm_and_ps(in, _mm_and_ps(_mm_cmple_ps(_mm_loadu_ps(&m_minZ[i]), viewMaxZ), _mm_cmpge_ps(_mm_loadu_ps(&m_maxZ[i]), viewMinZ)));
+
+            const int mask = _mm_movemask_ps(in);
+            m_visible[i] = mask & 1;
+            m_visible[i + 1] = (mask >> 1) & 1;
+            m_visible[i + 2] = (mask >> 2) & 1;
+            m_visible[i + 3] = (mask >> 3) & 1;
+        }
+#endif
+        for (; i < count; ++i) {
+            m_visible[i] = m_minX[i] <= view.max.x && m_maxX[i] >= view.min.x &&
+                           m_minY[i] <= view.max.y && m_maxY[i] >= view.min.y &&
+                           m_minZ[i] <= view.max.z && m_maxZ[i] >= view.min.z;
+        }
+
+        // Compact in place, keeping order
+        size_t kept = 0;
+        for (size_t c = 0; c < count; ++c) {
+            if (!m_visible[c]) continue;
+            if (kept != c) commands[kept] = commands[c];
+            ++kept;
+        }
+        commands.erase(commands.begin() + static_cast<std::ptrdiff_t>(kept), commands.end());
+
+        return count - kept;
+    }
+
+    UniformGrid::UniformGrid(float cellSize)
+        : m_cellSize(cellSize > 0.f ? cellSize : 512.f) {}
+
+    UniformGrid::CellRange UniformGrid::cellsFor(const AABB& bounds) const {
+        // Clamped so huge (or infinite) boxes can't overflow the int cast
+        static constexpr double limit = 1 << 30;
+        auto cell = [this](float v) {
+            return static_cast<int>(std::clamp(std::floor(static_cast<double>(v) / m_cellSize), -limit, limit));
+        };
+
+        CellRange range{cell(bounds.min.x), cell(bounds.min.y), cell(bounds.max.x), cell(bounds.max.y), false};
+        const int64_t cells = (static_cast<int64_t>(range.x1) - range.x0 + 1) * (static_cast<int64_t>(range.y1) - range.y0 + 1);
+        range.oversized = cells > MaxCellsPerItem;
+        return range;
+    }
+
+    void UniformGrid::link(Handle handle) {
+        const auto& c = m_items[handle].cells;
+        if (c.oversized) {
+            m_oversized.push_back(handle);
+            return;
+        }
+        for (int y = c.y0; y <= c.y1; ++y) {
+            for (int x = c.x0; x <= c.x1; ++x) {
+                m_cells[cellKey(x, y)].push_back(handle);
+            }
+        }
+    }
+
+    void UniformGrid::unlink(Handle handle) {
+        const auto& c = m_items[handle].cells;
+        if (c.oversized) {
+            auto pos = std::find(m_oversized.begin(), m_oversized.end(), handle);
+            if (pos != m_oversized.end()) {
+                *pos = m_oversized.back();
+                m_oversized.pop_back();
+            }
+            return;
+        }
+        for (int y = c.y0; y <= c.y1; ++y) {
+            for (int x = c.x0; x <= c.x1; ++x) {
+                auto it = m_cells.find(cellKey(x, y));
+                if (it == m_cells.end()) continue;
+
+                auto& list = it->second;
+                auto pos = std::find(list.begin(), list.end(), handle);
+                if (pos != list.end()) {
+                    *pos = list.back(); // Cell order doesn't matter
+                    list.pop_back();
+                }
+                if (list.empty()) m_cells.erase(it);
+            }
+        }
+    }
+
+    UniformGrid::Handle UniformGrid::insert(const Command& command, const AABB& worldBounds) {
+        Handle handle;
+        if (!m_freeHandles.empty()) {
+            handle = m_freeHandles.back();
+            m_freeHandles.pop_back();
+        } else {
+            handle = static_cast<Handle>(m_items.size());
+            m_items.emplace_back();
+        }
+
+        auto& item = m_items[handle];
+        item.command = command;
+        item.bounds = worldBounds;
+        item.cells = cellsFor(worldBounds);
+        item.stamp = 0;
+        item.alive = true;
+
+        link(handle);
+        return handle;
+    }
+
+    void UniformGrid::update(Handle handle, const AABB& worldBounds, uint64_t sortKey) {
+        if (handle >= m_items.size() || !m_items[handle].alive) return;
+
+        auto& item = m_items[handle];
+        item.bounds = worldBounds;
+        item.command.sortKey = sortKey;
+
+        CellRange cells = cellsFor(worldBounds);
+        if (cells == item.cells) return;
+
+        unlink(handle);
+        item.cells = cells;
+        link(handle);
+    }
+
+    void UniformGrid::remove(Handle handle) {
+        if (handle >= m_items.size() || !m_items[handle].alive) return;
+
+        unlink(handle);
+        m_items[handle].alive = false;
+        m_freeHandles.push_back(handle);
+    }
+
+    void UniformGrid::clear() {
+        m_cells.clear();
+        m_items.clear();
+        m_oversized.clear();
+        m_freeHandles.clear();
+    }
+
+    void UniformGrid::query(const AABB& area, std::vector<Command>& out) {
+        if (++m_stamp == 0) {
+            // Wrapped, old stamps could now collide
+            for (auto& item : m_items) item.stamp = 0;
+            m_stamp = 1;
+        }
+
+        const CellRange range = cellsFor(area);
+
+        // A huge query box would touch more (mostly empty) cells than exist, so walk the occupied cells instead
+        const auto spanX = static_cast<uint64_t>(static_cast<int64_t>(range.x1) - range.x0 + 1);
+        const auto spanY = static_cast<uint64_t>(static_cast<int64_t>(range.y1) - range.y0 + 1);
+
+        auto visit = [&](const std::vector<Handle>& list) {
+            for (Handle h : list) {
+                auto& item = m_items[h];
+                if (item.stamp == m_stamp) continue;
+                item.stamp = m_stamp;
+                if (item.bounds.overlaps(area)) out.push_back(item.command);
+            }
+        };
+
+        visit(m_oversized);
+
+        if (spanX * spanY > m_cells.size()) {
+            for (const auto& [key, list] : m_cells) {
+                const int x = static_cast<int>(static_cast<int32_t>(key >> 32));
+                const int y = static_cast<int>(static_cast<int32_t>(key & 0xFFFFFFFFu));
+                if (x < range.x0 || x > range.x1 || y < range.y0 || y > range.y1) continue;
+                visit(list);
+            }
+        } else {
+            for (int y = range.y0; y <= range.y1; ++y) {
+                for (int x = range.x0; x <= range.x1; ++x) {
+                    auto it = m_cells.find(cellKey(x, y));
+                    if (it != m_cells.end()) visit(it->second);
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,195 @@
+//
+// Created by Dextron12 on 17/10/26.
+//
+
+#include <renderer/FrameProfiler.hpp>
+
+#include <core/Error.hpp>
+
+#include <fstream>
+
+namespace Dexium::Renderer {
+
+    void FrameProfiler::beginFrame() {
+        m_active = enabled;
+        if (!m_active) return;
+
+        m_slot = &m_slots[m_frame % FrameLatency];
+
+        // This slot was last used FrameLatency frames ago. If the GPU still isn't done with it, drop its results rather than stall
+        if (m_slot->pending) resolve(*m_slot, true);
+
+        if (m_slot->frameStart == 0) {
+            glGenQueries(1, &m_slot->frameStart);
+            glGenQueries(1, &m_slot->frameEnd);
+        }
+
+        m_current = {};
+        m_current.frame = m_frame;
+        m_frameStart = Clock::now();
+
+        glQueryCounter(m_slot->frameStart, GL_TIMESTAMP);
+    }
+
+    void FrameProfiler::beginPass(const std::string& passName, size_t commandCount) {
+        if (!m_active) return;
+
+        const size_t index = m_current.passes.size();
+
+        PassTiming pass;
+        pass.passName = passName.empty() ? "pass" + std::to_string(index) : passName;
+        pass.commands = commandCount;
+        m_current.passes.push_back(std::move(pass));
+
+        if (m_slot->passQueries.size() <= index) {
+            GLuint query = 0;
+            glGenQueries(1, &query);
+            m_slot->passQueries.push_back(query);
+        }
+
+        m_passStart = Clock::now();
+        glBeginQuery(GL_TIME_ELAPSED, m_slot->passQueries[index]);
+    }
+
+    void FrameProfiler::endPass() {
+        if (!m_active) return;
+
+        glEndQuery(GL_TIME_ELAPSED);
+        m_current.passes.back().cpuTotalMs = msBetween(m_passStart, Clock::now());
+    }
+
+    void FrameProfiler::addPhase(Phase phase, Clock::time_point& since) {
+        if (!m_active) return;
+
+        const auto now = Clock::now();
+        const double ms = msBetween(since, now);
+        since = now;
+
+        auto& pass = m_current.passes.back();
+        switch (phase) {
+            case Phase::Sort: pass.cpuSortMs += ms; break;
+            case Phase::Bind: pass.cpuBindMs += ms; break;
+            case Phase::Draw: pass.cpuDrawMs += ms; break;
+        }
+    }
+
+    void FrameProfiler::endFrame() {
+        if (!m_active) return;
+
+        glQueryCounter(m_slot->frameEnd, GL_TIMESTAMP);
+        m_current.cpuMs = msBetween(m_frameStart, Clock::now());
+
+        m_slot->timing = std::move(m_current);
+        m_slot->pending = true;
+
+        // Pick up whatever older frames have finished, oldest first so history stays in order
+        for (size_t age = FrameLatency - 1; age > 0; --age) {
+            if (m_frame < age) continue;
+            Slot& older = m_slots[(m_frame - age) % FrameLatency];
+            if (older.pending && !resolve(older, false)) break; // GPU finishes in order, newer ones won't be ready either
+        }
+
+        ++m_frame;
+    }
+
+    bool FrameProfiler::resolve(Slot& slot, bool discardIfNotReady) {
+        GLint available = 0;
+        glGetQueryObjectiv(slot.frameEnd, GL_QUERY_RESULT_AVAILABLE, &available); // Queries complete in order, the last one covers the rest
+
+        if (available) {
+            GLuint64 start = 0, end = 0;
+            glGetQueryObjectui64v(slot.frameStart, GL_QUERY_RESULT, &start);
+            glGetQueryObjectui64v(slot.frameEnd, GL_QUERY_RESULT, &end);
+            slot.timing.gpuMs = static_cast<double>(end - start) / 1e6;
+
+            for (size_t i = 0; i < slot.timing.passes.size(); ++i) {
+                GLuint64 ns = 0;
+                glGetQueryObjectui64v(slot.passQueries[i], GL_QUERY_RESULT, &ns);
+                slot.timing.passes[i].gpuMs = static_cast<double>(ns) / 1e6;
+            }
+        } else if (!discardIfNotReady) {
+            return false;
+        }
+
+        slot.pending = false;
+        pushHistory(std::move(slot.timing));
+        return true;
+    }
+
+    void FrameProfiler::pushHistory(FrameTiming&& timing) {
+        m_history.push_back(std::move(timing));
+        while (m_history.size() > historySize) m_history.pop_front();
+    }
+
+    std::unordered_map<std::string, FrameProfiler::PassTiming> FrameProfiler::summary(size_t frames) const {
+        std::unordered_map<std::string, PassTiming> out;
+        std::unordered_map<std::string, size_t> samples, gpuSamples;
+        std::unordered_map<std::string, double> gpuSum;
+
+        const size_t first = m_history.size() > frames ? m_history.size() - frames : 0;
+        for (size_t f = first; f < m_history.size(); ++f) {
+            for (const auto& pass : m_history[f].passes) {
+                auto& acc = out[pass.passName];
+                acc.passName = pass.passName;
+                acc.commands += pass.commands;
+                acc.drawCalls += pass.drawCalls;
+                acc.cpuSortMs += pass.cpuSortMs;
+                acc.cpuBindMs += pass.cpuBindMs;
+                acc.cpuDrawMs += pass.cpuDrawMs;
+                acc.cpuTotalMs += pass.cpuTotalMs;
+                ++samples[pass.passName];
+
+                if (pass.gpuMs >= 0.0) {
+                    gpuSum[pass.passName] += pass.gpuMs;
+                    ++gpuSamples[pass.passName];
+                }
+            }
+        }
+
+        for (auto& [name, acc] : out) {
+            const size_t n = samples[name];
+            acc.commands /= n;
+            acc.drawCalls /= n;
+            acc.cpuSortMs /= n;
+            acc.cpuBindMs /= n;
+            acc.cpuDrawMs /= n;
+            acc.cpuTotalMs /= n;
+            if (gpuSamples[name] > 0) acc.gpuMs = gpuSum[name] / static_cast<double>(gpuSamples[name]);
+        }
+        return out;
+    }
+
+    bool FrameProfiler::dumpCSV(const std::filesystem::path& path) const {
+        std::ofstream file(path);
+        if (!file) {
+            TraceLog(LogLevel::ERROR, "[FrameProfiler]: Failed to open '{}' for writing", path.string());
+            return false;
+        }
+
+        file << "frame,pass,commands,draw_calls,cpu_sort_ms,cpu_bind_ms,cpu_draw_ms,cpu_total_ms,gpu_ms\n";
+        for (const auto& frame : m_history) {
+            for (const auto& p : frame.passes) {
+                file << frame.frame << ',' << p.passName << ',' << p.commands << ',' << p.drawCalls << ','
+                     << p.cpuSortMs << ',' << p.cpuBindMs << ',' << p.cpuDrawMs << ',' << p.cpuTotalMs << ',' << p.gpuMs << '\n';
+            }
+            file << frame.frame << ",<frame>,,,,,," << frame.cpuMs << ',' << frame.gpuMs << '\n';
+        }
+
+        TraceLog(LogLevel::STATUS, "[FrameProfiler]: Wrote {} frames to '{}'", m_history.size(), path.string());
+        return true;
+    }
+
+    void FrameProfiler::destroy() {
+        for (auto& slot : m_slots) {
+            if (!slot.passQueries.empty()) {
+                glDeleteQueries(static_cast<GLsizei>(slot.passQueries.size()), slot.passQueries.data());
+            }
+            if (slot.frameStart != 0) {
+                glDeleteQueries(1, &slot.frameStart);
+                glDeleteQueries(1, &slot.frameEnd);
+            }
+            slot = {};
+        }
+        m_active = false;
+    }
+}
@@ -0,0 +1,213 @@
+//
+// Created by Dextron12 on 17/10/26.
+//
+
+#include <renderer/GLStateCache.hpp>
+
+namespace Dexium::Renderer {
+
+    GLStateCache& GLStateCache::get() {
+        static GLStateCache cache;
+        return cache;
+    }
+
+    int GLStateCache::capIndex(GLenum cap) {
+        switch (cap) {
+            case GL_DEPTH_TEST: return 0;
+            case GL_BLEND: return 1;
+            case GL_CULL_FACE: return 2;
+            case GL_SCISSOR_TEST: return 3;
+            default: return -1;
+        }
+    }
+
+    int GLStateCache::bufferIndex(GLenum target) {
+        switch (target) {
+            case GL_ARRAY_BUFFER: return 0;
+            case GL_UNIFORM_BUFFER: return 1;
+            case GL_DRAW_INDIRECT_BUFFER: return 2;
+            case GL_PIXEL_UNPACK_BUFFER: return 3;
+            case GL_COPY_READ_BUFFER: return 4;
+            case GL_COPY_WRITE_BUFFER: return 5;
+            default: return -1; // Includes GL_ELEMENT_ARRAY_BUFFER (VAO state)
+        }
+    }
+
+    void GLStateCache::setCapability(GLenum cap, bool enabled) {
+        int idx = capIndex(cap);
+        Tri want = enabled ? Tri::On : Tri::Off;
+
+        if (idx >= 0) {
+            if (!changed(m_caps[idx] == want)) return;
+            m_caps[idx] = want;
+        } else {
+            ++m_stats.issued;
+        }
+
+        if (enabled) glEnable(cap);
+        else glDisable(cap);
+    }
+
+    void GLStateCache::setDepthFunc(GLenum func) {
+        if (!changed(m_depthFuncKnown && m_depthFunc == func)) return;
+        m_depthFuncKnown = true;
+        m_depthFunc = func;
+        glDepthFunc(func);
+    }
+
+    void GLStateCache::setDepthMask(bool write) {
+        Tri want = write ? Tri::On : Tri::Off;
+        if (!changed(m_depthMask == want)) return;
+        m_depthMask = want;
+        glDepthMask(write ? GL_TRUE : GL_FALSE);
+    }
+
+    void GLStateCache::setBlendFunc(GLenum src, GLenum dst) {
+        if (!changed(m_blendKnown && m_blendSrc == src && m_blendDst == dst)) return;
+        m_blendKnown = true;
+        m_blendSrc = src;
+        m_blendDst = dst;
+        glBlendFunc(src, dst);
+    }
+
+    void GLStateCache::setClearColour(float r, float g, float b, float a) {
+        std::array<float, 4> col{r, g, b, a};
+        if (!changed(m_clearKnown && m_clearColour == col)) return;
+        m_clearKnown = true;
+        m_clearColour = col;
+        glClearColor(r, g, b, a);
+    }
+
+    void GLStateCache::setViewport(int x, int y, int w, int h) {
+        std::array<int, 4> vp{x, y, w, h};
+        if (!changed(m_viewportKnown && m_viewport == vp)) return;
+        m_viewportKnown = true;
+        m_viewport = vp;
+        glViewport(x, y, w, h);
+    }
+
+    void GLStateCache::bindFramebuffer(GLuint fbo) {
+        if (!changed(m_framebuffer == fbo)) return;
+        m_framebuffer = fbo;
+        glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    }
+
+    void GLStateCache::useProgram(GLuint program) {
+        if (!changed(m_program == program)) return;
+        m_program = program;
+        glUseProgram(program);
+    }
+
+    void GLStateCache::bindVertexArray(GLuint vao) {
+        if (!changed(m_vao == vao)) return;
+        m_vao = vao;
+        glBindVertexArray(vao);
+    }
+
+    void GLStateCache::bindBuffer(GLenum target, GLuint buffer) {
+        int idx = bufferIndex(target);
+        if (idx >= 0) {
+            if (!changed(m_buffers[idx] == buffer)) return;
+            m_buffers[idx] = buffer;
+        } else {
+            ++m_stats.issued;
+        }
+        glBindBuffer(target, buffer);
+    }
+
+    void GLStateCache::bindBufferBase(GLenum target, GLuint index, GLuint buffer) {
+        if (target == GL_UNIFORM_BUFFER && index < MaxUniformBindings) {
+            if (!m_uniformBindingsKnown) {
+                m_uniformBindings.fill(Unknown);
+                m_uniformBindingsKnown = true;
+            }
+            if (!changed(m_uniformBindings[index] == buffer)) return;
+            m_uniformBindings[index] = buffer;
+        } else {
+            ++m_stats.issued;
+        }
+
+        glBindBufferBase(target, index, buffer);
+
+        int idx = bufferIndex(target);
+        if (idx >= 0) m_buffers[idx] = buffer;
+    }
+
+    void GLStateCache::activeTexture(GLuint unit) {
+        if (!changed(m_activeUnit == unit)) return;
+        m_activeUnit = unit;
+        glActiveTexture(GL_TEXTURE0 + unit);
+    }
+
+    void GLStateCache::bindTexture(GLuint unit, GLenum target, GLuint texture) {
+        if (m_units.empty()) {
+            GLint maxUnits = 0;
+            glGetIntegerv(GL_MAX_COMBINED_TEXTURE_IMAGE_UNITS, &maxUnits);
+            m_units.resize(maxUnits > 0 ? static_cast<size_t>(maxUnits) : 16);
+        }
+
+        if (unit < m_units.size()) {
+            auto& binding = m_units[unit];
+            if (!changed(binding.target == target && binding.texture == texture)) return;
+            binding = {target, texture};
+        } else {
+            ++m_stats.issued;
+        }
+
+        activeTexture(unit);
+        glBindTexture(target, texture);
+    }
+
+    void GLStateCache::bindTexture(GLenum target, GLuint texture) {
+        if (m_activeUnit == Unknown) {
+            // We don't know which unit is active, so pick one and remember it
+            activeTexture(0);
+        }
+        bindTexture(m_activeUnit, target, texture);
+    }
+
+    void GLStateCache::forgetBuffer(GLuint buffer) {
+        for (auto& b : m_buffers) {
+            if (b == buffer) b = 0;
+        }
+        for (auto& b : m_uniformBindings) {
+            if (b == buffer) b = 0;
+        }
+    }
+
+    void GLStateCache::forgetTexture(GLuint texture) {
+        for (auto& u : m_units) {
+            if (u.texture == texture) u.texture = 0;
+        }
+    }
+
+    void GLStateCache::forgetVertexArray(GLuint vao) {
+        if (m_vao == vao) m_vao = 0;
+    }
+
+    void GLStateCache::forgetProgram(GLuint program) {
+        // Deleting the active program only flags it for deletion, it stays bound. So just stop trusting it
+        if (m_program == program) m_program = Unknown;
+    }
+
+    void GLStateCache::forgetFramebuffer(GLuint fbo) {
+        // Deleting the bound FBO reverts the binding to the default framebuffer
+        if (m_framebuffer == fbo) m_framebuffer = 0;
+    }
+
+    void GLStateCache::invalidate() {
+        m_caps.fill(Tri::Unknown);
+        m_depthFuncKnown = false;
+        m_depthMask = Tri::Unknown;
+        m_blendKnown = false;
+        m_clearKnown = false;
+        m_viewportKnown = false;
+        m_framebuffer = Unknown;
+        m_program = Unknown;
+        m_vao = Unknown;
+        m_buffers.fill(Unknown);
+        m_uniformBindingsKnown = false;
+        m_activeUnit = Unknown;
+        m_units.assign(m_units.size(), UnitBinding{});
+    }
+}
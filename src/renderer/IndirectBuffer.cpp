@@ -0,0 +1,98 @@
+//
+// Created by Dextron12 on 17/10/26.
+//
+
+#include <renderer/IndirectBuffer.hpp>
+#include <renderer/GLStateCache.hpp>
+
+#include <core/VertexLayout.hpp>
+
+#include <algorithm>
+#include <cstring>
+
+namespace Dexium::Renderer {
+
+    namespace {
+        bool hasExtension(const char* name) {
+            GLint count = 0;
+            glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+            for (GLint i = 0; i < count; ++i) {
+                const auto* ext = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, static_cast<GLuint>(i)));
+                if (ext && std::strcmp(ext, name) == 0) return true;
+            }
+            return false;
+        }
+    }
+
+    IndirectBuffer::IndirectBuffer(IndirectBuffer&& other) noexcept
+        : m_buffer(other.m_buffer), m_capacity(other.m_capacity) {
+        other.m_buffer = 0;
+        other.m_capacity = 0;
+    }
+
+    IndirectBuffer& IndirectBuffer::operator=(IndirectBuffer&& other) noexcept {
+        if (this != &other) {
+            destroy();
+            m_buffer = other.m_buffer;
+            m_capacity = other.m_capacity;
+            other.m_buffer = 0;
+            other.m_capacity = 0;
+        }
+        return *this;
+    }
+
+    void IndirectBuffer::destroy() {
+        if (m_buffer != 0) {
+            glDeleteBuffers(1, &m_buffer);
+            GLStateCache::get().forgetBuffer(m_buffer);
+        }
+        m_buffer = 0;
+        m_capacity = 0;
+    }
+
+    bool IndirectBuffer::multiDrawSupported() {
+        // glad is core only, so on an older context the ARB entry point is only there if the loader happened to find it
+        static const bool supported = glMultiDrawElementsIndirect != nullptr &&
+            (GLAD_GL_VERSION_4_3 || hasExtension("GL_ARB_multi_draw_indirect"));
+        return supported;
+    }
+
+    bool IndirectBuffer::baseInstanceSupported() {
+        static const bool supported = glDrawElementsInstancedBaseVertexBaseInstance != nullptr &&
+            (GLAD_GL_VERSION_4_2 || hasExtension("GL_ARB_base_instance"));
+        return supported;
+    }
+
+    void IndirectBuffer::draw(GLenum mode, GLenum indexType, const std::vector<DrawElementsIndirectCommand>& commands) {
+        if (commands.empty()) return;
+
+        if (!multiDrawSupported()) {
+            const uintptr_t indexSize = Core::indexTypeSize(indexType);
+            for (const auto& cmd : commands) {
+                glDrawElementsInstancedBaseVertexBaseInstance(mode, static_cast<GLsizei>(cmd.count), indexType,
+                    reinterpret_cast<const void*>(static_cast<uintptr_t>(cmd.firstIndex) * indexSize),
+                    static_cast<GLsizei>(cmd.instanceCount), cmd.baseVertex, cmd.baseInstance);
+            }
+            return;
+        }
+
+        auto& gl = GLStateCache::get();
+        if (m_buffer == 0) {
+            glGenBuffers(1, &m_buffer);
+        }
+        gl.bindBuffer(GL_DRAW_INDIRECT_BUFFER, m_buffer);
+
+        if (commands.size() > m_capacity) {
+            // Grow geometrically, like InstanceBuffer
+            m_capacity = std::max(commands.size(), m_capacity * 2);
+            if (m_capacity < 64) m_capacity = 64;
+        }
+
+        // Orphan, then fill, so we never wait on the previous run's draws
+        const auto bytes = static_cast<GLsizeiptr>(commands.size() * sizeof(DrawElementsIndirectCommand));
+        glBufferData(GL_DRAW_INDIRECT_BUFFER, static_cast<GLsizeiptr>(m_capacity * sizeof(DrawElementsIndirectCommand)), nullptr, GL_STREAM_DRAW);
+        glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, bytes, commands.data());
+
+        glMultiDrawElementsIndirect(mode, indexType, nullptr, static_cast<GLsizei>(commands.size()), 0);
+    }
+}
@@ -0,0 +1,150 @@
+//
+// Created by Dextron12 on 17/10/26.
+//
+
+#include <renderer/InstanceBuffer.hpp>
+#include <renderer/GLStateCache.hpp>
+
+#include <core/Error.hpp>
+#include <core/TransformBuffer.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <unordered_map>
+
+namespace Dexium::Renderer {
+
+    namespace {
+        // (vao << 32 | location) -> the instance buffer attached there. Shared, so forget() reaches every InstanceBuffer
+        // (and a VAO another one attached to gets re-pointed)
+        std::unordered_map<uint64_t, GLuint>& attachments() {
+            static std::unordered_map<uint64_t, GLuint> s_attachments;
+            return s_attachments;
+        }
+
+        uint64_t attachKey(GLuint vao, GLuint location) {
+            return (static_cast<uint64_t>(vao) << 32) | location;
+        }
+    }
+
+    InstanceBuffer::InstanceBuffer(InstanceBuffer&& other) noexcept
+        : m_buffer(other.m_buffer), m_capacity(other.m_capacity), m_staging(std::move(other.m_staging)) {
+        other.m_buffer = 0;
+        other.m_capacity = 0;
+    }
+
+    InstanceBuffer& InstanceBuffer::operator=(InstanceBuffer&& other) noexcept {
+        if (this != &other) {
+            destroy();
+            m_buffer = other.m_buffer;
+            m_capacity = other.m_capacity;
+            m_staging = std::move(other.m_staging);
+            other.m_buffer = 0;
+            other.m_capacity = 0;
+        }
+        return *this;
+    }
+
+    void InstanceBuffer::orphan(size_t count) {
+        if (m_buffer == 0) {
+            glGenBuffers(1, &m_buffer);
+        }
+
+        GLStateCache::get().bindBuffer(GL_ARRAY_BUFFER, m_buffer);
+
+        if (count > m_capacity) {
+            // Grow geometrically so a slowly growing scene doesn't realloc every frame
+            m_capacity = std::max(count, m_capacity * 2);
+            if (m_capacity < 256) m_capacity = 256;
+        }
+
+        // Orphan, then fill. Same buffer name, so VAOs attached to it stay valid
+        glBufferData(GL_ARRAY_BUFFER, m_capacity * sizeof(glm::mat4), nullptr, GL_STREAM_DRAW);
+    }
+
+    void InstanceBuffer::upload(const glm::mat4* matrices, size_t count) {
+        orphan(count);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, count * sizeof(glm::mat4), matrices);
+
+        GLStateCache::get().bindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+    void InstanceBuffer::upload(const Core::TransformBuffer& transforms) {
+        const size_t count = transforms.size();
+        orphan(count);
+
+        if (count > 0) {
+            // The storage was just orphaned, so the map never waits on the GPU
+            const auto bytes = static_cast<GLsizeiptr>(count * sizeof(glm::mat4));
+            void* mapped = glMapBufferRange(GL_ARRAY_BUFFER, 0, bytes, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+            if (mapped) {
+                transforms.computeMatrices(static_cast<glm::mat4*>(mapped));
+                if (!glUnmapBuffer(GL_ARRAY_BUFFER)) {
+                    // The storage was lost (mode switch etc), so write it the slow way
+                    mapped = nullptr;
+                }
+            }
+            if (!mapped) {
+                m_staging.resize(count);
+                transforms.computeMatrices(m_staging.data());
+                glBufferSubData(GL_ARRAY_BUFFER, 0, bytes, m_staging.data());
+            }
+        }
+
+        GLStateCache::get().bindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+    void InstanceBuffer::attach(GLuint vao, GLuint location) {
+        auto& gl = GLStateCache::get();
+        gl.bindVertexArray(vao);
+
+        auto& attached = attachments()[attachKey(vao, location)];
+        if (attached != 0 && attached == m_buffer) return;
+
+        if (m_buffer == 0) {
+            TraceLog(LogLevel::WARNING, "[InstanceBuffer]: Attaching VAO({}) before anything was uploaded", vao);
+            glGenBuffers(1, &m_buffer);
+        }
+
+        gl.bindBuffer(GL_ARRAY_BUFFER, m_buffer);
+
+        // A mat4 attribute is 4 vec4 columns, each its own attrib location
+        for (GLuint col = 0; col < 4; ++col) {
+            glEnableVertexAttribArray(location + col);
+            glVertexAttribPointer(location + col, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void*)(sizeof(glm::vec4) * col));
+            glVertexAttribDivisor(location + col, 1);
+        }
+
+        // Unbind the array buffer (the VAO keeps its own reference)
+        gl.bindBuffer(GL_ARRAY_BUFFER, 0);
+
+        attached = m_buffer;
+    }
+
+    void InstanceBuffer::destroy() {
+        if (m_buffer != 0) {
+            // GL may hand the name out again, so the VAOs pointing at it have to re-attach
+            auto& attached = attachments();
+            for (auto it = attached.begin(); it != attached.end(); ) {
+                if (it->second == m_buffer) it = attached.erase(it);
+                else ++it;
+            }
+
+            glDeleteBuffers(1, &m_buffer);
+            GLStateCache::get().forgetBuffer(m_buffer);
+        }
+
+        m_buffer = 0;
+        m_capacity = 0;
+        m_staging.clear();
+        m_staging.shrink_to_fit();
+    }
+
+    void InstanceBuffer::forget(GLuint vao) {
+        auto& attached = attachments();
+        for (auto it = attached.begin(); it != attached.end(); ) {
+            if (static_cast<GLuint>(it->first >> 32) == vao) it = attached.erase(it);
+            else ++it;
+        }
+    }
+}
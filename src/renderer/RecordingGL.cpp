@@ -0,0 +1,932 @@
+//
+// Created by Dextron12 on 17/10/26.
+//
+
+#include <renderer/RecordingGL.hpp>
+#include <renderer/GLStateCache.hpp>
+
+#include <core/Error.hpp>
+
+#include <glad/gl.h>
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+
+namespace Dexium::Renderer {
+
+    namespace {
+
+        // Fake driver state, only what's needed to answer the queries Dexium makes
+        struct Program {
+            std::vector<GLuint> shaders;
+            std::string source; // Attached shader sources, joined at link
+            std::unordered_map<std::string, GLint> locations;
+            std::vector<std::string> blocks;
+            std::vector<GLint> blockSizes; // std140 GL_UNIFORM_BLOCK_DATA_SIZE, parallel to blocks
+
+            struct Active {
+                std::string name;
+                GLenum type;
+                GLint size;
+                GLint block = -1; // Index into blocks, -1 for the default block
+                GLint offset = -1; // std140 byte offset inside the block
+            };
+            std::vector<Active> active; // Active uniforms, in declaration order (glGetActiveUniform)
+            bool linked = true; // Only a rejected glProgramBinary fails
+            int completionPolls = 0; // GL_COMPLETION_STATUS_KHR reads "still compiling" the first time it's asked
+        };
+
+        struct State {
+            int major = 4, minor = 6;
+            std::string version;
+
+            // Names are handed out per kind, so adding one kind of object never shifts another's names
+            GLuint nextBuffer = 1, nextTexture = 1, nextVAO = 1, nextFBO = 1, nextRBO = 1, nextQuery = 1, nextShader = 1;
+            uintptr_t nextSync = 1;
+
+            std::unordered_map<GLuint, std::string> shaderSources;
+            std::unordered_map<GLuint, Program> programs; // Shaders & programs share a namespace, like real GL
+
+            std::unordered_map<GLenum, GLuint> boundBuffers;
+            std::unordered_map<GLuint, std::unique_ptr<std::vector<unsigned char>>> storage; // Backing memory for glMapBufferRange
+            struct Mapping {
+                size_t offset, length;
+                bool explicitFlush; // Only the flushed ranges count as uploaded then
+            };
+            std::unordered_map<GLenum, Mapping> mappings;
+        };
+
+        State s_state;
+
+        RecordingGL& rec() { return RecordingGL::get(); }
+
+        // A macro so the arguments (enum names, data hashes...) are only built when logging is on
+        #define DEXIUM_REC_LOG(...) do { \
+            auto& r_ = rec(); \
+            ++r_.counters().calls; \
+            if (r_.logging) r_.record(fmt::format(__VA_ARGS__)); \
+        } while (0)
+
+        std::string enumName(GLenum e) {
+            switch (e) {
+                case GL_ARRAY_BUFFER: return "GL_ARRAY_BUFFER";
+                case GL_ELEMENT_ARRAY_BUFFER: return "GL_ELEMENT_ARRAY_BUFFER";
+                case GL_UNIFORM_BUFFER: return "GL_UNIFORM_BUFFER";
+                case GL_DRAW_INDIRECT_BUFFER: return "GL_DRAW_INDIRECT_BUFFER";
+                case GL_PIXEL_UNPACK_BUFFER: return "GL_PIXEL_UNPACK_BUFFER";
+                case GL_COPY_READ_BUFFER: return "GL_COPY_READ_BUFFER";
+                case GL_COPY_WRITE_BUFFER: return "GL_COPY_WRITE_BUFFER";
+                case GL_PROGRAM_BINARY_RETRIEVABLE_HINT: return "GL_PROGRAM_BINARY_RETRIEVABLE_HINT";
+                case GL_STATIC_DRAW: return "GL_STATIC_DRAW";
+                case GL_DYNAMIC_DRAW: return "GL_DYNAMIC_DRAW";
+                case GL_STREAM_DRAW: return "GL_STREAM_DRAW";
+                case GL_TEXTURE_2D: return "GL_TEXTURE_2D";
+                case GL_TEXTURE_2D_ARRAY: return "GL_TEXTURE_2D_ARRAY";
+                case GL_TEXTURE_MIN_FILTER: return "GL_TEXTURE_MIN_FILTER";
+                case GL_TEXTURE_MAG_FILTER: return "GL_TEXTURE_MAG_FILTER";
+                case GL_TEXTURE_WRAP_S: return "GL_TEXTURE_WRAP_S";
+                case GL_TEXTURE_WRAP_T: return "GL_TEXTURE_WRAP_T";
+                case GL_NEAREST: return "GL_NEAREST";
+                case GL_LINEAR: return "GL_LINEAR";
+                case GL_LINEAR_MIPMAP_LINEAR: return "GL_LINEAR_MIPMAP_LINEAR";
+                case GL_NEAREST_MIPMAP_NEAREST: return "GL_NEAREST_MIPMAP_NEAREST";
+                case GL_REPEAT: return "GL_REPEAT";
+                case GL_CLAMP_TO_EDGE: return "GL_CLAMP_TO_EDGE";
+                case GL_RED: return "GL_RED";
+                case GL_RG: return "GL_RG";
+                case GL_RGB: return "GL_RGB";
+                case GL_RGBA: return "GL_RGBA";
+                case GL_RGBA8: return "GL_RGBA8";
+                case GL_DEPTH24_STENCIL8: return "GL_DEPTH24_STENCIL8";
+                case GL_UNSIGNED_BYTE: return "GL_UNSIGNED_BYTE";
+                case GL_UNSIGNED_SHORT: return "GL_UNSIGNED_SHORT";
+                case GL_UNSIGNED_INT: return "GL_UNSIGNED_INT";
+                case GL_FLOAT: return "GL_FLOAT";
+                case GL_HALF_FLOAT: return "GL_HALF_FLOAT";
+                case GL_INT_2_10_10_10_REV: return "GL_INT_2_10_10_10_REV";
+                case GL_TRIANGLES: return "GL_TRIANGLES";
+                case GL_FRAMEBUFFER: return "GL_FRAMEBUFFER";
+                case GL_RENDERBUFFER: return "GL_RENDERBUFFER";
+                case GL_COLOR_ATTACHMENT0: return "GL_COLOR_ATTACHMENT0";
+                case GL_DEPTH_STENCIL_ATTACHMENT: return "GL_DEPTH_STENCIL_ATTACHMENT";
+                case GL_DEPTH_TEST: return "GL_DEPTH_TEST";
+                case GL_BLEND: return "GL_BLEND";
+                case GL_CULL_FACE: return "GL_CULL_FACE";
+                case GL_SCISSOR_TEST: return "GL_SCISSOR_TEST";
+                case GL_NEVER: return "GL_NEVER";
+                case GL_LESS: return "GL_LESS";
+                case GL_EQUAL: return "GL_EQUAL";
+                case GL_LEQUAL: return "GL_LEQUAL";
+                case GL_GREATER: return "GL_GREATER";
+                case GL_GEQUAL: return "GL_GEQUAL";
+                case GL_ALWAYS: return "GL_ALWAYS";
+                case GL_SRC_ALPHA: return "GL_SRC_ALPHA";
+                case GL_ONE_MINUS_SRC_ALPHA: return "GL_ONE_MINUS_SRC_ALPHA";
+                case GL_VERTEX_SHADER: return "GL_VERTEX_SHADER";
+                case GL_FRAGMENT_SHADER: return "GL_FRAGMENT_SHADER";
+                case GL_TIME_ELAPSED: return "GL_TIME_ELAPSED";
+                case GL_TIMESTAMP: return "GL_TIMESTAMP";
+                case GL_BACK: return "GL_BACK";
+                case GL_NONE: return "GL_NONE"; // Also GL_ZERO & GL_FALSE
+                case GL_ONE: return "GL_ONE";
+                default: break;
+            }
+            if (e >= GL_TEXTURE0 && e < GL_TEXTURE0 + 32) return fmt::format("GL_TEXTURE{}", e - GL_TEXTURE0);
+            return fmt::format("0x{:04X}", e);
+        }
+
+        // FNV-1a, so uploaded data shows up in the stream without dumping it
+        std::string dataTag(const void* data, size_t bytes) {
+            if (!data) return fmt::format("null[{}]", bytes);
+
+            uint32_t hash = 2166136261u;
+            const auto* p = static_cast<const unsigned char*>(data);
+            for (size_t i = 0; i < bytes; ++i) {
+                hash ^= p[i];
+                hash *= 16777619u;
+            }
+            return fmt::format("data[{}]#{:08x}", bytes, hash);
+        }
+
+        size_t pixelBytes(GLenum format, GLenum type) {
+            size_t channels = 4;
+            switch (format) {
+                case GL_RED: channels = 1; break;
+                case GL_RG: channels = 2; break;
+                case GL_RGB: channels = 3; break;
+                default: break;
+            }
+            size_t size = 1;
+            switch (type) {
+                case GL_UNSIGNED_SHORT: size = 2; break;
+                case GL_UNSIGNED_INT: case GL_FLOAT: size = 4; break;
+                default: break;
+            }
+            return channels * size;
+        }
+
+        std::string floats(const GLfloat* v, size_t count) {
+            std::string out;
+            for (size_t i = 0; i < count; ++i) {
+                if (i) out += ", ";
+                out += fmt::format("{:g}", v[i]);
+            }
+            return out;
+        }
+
+        bool isIdent(char c) { return std::isalnum(static_cast<unsigned char>(c)) || c == '_'; }
+
+        // True if name appears as a whole word in source, optionally only straight after the "uniform" keyword
+        bool declares(const std::string& source, const std::string& name, bool afterUniform) {
+            for (size_t pos = source.find(name); pos != std::string::npos; pos = source.find(name, pos + 1)) {
+                const size_t end = pos + name.size();
+                if ((pos > 0 && isIdent(source[pos - 1])) || (end < source.size() && isIdent(source[end]))) continue;
+                if (!afterUniform) return true;
+
+                size_t before = pos;
+                while (before > 0 && std::isspace(static_cast<unsigned char>(source[before - 1]))) --before;
+                if (before >= 7 && source.compare(before - 7, 7, "uniform") == 0) return true;
+            }
+            return false;
+        }
+
+        GLenum glslType(const std::string& type) {
+            if (type == "float") return GL_FLOAT;
+            if (type == "vec2") return GL_FLOAT_VEC2;
+            if (type == "vec3") return GL_FLOAT_VEC3;
+            if (type == "vec4") return GL_FLOAT_VEC4;
+            if (type == "mat3") return GL_FLOAT_MAT3;
+            if (type == "mat4") return GL_FLOAT_MAT4;
+            if (type == "int") return GL_INT;
+            if (type == "uint") return GL_UNSIGNED_INT;
+            if (type == "bool") return GL_BOOL;
+            if (type == "sampler2D") return GL_SAMPLER_2D;
+            if (type == "sampler2DArray") return GL_SAMPLER_2D_ARRAY;
+            return GL_FLOAT;
+        }
+
+        // std140 base alignment & size of a block member type
+        void std140(GLenum type, GLint& align, GLint& size) {
+            switch (type) {
+                case GL_FLOAT_VEC2: align = 8; size = 8; break;
+                case GL_FLOAT_VEC3: align = 16; size = 12; break;
+                case GL_FLOAT_VEC4: align = 16; size = 16; break;
+                case GL_FLOAT_MAT3: align = 16; size = 48; break;
+                case GL_FLOAT_MAT4: align = 16; size = 64; break;
+                default: align = 4; size = 4; break;
+            }
+        }
+
+        // Finds the uniforms ("uniform <type> <name>;") & the members of std140 uniform blocks. A real driver would also
+        // drop unused ones, the recorder reports everything declared
+        void reflect(Program& p) {
+            const std::string& src = p.source;
+            auto skipSpace = [&](size_t i) { // And comments
+                for (;;) {
+                    while (i < src.size() && std::isspace(static_cast<unsigned char>(src[i]))) ++i;
+                    if (src.compare(i, 2, "//") == 0) i = std::min(src.find('\n', i), src.size());
+                    else if (src.compare(i, 2, "/*") == 0) i = std::min(src.find("*/", i), src.size() - 2) + 2;
+                    else return i;
+                }
+            };
+            auto ident = [&](size_t& i) {
+                const size_t start = i;
+                while (i < src.size() && isIdent(src[i])) ++i;
+                return src.substr(start, i - start);
+            };
+
+            for (size_t pos = src.find("uniform"); pos != std::string::npos; pos = src.find("uniform", pos + 7)) {
+                if ((pos > 0 && isIdent(src[pos - 1])) || (pos + 7 < src.size() && isIdent(src[pos + 7]))) continue;
+
+                size_t i = skipSpace(pos + 7);
+                if (src.compare(i, 5, "highp") == 0 || src.compare(i, 7, "mediump") == 0 || src.compare(i, 4, "lowp") == 0) {
+                    ident(i);
+                    i = skipSpace(i);
+                }
+                const std::string type = ident(i);
+                i = skipSpace(i);
+                if (i < src.size() && src[i] == '{') {
+                    // A block. Declared in both stages means the same block, so only lay it out once
+                    if (type.empty() || std::find(p.blocks.begin(), p.blocks.end(), type) != p.blocks.end()) continue;
+
+                    const GLint block = static_cast<GLint>(p.blocks.size());
+                    p.blocks.push_back(type);
+
+                    GLint offset = 0;
+                    const size_t end = src.find('}', i);
+                    ++i;
+                    while (end != std::string::npos && (i = skipSpace(i)) < end) {
+                        const std::string memberType = ident(i);
+                        i = skipSpace(i);
+                        const std::string member = ident(i);
+                        if (memberType.empty() || member.empty()) break;
+
+                        GLint count = 1;
+                        i = skipSpace(i);
+                        if (src[i] == '[') count = std::max(1, std::atoi(src.c_str() + i + 1));
+                        i = src.find(';', i);
+                        if (i == std::string::npos || i > end) break;
+                        ++i;
+
+                        const GLenum glType = glslType(memberType);
+                        GLint align = 4, size = 4;
+                        std140(glType, align, size);
+                        if (count > 1) align = size = 16 * ((size + 15) / 16); // Array strides round up to a vec4
+
+                        offset = (offset + align - 1) / align * align;
+                        p.active.push_back({count > 1 ? member + "[0]" : member, glType, count, block, offset});
+                        offset += size * count;
+                    }
+                    p.blockSizes.push_back((offset + 15) / 16 * 16);
+                    continue;
+                }
+
+                const std::string name = ident(i);
+                if (type.empty() || name.empty()) continue;
+
+                GLint size = 1;
+                i = skipSpace(i);
+                if (i < src.size() && src[i] == '[') size = std::atoi(src.c_str() + i + 1);
+
+                bool seen = false;
+                for (const auto& a : p.active) seen |= a.name == name;
+                if (seen) continue; // Declared in both stages
+
+                p.active.push_back({size > 1 || (i < src.size() && src[i] == '[') ? name + "[0]" : name, glslType(type), size > 0 ? size : 1});
+                p.locations.emplace(name, static_cast<GLint>(p.locations.size()));
+            }
+        }
+
+        GLuint& boundBuffer(GLenum target) { return s_state.boundBuffers[target]; }
+
+        // The {count, instances, firstIndex, baseVertex, baseInstance} commands an indirect draw reads from the bound buffer
+        std::string indirectTag(const void* offset, GLsizei drawCount, GLsizei stride) {
+            auto it = s_state.storage.find(boundBuffer(GL_DRAW_INDIRECT_BUFFER));
+            if (it == s_state.storage.end()) return "<no buffer>";
+
+            const size_t step = stride ? static_cast<size_t>(stride) : 5 * sizeof(GLuint);
+            const size_t begin = reinterpret_cast<uintptr_t>(offset);
+            std::string out = "[";
+            for (GLsizei d = 0; d < drawCount; ++d) {
+                const size_t at = begin + d * step;
+                if (at + 5 * sizeof(GLuint) > it->second->size()) return out + "<out of range>]";
+
+                GLuint v[5];
+                std::memcpy(v, it->second->data() + at, sizeof(v));
+                out += fmt::format("{}{{{}, {}, {}, {}, {}}}", d ? ", " : "", v[0], v[1], v[2], static_cast<GLint>(v[3]), v[4]);
+            }
+            return out + "]";
+        }
+
+        // ---- The recorded functions ----
+
+        const GLubyte* GLAD_API_PTR rGetString(GLenum name) {
+            switch (name) {
+                case GL_VENDOR: return reinterpret_cast<const GLubyte*>("Dexium");
+                case GL_RENDERER: return reinterpret_cast<const GLubyte*>("Dexium RecordingGL");
+                case GL_VERSION: return reinterpret_cast<const GLubyte*>(s_state.version.c_str());
+                case GL_SHADING_LANGUAGE_VERSION: return reinterpret_cast<const GLubyte*>("4.60");
+                default: return nullptr;
+            }
+        }
+        // Only the extensions Dexium looks for
+        const char* const s_extensions[] = {"GL_KHR_parallel_shader_compile"};
+        const GLubyte* GLAD_API_PTR rGetStringi(GLenum name, GLuint index) {
+            if (name != GL_EXTENSIONS || index >= std::size(s_extensions)) return nullptr;
+            return reinterpret_cast<const GLubyte*>(s_extensions[index]);
+        }
+        GLenum GLAD_API_PTR rGetError() { return GL_NO_ERROR; }
+
+        void GLAD_API_PTR rGetIntegerv(GLenum pname, GLint* data) {
+            switch (pname) {
+                case GL_NUM_EXTENSIONS: *data = static_cast<GLint>(std::size(s_extensions)); break;
+                case GL_MAJOR_VERSION: *data = s_state.major; break;
+                case GL_MINOR_VERSION: *data = s_state.minor; break;
+                case GL_MAX_TEXTURE_IMAGE_UNITS: *data = 16; break;
+                case GL_MAX_COMBINED_TEXTURE_IMAGE_UNITS: *data = 32; break;
+                case GL_MAX_ARRAY_TEXTURE_LAYERS: *data = 2048; break;
+                case GL_MAX_TEXTURE_SIZE: *data = 16384; break;
+                case GL_NUM_PROGRAM_BINARY_FORMATS: *data = s_state.major * 10 + s_state.minor >= 41 ? 1 : 0; break;
+                default: *data = 0; break;
+            }
+        }
+
+        // Capabilities & fixed state
+        void GLAD_API_PTR rEnable(GLenum cap) { DEXIUM_REC_LOG("glEnable({})", enumName(cap)); }
+        void GLAD_API_PTR rDisable(GLenum cap) { DEXIUM_REC_LOG("glDisable({})", enumName(cap)); }
+        void GLAD_API_PTR rDepthFunc(GLenum func) { DEXIUM_REC_LOG("glDepthFunc({})", enumName(func)); }
+        void GLAD_API_PTR rDepthMask(GLboolean flag) { DEXIUM_REC_LOG("glDepthMask({})", flag ? "GL_TRUE" : "GL_FALSE"); }
+        void GLAD_API_PTR rBlendFunc(GLenum src, GLenum dst) { DEXIUM_REC_LOG("glBlendFunc({}, {})", enumName(src), enumName(dst)); }
+        void GLAD_API_PTR rClearColor(GLfloat r, GLfloat g, GLfloat b, GLfloat a) { DEXIUM_REC_LOG("glClearColor({:g}, {:g}, {:g}, {:g})", r, g, b, a); }
+        void GLAD_API_PTR rClear(GLbitfield mask) { DEXIUM_REC_LOG("glClear(0x{:X})", mask); }
+        void GLAD_API_PTR rViewport(GLint x, GLint y, GLsizei w, GLsizei h) { DEXIUM_REC_LOG("glViewport({}, {}, {}, {})", x, y, w, h); }
+        void GLAD_API_PTR rDrawBuffer(GLenum buf) { DEXIUM_REC_LOG("glDrawBuffer({})", enumName(buf)); }
+        void GLAD_API_PTR rReadBuffer(GLenum buf) { DEXIUM_REC_LOG("glReadBuffer({})", enumName(buf)); }
+
+        // Object creation
+        void gen(const char* fn, GLuint& next, GLsizei n, GLuint* names) {
+            std::string list;
+            for (GLsizei i = 0; i < n; ++i) {
+                names[i] = next++;
+                list += (i ? ", " : "") + std::to_string(names[i]);
+            }
+            DEXIUM_REC_LOG("{}({}) = [{}]", fn, n, list);
+        }
+        void del(const char* fn, GLsizei n, const GLuint* names) {
+            std::string list;
+            for (GLsizei i = 0; i < n; ++i) list += (i ? ", " : "") + std::to_string(names[i]);
+            DEXIUM_REC_LOG("{}([{}])", fn, list);
+        }
+
+        void GLAD_API_PTR rGenBuffers(GLsizei n, GLuint* b) { gen("glGenBuffers", s_state.nextBuffer, n, b); }
+        void GLAD_API_PTR rGenTextures(GLsizei n, GLuint* t) { gen("glGenTextures", s_state.nextTexture, n, t); }
+        void GLAD_API_PTR rGenVertexArrays(GLsizei n, GLuint* v) { gen("glGenVertexArrays", s_state.nextVAO, n, v); }
+        void GLAD_API_PTR rGenFramebuffers(GLsizei n, GLuint* f) { gen("glGenFramebuffers", s_state.nextFBO, n, f); }
+        void GLAD_API_PTR rGenRenderbuffers(GLsizei n, GLuint* r) { gen("glGenRenderbuffers", s_state.nextRBO, n, r); }
+        void GLAD_API_PTR rGenQueries(GLsizei n, GLuint* q) { gen("glGenQueries", s_state.nextQuery, n, q); }
+
+        void GLAD_API_PTR rDeleteBuffers(GLsizei n, const GLuint* b) {
+            for (GLsizei i = 0; i < n; ++i) s_state.storage.erase(b[i]);
+            del("glDeleteBuffers", n, b);
+        }
+        void GLAD_API_PTR rDeleteTextures(GLsizei n, const GLuint* t) { del("glDeleteTextures", n, t); }
+        void GLAD_API_PTR rDeleteVertexArrays(GLsizei n, const GLuint* v) { del("glDeleteVertexArrays", n, v); }
+        void GLAD_API_PTR rDeleteFramebuffers(GLsizei n, const GLuint* f) { del("glDeleteFramebuffers", n, f); }
+        void GLAD_API_PTR rDeleteRenderbuffers(GLsizei n, const GLuint* r) { del("glDeleteRenderbuffers", n, r); }
+        void GLAD_API_PTR rDeleteQueries(GLsizei n, const GLuint* q) { del("glDeleteQueries", n, q); }
+
+        // Binds
+        void bound() { ++rec().counters().binds; }
+        void GLAD_API_PTR rBindBuffer(GLenum target, GLuint buffer) {
+            bound();
+            boundBuffer(target) = buffer;
+            DEXIUM_REC_LOG("glBindBuffer({}, {})", enumName(target), buffer);
+        }
+        void GLAD_API_PTR rBindBufferBase(GLenum target, GLuint index, GLuint buffer) {
+            bound();
+            boundBuffer(target) = buffer;
+            DEXIUM_REC_LOG("glBindBufferBase({}, {}, {})", enumName(target), index, buffer);
+        }
+        void GLAD_API_PTR rBindVertexArray(GLuint vao) { bound(); DEXIUM_REC_LOG("glBindVertexArray({})", vao); }
+        void GLAD_API_PTR rBindTexture(GLenum target, GLuint tex) { bound(); DEXIUM_REC_LOG("glBindTexture({}, {})", enumName(target), tex); }
+        void GLAD_API_PTR rActiveTexture(GLenum unit) { DEXIUM_REC_LOG("glActiveTexture({})", enumName(unit)); }
+        void GLAD_API_PTR rBindFramebuffer(GLenum target, GLuint fbo) { bound(); DEXIUM_REC_LOG("glBindFramebuffer({}, {})", enumName(target), fbo); }
+        void GLAD_API_PTR rBindRenderbuffer(GLenum target, GLuint rbo) { DEXIUM_REC_LOG("glBindRenderbuffer({}, {})", enumName(target), rbo); }
+        void GLAD_API_PTR rUseProgram(GLuint program) { bound(); DEXIUM_REC_LOG("glUseProgram({})", program); }
+
+        // Buffer data
+        void GLAD_API_PTR rBufferData(GLenum target, GLsizeiptr size, const void* data, GLenum usage) {
+            rec().counters().bytesUploaded += data ? static_cast<uint64_t>(size) : 0;
+            // Backing memory so it can be mapped later (reused across orphaning, like a driver would)
+            auto& mem = s_state.storage[boundBuffer(target)];
+            if (!mem) mem = std::make_unique<std::vector<unsigned char>>();
+            mem->resize(static_cast<size_t>(size));
+            if (data) std::memcpy(mem->data(), data, static_cast<size_t>(size));
+            DEXIUM_REC_LOG("glBufferData({}, {}, {})", enumName(target), dataTag(data, static_cast<size_t>(size)), enumName(usage));
+        }
+        void GLAD_API_PTR rBufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const void* data) {
+            rec().counters().bytesUploaded += static_cast<uint64_t>(size);
+            // Kept, so indirect draws can show what they read
+            auto it = s_state.storage.find(boundBuffer(target));
+            if (data && it != s_state.storage.end() && static_cast<size_t>(offset + size) <= it->second->size()) {
+                std::memcpy(it->second->data() + offset, data, static_cast<size_t>(size));
+            }
+            DEXIUM_REC_LOG("glBufferSubData({}, {}, {})", enumName(target), offset, dataTag(data, static_cast<size_t>(size)));
+        }
+        void GLAD_API_PTR rBufferStorage(GLenum target, GLsizeiptr size, const void* data, GLbitfield flags) {
+            auto mem = std::make_unique<std::vector<unsigned char>>(static_cast<size_t>(size));
+            if (data) std::memcpy(mem->data(), data, static_cast<size_t>(size));
+            s_state.storage[boundBuffer(target)] = std::move(mem);
+            DEXIUM_REC_LOG("glBufferStorage({}, {}, 0x{:X})", enumName(target), dataTag(data, static_cast<size_t>(size)), flags);
+        }
+        void* GLAD_API_PTR rMapBufferRange(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access) {
+            DEXIUM_REC_LOG("glMapBufferRange({}, {}, {}, 0x{:X})", enumName(target), offset, length, access);
+
+            auto it = s_state.storage.find(boundBuffer(target));
+            if (it == s_state.storage.end() || static_cast<size_t>(offset + length) > it->second->size()) return nullptr;
+            s_state.mappings[target] = {static_cast<size_t>(offset), static_cast<size_t>(length), (access & GL_MAP_FLUSH_EXPLICIT_BIT) != 0};
+            return it->second->data() + offset;
+        }
+        void GLAD_API_PTR rFlushMappedBufferRange(GLenum target, GLintptr offset, GLsizeiptr length) {
+            rec().counters().bytesUploaded += static_cast<uint64_t>(length);
+            DEXIUM_REC_LOG("glFlushMappedBufferRange({}, {}, {})", enumName(target), offset, length);
+        }
+        GLboolean GLAD_API_PTR rUnmapBuffer(GLenum target) {
+            // Whatever was written through the map counts as uploaded now
+            const auto map = s_state.mappings[target];
+            s_state.mappings.erase(target);
+            if (!map.explicitFlush) rec().counters().bytesUploaded += map.length;
+
+            auto it = s_state.storage.find(boundBuffer(target));
+            const void* data = it != s_state.storage.end() ? it->second->data() + map.offset : nullptr;
+            DEXIUM_REC_LOG("glUnmapBuffer({}) = {}", enumName(target), dataTag(data, map.length));
+            return GL_TRUE;
+        }
+
+        // Vertex arrays
+        void GLAD_API_PTR rVertexAttribPointer(GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride, const void* ptr) {
+            DEXIUM_REC_LOG("glVertexAttribPointer({}, {}, {}, {}, {}, {})", index, size, enumName(type), normalized ? "GL_TRUE" : "GL_FALSE",
+                stride, reinterpret_cast<uintptr_t>(ptr));
+        }
+        void GLAD_API_PTR rEnableVertexAttribArray(GLuint index) { DEXIUM_REC_LOG("glEnableVertexAttribArray({})", index); }
+        void GLAD_API_PTR rVertexAttribDivisor(GLuint index, GLuint divisor) { DEXIUM_REC_LOG("glVertexAttribDivisor({}, {})", index, divisor); }
+
+        // Textures
+        void GLAD_API_PTR rTexParameteri(GLenum target, GLenum pname, GLint param) {
+            DEXIUM_REC_LOG("glTexParameteri({}, {}, {})", enumName(target), enumName(pname), enumName(static_cast<GLenum>(param)));
+        }
+        void GLAD_API_PTR rTexImage2D(GLenum target, GLint level, GLint internal, GLsizei w, GLsizei h, GLint border, GLenum format, GLenum type, const void* data) {
+            const size_t bytes = static_cast<size_t>(w) * h * pixelBytes(format, type);
+            rec().counters().bytesUploaded += data ? bytes : 0;
+            DEXIUM_REC_LOG("glTexImage2D({}, {}, {}, {}, {}, {}, {}, {}, {})", enumName(target), level, enumName(static_cast<GLenum>(internal)),
+                w, h, border, enumName(format), enumName(type), dataTag(data, bytes));
+        }
+        void GLAD_API_PTR rTexImage3D(GLenum target, GLint level, GLint internal, GLsizei w, GLsizei h, GLsizei d, GLint border, GLenum format, GLenum type, const void* data) {
+            const size_t bytes = static_cast<size_t>(w) * h * d * pixelBytes(format, type);
+            rec().counters().bytesUploaded += data ? bytes : 0;
+            DEXIUM_REC_LOG("glTexImage3D({}, {}, {}, {}, {}, {}, {}, {}, {}, {})", enumName(target), level, enumName(static_cast<GLenum>(internal)),
+                w, h, d, border, enumName(format), enumName(type), dataTag(data, bytes));
+        }
+        void GLAD_API_PTR rTexSubImage2D(GLenum target, GLint level, GLint x, GLint y, GLsizei w, GLsizei h, GLenum format, GLenum type, const void* data) {
+            const size_t bytes = static_cast<size_t>(w) * h * pixelBytes(format, type);
+            rec().counters().bytesUploaded += bytes;
+            DEXIUM_REC_LOG("glTexSubImage2D({}, {}, {}, {}, {}, {}, {}, {}, {})", enumName(target), level, x, y, w, h,
+                enumName(format), enumName(type), dataTag(data, bytes));
+        }
+        void GLAD_API_PTR rTexSubImage3D(GLenum target, GLint level, GLint x, GLint y, GLint z, GLsizei w, GLsizei h, GLsizei d, GLenum format, GLenum type, const void* data) {
+            const size_t bytes = static_cast<size_t>(w) * h * d * pixelBytes(format, type);
+            rec().counters().bytesUploaded += bytes;
+            DEXIUM_REC_LOG("glTexSubImage3D({}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {})", enumName(target), level, x, y, z, w, h, d,
+                enumName(format), enumName(type), dataTag(data, bytes));
+        }
+        void GLAD_API_PTR rGenerateMipmap(GLenum target) { DEXIUM_REC_LOG("glGenerateMipmap({})", enumName(target)); }
+
+        // Framebuffers
+        void GLAD_API_PTR rRenderbufferStorage(GLenum target, GLenum format, GLsizei w, GLsizei h) {
+            DEXIUM_REC_LOG("glRenderbufferStorage({}, {}, {}, {})", enumName(target), enumName(format), w, h);
+        }
+        void GLAD_API_PTR rFramebufferTexture2D(GLenum target, GLenum attachment, GLenum texTarget, GLuint tex, GLint level) {
+            DEXIUM_REC_LOG("glFramebufferTexture2D({}, {}, {}, {}, {})", enumName(target), enumName(attachment), enumName(texTarget), tex, level);
+        }
+        void GLAD_API_PTR rFramebufferRenderbuffer(GLenum target, GLenum attachment, GLenum rbTarget, GLuint rbo) {
+            DEXIUM_REC_LOG("glFramebufferRenderbuffer({}, {}, {}, {})", enumName(target), enumName(attachment), enumName(rbTarget), rbo);
+        }
+        GLenum GLAD_API_PTR rCheckFramebufferStatus(GLenum) { return GL_FRAMEBUFFER_COMPLETE; }
+
+        // Shaders (always compile, uniforms & blocks are "found" by scanning the source)
+        GLuint GLAD_API_PTR rCreateShader(GLenum type) {
+            const GLuint id = s_state.nextShader++;
+            s_state.shaderSources[id].clear();
+            DEXIUM_REC_LOG("glCreateShader({}) = {}", enumName(type), id);
+            return id;
+        }
+        void GLAD_API_PTR rShaderSource(GLuint shader, GLsizei count, const GLchar* const* strings, const GLint* lengths) {
+            std::string src;
+            for (GLsizei i = 0; i < count; ++i) {
+                if (lengths && lengths[i] >= 0) src.append(strings[i], static_cast<size_t>(lengths[i]));
+                else src.append(strings[i]);
+            }
+            DEXIUM_REC_LOG("glShaderSource({}, {})", shader, dataTag(src.data(), src.size()));
+            s_state.shaderSources[shader] = std::move(src);
+        }
+        void GLAD_API_PTR rCompileShader(GLuint shader) { DEXIUM_REC_LOG("glCompileShader({})", shader); }
+        void GLAD_API_PTR rGetShaderiv(GLuint, GLenum pname, GLint* params) { *params = pname == GL_COMPILE_STATUS ? GL_TRUE : 0; }
+        void GLAD_API_PTR rGetShaderInfoLog(GLuint, GLsizei bufSize, GLsizei* length, GLchar* infoLog) {
+            if (length) *length = 0;
+            if (infoLog && bufSize > 0) infoLog[0] = '\0';
+        }
+        void GLAD_API_PTR rDeleteShader(GLuint shader) {
+            s_state.shaderSources.erase(shader);
+            DEXIUM_REC_LOG("glDeleteShader({})", shader);
+        }
+
+        GLuint GLAD_API_PTR rCreateProgram() {
+            const GLuint id = s_state.nextShader++;
+            s_state.programs[id] = {};
+            DEXIUM_REC_LOG("glCreateProgram() = {}", id);
+            return id;
+        }
+        void GLAD_API_PTR rAttachShader(GLuint program, GLuint shader) {
+            s_state.programs[program].shaders.push_back(shader);
+            DEXIUM_REC_LOG("glAttachShader({}, {})", program, shader);
+        }
+        void GLAD_API_PTR rDetachShader(GLuint program, GLuint shader) { DEXIUM_REC_LOG("glDetachShader({}, {})", program, shader); }
+        void GLAD_API_PTR rLinkProgram(GLuint program) {
+            auto& p = s_state.programs[program];
+            p.source.clear();
+            for (GLuint s : p.shaders) p.source += s_state.shaderSources[s] + "\n";
+            p.locations.clear();
+            p.blocks.clear();
+            p.blockSizes.clear();
+            p.active.clear();
+            p.linked = true;
+            p.completionPolls = 0;
+            reflect(p);
+            DEXIUM_REC_LOG("glLinkProgram({})", program);
+        }
+        void GLAD_API_PTR rProgramParameteri(GLuint program, GLenum pname, GLint value) {
+            DEXIUM_REC_LOG("glProgramParameteri({}, {}, {})", program, enumName(pname), value);
+        }
+
+        // The "binary" is just the linked source, so a cache round trip reflects the same program
+        constexpr GLenum BinaryFormat = 0xDE51;
+        void GLAD_API_PTR rGetProgramBinary(GLuint program, GLsizei bufSize, GLsizei* length, GLenum* format, void* binary) {
+            const auto& p = s_state.programs[program];
+            const GLsizei n = std::min(bufSize, static_cast<GLsizei>(p.source.size()));
+            std::memcpy(binary, p.source.data(), static_cast<size_t>(n));
+            if (length) *length = n;
+            *format = BinaryFormat;
+            DEXIUM_REC_LOG("glGetProgramBinary({}, {}) = {}", program, bufSize, dataTag(binary, static_cast<size_t>(n)));
+        }
+        void GLAD_API_PTR rProgramBinary(GLuint program, GLenum format, const void* binary, GLsizei length) {
+            auto& p = s_state.programs[program];
+            p.source.assign(static_cast<const char*>(binary), static_cast<size_t>(length));
+            p.locations.clear();
+            p.blocks.clear();
+            p.blockSizes.clear();
+            p.active.clear();
+            p.linked = format == BinaryFormat;
+            if (p.linked) reflect(p);
+            DEXIUM_REC_LOG("glProgramBinary({}, 0x{:X}, {})", program, format, dataTag(binary, static_cast<size_t>(length)));
+        }
+        void GLAD_API_PTR rGetProgramiv(GLuint program, GLenum pname, GLint* params) {
+            auto& p = s_state.programs[program];
+            switch (pname) {
+                case GL_LINK_STATUS: *params = p.linked ? GL_TRUE : GL_FALSE; break;
+                case GL_PROGRAM_BINARY_LENGTH: *params = static_cast<GLint>(p.source.size()); break;
+                case 0x91B1: *params = p.completionPolls++ > 0 ? GL_TRUE : GL_FALSE; break; // GL_COMPLETION_STATUS_KHR
+                case GL_ACTIVE_UNIFORMS: *params = static_cast<GLint>(p.active.size()); break;
+                case GL_ACTIVE_UNIFORM_MAX_LENGTH: {
+                    size_t longest = 0;
+                    for (const auto& a : p.active) longest = std::max(longest, a.name.size() + 1);
+                    *params = static_cast<GLint>(longest);
+                    break;
+                }
+                default: *params = 0; break;
+            }
+        }
+        void GLAD_API_PTR rGetActiveUniform(GLuint program, GLuint index, GLsizei bufSize, GLsizei* length, GLint* size, GLenum* type, GLchar* name) {
+            const auto& p = s_state.programs[program];
+            if (index >= p.active.size()) return;
+
+            const auto& a = p.active[index];
+            const size_t n = bufSize > 0 ? std::min(a.name.size(), static_cast<size_t>(bufSize - 1)) : 0;
+            if (bufSize > 0) {
+                std::memcpy(name, a.name.data(), n);
+                name[n] = '\0';
+            }
+            if (length) *length = static_cast<GLsizei>(n);
+            *size = a.size;
+            *type = a.type;
+        }
+        void GLAD_API_PTR rGetActiveUniformsiv(GLuint program, GLsizei count, const GLuint* indices, GLenum pname, GLint* params) {
+            const auto& p = s_state.programs[program];
+            for (GLsizei i = 0; i < count; ++i) {
+                const bool known = indices[i] < p.active.size();
+                switch (pname) {
+                    case GL_UNIFORM_BLOCK_INDEX: params[i] = known ? p.active[indices[i]].block : -1; break;
+                    case GL_UNIFORM_OFFSET: params[i] = known ? p.active[indices[i]].offset : -1; break;
+                    case GL_UNIFORM_TYPE: params[i] = known ? static_cast<GLint>(p.active[indices[i]].type) : 0; break;
+                    case GL_UNIFORM_SIZE: params[i] = known ? p.active[indices[i]].size : 0; break;
+                    default: params[i] = 0; break;
+                }
+            }
+        }
+        void GLAD_API_PTR rGetActiveUniformBlockiv(GLuint program, GLuint index, GLenum pname, GLint* params) {
+            const auto& p = s_state.programs[program];
+            *params = 0;
+            if (index >= p.blocks.size()) return;
+            if (pname == GL_UNIFORM_BLOCK_DATA_SIZE) *params = p.blockSizes[index];
+        }
+        void GLAD_API_PTR rGetProgramInfoLog(GLuint, GLsizei bufSize, GLsizei* length, GLchar* infoLog) {
+            if (length) *length = 0;
+            if (infoLog && bufSize > 0) infoLog[0] = '\0';
+        }
+        void GLAD_API_PTR rDeleteProgram(GLuint program) {
+            s_state.programs.erase(program);
+            DEXIUM_REC_LOG("glDeleteProgram({})", program);
+        }
+
+        GLint GLAD_API_PTR rGetUniformLocation(GLuint program, const GLchar* name) {
+            auto& p = s_state.programs[program];
+
+            GLint location = -1;
+            auto it = p.locations.find(name);
+            if (it != p.locations.end()) {
+                location = it->second;
+            } else {
+                // Arrays & struct members are looked up by their base name
+                std::string base(name);
+                base = base.substr(0, base.find_first_of("[."));
+
+                bool blockMember = false; // Those live in their buffer, no location
+                for (const auto& a : p.active) blockMember |= a.block >= 0 && a.name.compare(0, base.size(), base) == 0 &&
+                                                              (a.name.size() == base.size() || a.name[base.size()] == '[');
+                if (!blockMember && declares(p.source, base, false)) {
+                    location = static_cast<GLint>(p.locations.size());
+                    p.locations.emplace(name, location);
+                }
+            }
+
+            DEXIUM_REC_LOG("glGetUniformLocation({}, \"{}\") = {}", program, name, location);
+            return location;
+        }
+        GLuint GLAD_API_PTR rGetUniformBlockIndex(GLuint program, const GLchar* name) {
+            auto& p = s_state.programs[program];
+
+            GLuint index = GL_INVALID_INDEX;
+            for (size_t i = 0; i < p.blocks.size(); ++i) {
+                if (p.blocks[i] == name) index = static_cast<GLuint>(i);
+            }
+            if (index == GL_INVALID_INDEX && declares(p.source, name, true)) {
+                index = static_cast<GLuint>(p.blocks.size());
+                p.blocks.emplace_back(name);
+                p.blockSizes.push_back(0);
+            }
+
+            DEXIUM_REC_LOG("glGetUniformBlockIndex({}, \"{}\") = {}", program, name, static_cast<GLint>(index));
+            return index;
+        }
+        void GLAD_API_PTR rUniformBlockBinding(GLuint program, GLuint index, GLuint binding) {
+            DEXIUM_REC_LOG("glUniformBlockBinding({}, {}, {})", program, index, binding);
+        }
+
+        // Uniforms
+        void uploaded() { ++rec().counters().uniformUploads; }
+        void GLAD_API_PTR rUniform1i(GLint loc, GLint v) { uploaded(); DEXIUM_REC_LOG("glUniform1i({}, {})", loc, v); }
+        void GLAD_API_PTR rUniform1f(GLint loc, GLfloat v) { uploaded(); DEXIUM_REC_LOG("glUniform1f({}, {:g})", loc, v); }
+        void GLAD_API_PTR rUniform2fv(GLint loc, GLsizei n, const GLfloat* v) { uploaded(); DEXIUM_REC_LOG("glUniform2fv({}, {}, [{}])", loc, n, floats(v, 2 * n)); }
+        void GLAD_API_PTR rUniform3fv(GLint loc, GLsizei n, const GLfloat* v) { uploaded(); DEXIUM_REC_LOG("glUniform3fv({}, {}, [{}])", loc, n, floats(v, 3 * n)); }
+        void GLAD_API_PTR rUniform4fv(GLint loc, GLsizei n, const GLfloat* v) { uploaded(); DEXIUM_REC_LOG("glUniform4fv({}, {}, [{}])", loc, n, floats(v, 4 * n)); }
+        void GLAD_API_PTR rUniformMatrix4fv(GLint loc, GLsizei n, GLboolean transpose, const GLfloat* v) {
+            uploaded();
+            DEXIUM_REC_LOG("glUniformMatrix4fv({}, {}, {}, [{}])", loc, n, transpose ? "GL_TRUE" : "GL_FALSE", floats(v, 16 * n));
+        }
+
+        // Draws
+        void drew() { ++rec().counters().drawCalls; }
+        void GLAD_API_PTR rDrawArrays(GLenum mode, GLint first, GLsizei count) { drew(); DEXIUM_REC_LOG("glDrawArrays({}, {}, {})", enumName(mode), first, count); }
+        void GLAD_API_PTR rDrawArraysInstanced(GLenum mode, GLint first, GLsizei count, GLsizei instances) {
+            drew();
+            DEXIUM_REC_LOG("glDrawArraysInstanced({}, {}, {}, {})", enumName(mode), first, count, instances);
+        }
+        void GLAD_API_PTR rDrawElements(GLenum mode, GLsizei count, GLenum type, const void* indices) {
+            drew();
+            DEXIUM_REC_LOG("glDrawElements({}, {}, {}, {})", enumName(mode), count, enumName(type), reinterpret_cast<uintptr_t>(indices));
+        }
+        void GLAD_API_PTR rDrawElementsInstanced(GLenum mode, GLsizei count, GLenum type, const void* indices, GLsizei instances) {
+            drew();
+            DEXIUM_REC_LOG("glDrawElementsInstanced({}, {}, {}, {}, {})", enumName(mode), count, enumName(type), reinterpret_cast<uintptr_t>(indices), instances);
+        }
+        void GLAD_API_PTR rDrawElementsBaseVertex(GLenum mode, GLsizei count, GLenum type, const void* indices, GLint baseVertex) {
+            drew();
+            DEXIUM_REC_LOG("glDrawElementsBaseVertex({}, {}, {}, {}, {})", enumName(mode), count, enumName(type), reinterpret_cast<uintptr_t>(indices), baseVertex);
+        }
+
+        void GLAD_API_PTR rDrawElementsInstancedBaseVertex(GLenum mode, GLsizei count, GLenum type, const void* indices, GLsizei instances, GLint baseVertex) {
+            drew();
+            DEXIUM_REC_LOG("glDrawElementsInstancedBaseVertex({}, {}, {}, {}, {}, {})", enumName(mode), count, enumName(type),
+                reinterpret_cast<uintptr_t>(indices), instances, baseVertex);
+        }
+
+        void GLAD_API_PTR rDrawElementsInstancedBaseVertexBaseInstance(GLenum mode, GLsizei count, GLenum type, const void* indices,
+                                                                      GLsizei instances, GLint baseVertex, GLuint baseInstance) {
+            drew();
+            DEXIUM_REC_LOG("glDrawElementsInstancedBaseVertexBaseInstance({}, {}, {}, {}, {}, {}, {})", enumName(mode), count, enumName(type),
+                reinterpret_cast<uintptr_t>(indices), instances, baseVertex, baseInstance);
+        }
+        void GLAD_API_PTR rMultiDrawElementsIndirect(GLenum mode, GLenum type, const void* indirect, GLsizei drawCount, GLsizei stride) {
+            drew(); // One submission, however many draws it holds
+            DEXIUM_REC_LOG("glMultiDrawElementsIndirect({}, {}, {}, {}, {}) = {}", enumName(mode), enumName(type),
+                reinterpret_cast<uintptr_t>(indirect), drawCount, stride, indirectTag(indirect, drawCount, stride));
+        }
+
+        // Sync & queries (everything finishes instantly)
+        GLsync GLAD_API_PTR rFenceSync(GLenum, GLbitfield) {
+            const uintptr_t id = s_state.nextSync++;
+            DEXIUM_REC_LOG("glFenceSync() = sync#{}", id);
+            return reinterpret_cast<GLsync>(id);
+        }
+        GLenum GLAD_API_PTR rClientWaitSync(GLsync sync, GLbitfield, GLuint64) {
+            DEXIUM_REC_LOG("glClientWaitSync(sync#{})", reinterpret_cast<uintptr_t>(sync));
+            return GL_ALREADY_SIGNALED;
+        }
+        void GLAD_API_PTR rDeleteSync(GLsync sync) { DEXIUM_REC_LOG("glDeleteSync(sync#{})", reinterpret_cast<uintptr_t>(sync)); }
+
+        void GLAD_API_PTR rBeginQuery(GLenum target, GLuint id) { DEXIUM_REC_LOG("glBeginQuery({}, {})", enumName(target), id); }
+        void GLAD_API_PTR rEndQuery(GLenum target) { DEXIUM_REC_LOG("glEndQuery({})", enumName(target)); }
+        void GLAD_API_PTR rQueryCounter(GLuint id, GLenum target) { DEXIUM_REC_LOG("glQueryCounter({}, {})", id, enumName(target)); }
+        void GLAD_API_PTR rGetQueryObjectiv(GLuint, GLenum pname, GLint* params) { *params = pname == GL_QUERY_RESULT_AVAILABLE ? GL_TRUE : 0; }
+        void GLAD_API_PTR rGetQueryObjectui64v(GLuint, GLenum, GLuint64* params) { *params = 0; }
+
+        struct Entry {
+            const char* name;
+            GLADapiproc proc;
+        };
+
+        #define DEXIUM_REC(glName, fn) {glName, reinterpret_cast<GLADapiproc>(&fn)}
+        const Entry s_entries[] = {
+            DEXIUM_REC("glGetString", rGetString),
+            DEXIUM_REC("glGetStringi", rGetStringi),
+            DEXIUM_REC("glGetError", rGetError),
+            DEXIUM_REC("glGetIntegerv", rGetIntegerv),
+            DEXIUM_REC("glEnable", rEnable),
+            DEXIUM_REC("glDisable", rDisable),
+            DEXIUM_REC("glDepthFunc", rDepthFunc),
+            DEXIUM_REC("glDepthMask", rDepthMask),
+            DEXIUM_REC("glBlendFunc", rBlendFunc),
+            DEXIUM_REC("glClearColor", rClearColor),
+            DEXIUM_REC("glClear", rClear),
+            DEXIUM_REC("glViewport", rViewport),
+            DEXIUM_REC("glDrawBuffer", rDrawBuffer),
+            DEXIUM_REC("glReadBuffer", rReadBuffer),
+            DEXIUM_REC("glGenBuffers", rGenBuffers),
+            DEXIUM_REC("glGenTextures", rGenTextures),
+            DEXIUM_REC("glGenVertexArrays", rGenVertexArrays),
+            DEXIUM_REC("glGenFramebuffers", rGenFramebuffers),
+            DEXIUM_REC("glGenRenderbuffers", rGenRenderbuffers),
+            DEXIUM_REC("glGenQueries", rGenQueries),
+            DEXIUM_REC("glDeleteBuffers", rDeleteBuffers),
+            DEXIUM_REC("glDeleteTextures", rDeleteTextures),
+            DEXIUM_REC("glDeleteVertexArrays", rDeleteVertexArrays),
+            DEXIUM_REC("glDeleteFramebuffers", rDeleteFramebuffers),
+            DEXIUM_REC("glDeleteRenderbuffers", rDeleteRenderbuffers),
+            DEXIUM_REC("glDeleteQueries", rDeleteQueries),
+            DEXIUM_REC("glBindBuffer", rBindBuffer),
+            DEXIUM_REC("glBindBufferBase", rBindBufferBase),
+            DEXIUM_REC("glBindVertexArray", rBindVertexArray),
+            DEXIUM_REC("glBindTexture", rBindTexture),
+            DEXIUM_REC("glActiveTexture", rActiveTexture),
+            DEXIUM_REC("glBindFramebuffer", rBindFramebuffer),
+            DEXIUM_REC("glBindRenderbuffer", rBindRenderbuffer),
+            DEXIUM_REC("glUseProgram", rUseProgram),
+            DEXIUM_REC("glBufferData", rBufferData),
+            DEXIUM_REC("glBufferSubData", rBufferSubData),
+            DEXIUM_REC("glBufferStorage", rBufferStorage),
+            DEXIUM_REC("glMapBufferRange", rMapBufferRange),
+            DEXIUM_REC("glFlushMappedBufferRange", rFlushMappedBufferRange),
+            DEXIUM_REC("glUnmapBuffer", rUnmapBuffer),
+            DEXIUM_REC("glVertexAttribPointer", rVertexAttribPointer),
+            DEXIUM_REC("glEnableVertexAttribArray", rEnableVertexAttribArray),
+            DEXIUM_REC("glVertexAttribDivisor", rVertexAttribDivisor),
+            DEXIUM_REC("glTexParameteri", rTexParameteri),
+            DEXIUM_REC("glTexImage2D", rTexImage2D),
+            DEXIUM_REC("glTexImage3D", rTexImage3D),
+            DEXIUM_REC("glTexSubImage2D", rTexSubImage2D),
+            DEXIUM_REC("glTexSubImage3D", rTexSubImage3D),
+            DEXIUM_REC("glGenerateMipmap", rGenerateMipmap),
+            DEXIUM_REC("glRenderbufferStorage", rRenderbufferStorage),
+            DEXIUM_REC("glFramebufferTexture2D", rFramebufferTexture2D),
+            DEXIUM_REC("glFramebufferRenderbuffer", rFramebufferRenderbuffer),
+            DEXIUM_REC("glCheckFramebufferStatus", rCheckFramebufferStatus),
+            DEXIUM_REC("glCreateShader", rCreateShader),
+            DEXIUM_REC("glShaderSource", rShaderSource),
+            DEXIUM_REC("glCompileShader", rCompileShader),
+            DEXIUM_REC("glGetShaderiv", rGetShaderiv),
+            DEXIUM_REC("glGetShaderInfoLog", rGetShaderInfoLog),
+            DEXIUM_REC("glDeleteShader", rDeleteShader),
+            DEXIUM_REC("glCreateProgram", rCreateProgram),
+            DEXIUM_REC("glAttachShader", rAttachShader),
+            DEXIUM_REC("glDetachShader", rDetachShader),
+            DEXIUM_REC("glLinkProgram", rLinkProgram),
+            DEXIUM_REC("glProgramParameteri", rProgramParameteri),
+            DEXIUM_REC("glGetProgramBinary", rGetProgramBinary),
+            DEXIUM_REC("glProgramBinary", rProgramBinary),
+            DEXIUM_REC("glGetProgramiv", rGetProgramiv),
+            DEXIUM_REC("glGetProgramInfoLog", rGetProgramInfoLog),
+            DEXIUM_REC("glDeleteProgram", rDeleteProgram),
+            DEXIUM_REC("glGetActiveUniform", rGetActiveUniform),
+            DEXIUM_REC("glGetActiveUniformsiv", rGetActiveUniformsiv),
+            DEXIUM_REC("glGetActiveUniformBlockiv", rGetActiveUniformBlockiv),
+            DEXIUM_REC("glGetUniformLocation", rGetUniformLocation),
+            DEXIUM_REC("glGetUniformBlockIndex", rGetUniformBlockIndex),
+            DEXIUM_REC("glUniformBlockBinding", rUniformBlockBinding),
+            DEXIUM_REC("glUniform1i", rUniform1i),
+            DEXIUM_REC("glUniform1f", rUniform1f),
+            DEXIUM_REC("glUniform2fv", rUniform2fv),
+            DEXIUM_REC("glUniform3fv", rUniform3fv),
+            DEXIUM_REC("glUniform4fv", rUniform4fv),
+            DEXIUM_REC("glUniformMatrix4fv", rUniformMatrix4fv),
+            DEXIUM_REC("glDrawArrays", rDrawArrays),
+            DEXIUM_REC("glDrawArraysInstanced", rDrawArraysInstanced),
+            DEXIUM_REC("glDrawElements", rDrawElements),
+            DEXIUM_REC("glDrawElementsInstanced", rDrawElementsInstanced),
+            DEXIUM_REC("glDrawElementsBaseVertex", rDrawElementsBaseVertex),
+            DEXIUM_REC("glDrawElementsInstancedBaseVertex", rDrawElementsInstancedBaseVertex),
+            DEXIUM_REC("glDrawElementsInstancedBaseVertexBaseInstance", rDrawElementsInstancedBaseVertexBaseInstance),
+            DEXIUM_REC("glMultiDrawElementsIndirect", rMultiDrawElementsIndirect),
+            DEXIUM_REC("glFenceSync", rFenceSync),
+            DEXIUM_REC("glClientWaitSync", rClientWaitSync),
+            DEXIUM_REC("glDeleteSync", rDeleteSync),
+            DEXIUM_REC("glBeginQuery", rBeginQuery),
+            DEXIUM_REC("glEndQuery", rEndQuery),
+            DEXIUM_REC("glQueryCounter", rQueryCounter),
+            DEXIUM_REC("glGetQueryObjectiv", rGetQueryObjectiv),
+            DEXIUM_REC("glGetQueryObjectui64v", rGetQueryObjectui64v),
+        };
+        #undef DEXIUM_REC
+        #undef DEXIUM_REC_LOG
+
+        GLADapiproc lookup(const char* name) {
+            for (const auto& e : s_entries) {
+                if (std::strcmp(e.name, name) == 0) return e.proc;
+            }
+            return nullptr; // Not used by Dexium, left null
+        }
+    }
+
+    RecordingGL& RecordingGL::get() {
+        static RecordingGL recorder;
+        return recorder;
+    }
+
+    bool RecordingGL::install(int major, int minor) {
+        s_state = State{};
+        s_state.major = major;
+        s_state.minor = minor;
+        s_state.version = fmt::format("{}.{}.0 Dexium RecordingGL", major, minor);
+
+        if (!gladLoadGL(&lookup)) {
+            TraceLog(LogLevel::ERROR, "[RecordingGL]: glad failed to load the recording backend");
+            m_installed = false;
+            return false;
+        }
+
+        // Whatever the cache knew was about the old context
+        GLStateCache::get().invalidate();
+
+        clear();
+        m_installed = true;
+        TraceLog(LogLevel::STATUS, "[RecordingGL]: Recording GL {}.{} calls (no GPU)", major, minor);
+        return true;
+    }
+
+    void RecordingGL::clear() {
+        m_calls.clear();
+        m_stats = {};
+    }
+
+    void RecordingGL::record(std::string call) {
+        m_calls.push_back(std::move(call));
+    }
+
+    bool RecordingGL::dump(const std::filesystem::path& path) const {
+        std::ofstream file(path);
+        if (!file) {
+            TraceLog(LogLevel::ERROR, "[RecordingGL]: Failed to open '{}' for writing", path.string());
+            return false;
+        }
+
+        for (const auto& call : m_calls) file << call << '\n';
+        return true;
+    }
+}
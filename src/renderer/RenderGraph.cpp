@@ -0,0 +1,308 @@
+//
+// Created by Dextron12 on 17/10/26.
+//
+
+#include <renderer/RenderGraph.hpp>
+#include <renderer/RenderPass.hpp>
+#include <renderer/Renderer.hpp>
+
+#include <core/Error.hpp>
+
+#include <algorithm>
+
+namespace Dexium::Renderer {
+
+    RenderGraph::Resource RenderGraph::importTarget(RenderTarget* target, std::string_view name, bool isOutput) {
+        if (target == nullptr) {
+            TraceLog(LogLevel::ERROR, "[RenderGraph]: Cannot import a null RenderTarget ('{}')", name);
+            return InvalidResource;
+        }
+
+        ResourceNode node;
+        node.name = std::string(name);
+        node.imported = target;
+        node.isOutput = isOutput;
+        m_resources.push_back(std::move(node));
+        return static_cast<Resource>(m_resources.size() - 1);
+    }
+
+    RenderGraph::Resource RenderGraph::createTarget(const TargetDesc& desc, std::string_view name) {
+        ResourceNode node;
+        node.name = std::string(name);
+        node.desc = desc;
+        m_resources.push_back(std::move(node));
+        return static_cast<Resource>(m_resources.size() - 1);
+    }
+
+    void RenderGraph::markOutput(Resource resource) {
+        if (!validResource(resource)) return;
+        m_resources[resource].isOutput = true;
+    }
+
+    void RenderGraph::addPass(RenderPass* pass, Resource output, std::initializer_list<Resource> inputs) {
+        addPass(pass, output, std::vector<Resource>(inputs));
+    }
+
+    void RenderGraph::addPass(RenderPass* pass, Resource output, const std::vector<Resource>& inputs) {
+        if (pass == nullptr) {
+            TraceLog(LogLevel::ERROR, "[RenderGraph]: Cannot add a null RenderPass");
+            return;
+        }
+        if (!validResource(output)) {
+            TraceLog(LogLevel::ERROR, "[RenderGraph]: Pass '{}' has no valid output target", pass->passName);
+            return;
+        }
+
+        PassNode node;
+        node.pass = pass;
+        node.output = output;
+        for (Resource in : inputs) {
+            if (validResource(in)) node.inputs.push_back(in);
+        }
+        m_passes.push_back(std::move(node));
+    }
+
+    bool RenderGraph::validResource(Resource resource) const {
+        if (resource >= m_resources.size()) {
+            TraceLog(LogLevel::WARNING, "[RenderGraph]: Resource({}) doesn't exist in this graph", resource);
+            return false;
+        }
+        return true;
+    }
+
+    void RenderGraph::compile() {
+        m_stats = {};
+        m_stats.passesDeclared = m_passes.size();
+
+        buildDependencies();
+        cull();
+        order();
+        allocate();
+    }
+
+    void RenderGraph::buildDependencies() {
+        // Edges only ever point at earlier declared passes, so the graph can't cycle
+        for (uint32_t j = 0; j < m_passes.size(); ++j) {
+            auto& later = m_passes[j];
+            later.dependsOn.clear();
+            later.after.clear();
+
+            for (uint32_t i = 0; i < j; ++i) {
+                const auto& earlier = m_passes[i];
+
+                const bool readsIt = std::find(later.inputs.begin(), later.inputs.end(), earlier.output) != later.inputs.end();
+                const bool drawsOverIt = earlier.output == later.output;
+                const bool overwritesItsInput = std::find(earlier.inputs.begin(), earlier.inputs.end(), later.output) != earlier.inputs.end();
+
+                if (readsIt || drawsOverIt) later.dependsOn.push_back(i);
+                else if (overwritesItsInput) later.after.push_back(i);
+            }
+        }
+    }
+
+    void RenderGraph::cull() {
+        std::vector<uint32_t> stack;
+        for (uint32_t i = 0; i < m_passes.size(); ++i) {
+            m_passes[i].alive = m_resources[m_passes[i].output].isOutput;
+            if (m_passes[i].alive) stack.push_back(i);
+        }
+
+        // Everything a live pass depends on is live too
+        while (!stack.empty()) {
+            uint32_t idx = stack.back();
+            stack.pop_back();
+            for (uint32_t dep : m_passes[idx].dependsOn) {
+                if (!m_passes[dep].alive) {
+                    m_passes[dep].alive = true;
+                    stack.push_back(dep);
+                }
+            }
+        }
+
+        for (const auto& node : m_passes) {
+            if (!node.alive) ++m_stats.passesCulled;
+        }
+    }
+
+    void RenderGraph::order() {
+        m_schedule.clear();
+        m_scheduleNodes.clear();
+
+        const auto count = static_cast<uint32_t>(m_passes.size());
+
+        // Kahn's, but among the ready passes pick one drawing into the current target first (then declaration order)
+        std::vector<uint32_t> pending(count, 0);
+        std::vector<std::vector<uint32_t>> dependents(count);
+        for (uint32_t j = 0; j < count; ++j) {
+            if (!m_passes[j].alive) continue;
+            for (const auto* edges : {&m_passes[j].dependsOn, &m_passes[j].after}) {
+                for (uint32_t i : *edges) {
+                    if (!m_passes[i].alive) continue;
+                    ++pending[j];
+                    dependents[i].push_back(j);
+                }
+            }
+        }
+
+        std::vector<uint32_t> ready;
+        for (uint32_t j = 0; j < count; ++j) {
+            if (m_passes[j].alive && pending[j] == 0) ready.push_back(j);
+        }
+
+        // Unscheduled writers per target, so we can tell when switching to a target would have to come back to it later
+        std::vector<uint32_t> writersLeft(m_resources.size(), 0);
+        for (uint32_t j = 0; j < count; ++j) {
+            if (m_passes[j].alive) ++writersLeft[m_passes[j].output];
+        }
+        std::vector<uint32_t> readyWriters(m_resources.size(), 0);
+        for (uint32_t idx : ready) ++readyWriters[m_passes[idx].output];
+
+        Resource current = InvalidResource;
+        while (!ready.empty()) {
+            // ready is kept in declaration order. Stay on the current target if we can, otherwise prefer a target
+            // we can finish now (no writer still waiting on something), so it isn't revisited later
+            auto pick = std::find_if(ready.begin(), ready.end(), [&](uint32_t idx) {
+                return m_passes[idx].output == current;
+            });
+            if (pick == ready.end()) {
+                pick = std::find_if(ready.begin(), ready.end(), [&](uint32_t idx) {
+                    const Resource out = m_passes[idx].output;
+                    return writersLeft[out] == readyWriters[out];
+                });
+            }
+            if (pick == ready.end()) pick = ready.begin();
+
+            const uint32_t idx = *pick;
+            ready.erase(pick);
+            --writersLeft[m_passes[idx].output];
+            --readyWriters[m_passes[idx].output];
+
+            m_scheduleNodes.push_back(idx);
+            m_schedule.push_back(m_passes[idx].pass);
+            current = m_passes[idx].output;
+
+            for (uint32_t dep : dependents[idx]) {
+                if (--pending[dep] == 0) {
+                    ready.insert(std::lower_bound(ready.begin(), ready.end(), dep), dep);
+                    ++readyWriters[m_passes[dep].output];
+                }
+            }
+        }
+    }
+
+    void RenderGraph::allocate() {
+        for (auto& res : m_resources) res.physical = res.imported;
+
+        for (auto& pooled : m_pool) {
+            pooled.busyUntil = 0;
+            pooled.usedThisFrame = false;
+        }
+
+        // Lifetime (first & last schedule slot) of every transient a live pass touches
+        struct Lifetime {
+            Resource resource;
+            size_t first, last;
+        };
+        std::vector<Lifetime> lifetimes;
+        std::vector<int64_t> lifetimeOf(m_resources.size(), -1);
+
+        auto touch = [&](Resource r, size_t slot) {
+            if (m_resources[r].imported) return;
+            if (lifetimeOf[r] < 0) {
+                lifetimeOf[r] = static_cast<int64_t>(lifetimes.size());
+                lifetimes.push_back({r, slot, slot});
+            } else {
+                lifetimes[lifetimeOf[r]].last = slot;
+            }
+        };
+
+        for (size_t slot = 0; slot < m_scheduleNodes.size(); ++slot) {
+            const auto& node = m_passes[m_scheduleNodes[slot]];
+            touch(node.output, slot);
+            for (Resource in : node.inputs) touch(in, slot);
+        }
+        // Slots are visited in order, so lifetimes are already sorted by first use
+
+        for (const auto& life : lifetimes) {
+            auto& res = m_resources[life.resource];
+
+            PooledTarget* found = nullptr;
+            for (auto& pooled : m_pool) {
+                if (pooled.busyUntil <= life.first && pooled.target->desc() == res.desc) {
+                    found = &pooled;
+                    break;
+                }
+            }
+
+            if (!found) {
+                PooledTarget pooled;
+                pooled.target = std::make_unique<RenderTarget>(res.desc);
+                m_pool.push_back(std::move(pooled));
+                found = &m_pool.back();
+            }
+
+            found->busyUntil = life.last + 1;
+            found->usedThisFrame = true;
+            found->unusedFrames = 0;
+            res.physical = found->target.get();
+        }
+
+        // Free targets no frame has wanted for a while
+        for (auto it = m_pool.begin(); it != m_pool.end(); ) {
+            if (!it->usedThisFrame && ++it->unusedFrames > keepUnusedFrames) {
+                it->target->destroy();
+                it = m_pool.erase(it);
+            } else {
+                ++it;
+            }
+        }
+
+        m_stats.transientTargets = lifetimes.size();
+        for (const auto& pooled : m_pool) {
+            if (pooled.usedThisFrame) ++m_stats.physicalTargets;
+        }
+
+        const RenderTarget* last = nullptr;
+        for (uint32_t idx : m_scheduleNodes) {
+            const RenderTarget* target = m_resources[m_passes[idx].output].physical;
+            if (last != nullptr && target != last) ++m_stats.framebufferSwitches;
+            last = target;
+        }
+    }
+
+    void RenderGraph::execute(Renderer& renderer) {
+        for (uint32_t idx : m_scheduleNodes) {
+            auto& node = m_passes[idx];
+            node.pass->renderTarget = m_resources[node.output].physical;
+            renderer.submit(node.pass);
+        }
+
+        // Nothing reads what culled passes would draw, so don't let their commands pile up
+        for (auto& node : m_passes) {
+            if (!node.alive) node.pass->clearCommands();
+        }
+    }
+
+    RenderTarget* RenderGraph::getTarget(Resource resource) const {
+        if (resource >= m_resources.size()) return nullptr;
+        return m_resources[resource].physical;
+    }
+
+    Core::Texture* RenderGraph::getTexture(Resource resource) const {
+        RenderTarget* target = getTarget(resource);
+        return target ? target->colourTexture() : nullptr;
+    }
+
+    void RenderGraph::reset() {
+        m_resources.clear();
+        m_passes.clear();
+        m_schedule.clear();
+        m_scheduleNodes.clear();
+    }
+
+    void RenderGraph::destroy() {
+        for (auto& pooled : m_pool) pooled.target->destroy();
+        m_pool.clear();
+        reset();
+    }
+}
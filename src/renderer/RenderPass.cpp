@@ -4,6 +4,7 @@
 
 #include <renderer/RenderPass.hpp>
 #include <renderer/Command.hpp>
+#include <renderer/SortKey.hpp>
 
 #include <core/Material.hpp>
 #include <core/Mesh.hpp>
@@ -12,7 +13,69 @@
 
 #include <core/Error.hpp>
 
+#include <atomic>
+#include <unordered_map>
+
 namespace Dexium::Renderer {
+
+    namespace {
+        // Checks a command is safe to draw. Shared by the single threaded path & the Recorders
+        // quiet skips the logging: the Logger isn't thread safe, so Recorders count their rejects for mergeRecorded() instead
+        bool validateCommand(Core::Mesh* mesh, Core::Material* material, Core::Transform* transform, bool quiet = false) {
+            //Validate cmd
+            if (mesh == nullptr) {
+                if (!quiet) TraceLog(LogLevel::DEBUG, "[RenderCommand]: Mesh ptr is invalid. Cannot store command");
+                return false;
+            }
+            if (material == nullptr) {
+                if (!quiet) TraceLog(LogLevel::DEBUG, "[RenderCommand]: Material ptr is invalid. Cannot store command");
+                return false;
+            }
+            if (transform == nullptr) {
+                if (!quiet) TraceLog(LogLevel::DEBUG, "[RenderCommand]: Transform ptr is invalid. Cannot store command");
+                return false;
+            }
+
+            // Validate Mesh internals:
+            if (mesh->VAO < 0 || mesh->VBO < 0 || (mesh->indexCount > 0 && mesh->EBO < 0)) {
+                if (!quiet) TraceLog(LogLevel::WARNING, "[RenderCommand]: Mesh data appears out-of-range. It may NOT render correctly or at all.");
+            }
+
+            // Ensure Material points to a valid shader program
+            if (material->shader != nullptr) {
+                // Ensure shader is compiled (or on its way, Renderer::flush() finishes those)
+                // Const, so it never polls GL: this also runs on the worker threads recording through a Recorder
+                const auto& shader = static_cast<const Core::Shader&>(*material->shader);
+                if (!shader.isCompiled() && !shader.isPending()) {
+                    if (!quiet) TraceLog(LogLevel::DEBUG, "[RenderCommand]: THe associated shader to this commands material hasn't been compiled!");
+                    return false;
+                }
+
+                // Ensure shader has a valid ID
+                if (material->shader->ID < 1) {
+                    if (!quiet) TraceLog(LogLevel::DEBUG, "[RenderCommand]: The materials associated shader ID({}) is invalid", material->shader->ID);
+                    return false;
+                }
+            } else {
+                // Catch shader nullptr
+                return false;
+            }
+
+            return true;
+        }
+
+        std::atomic<uint64_t> s_nextPassID{1};
+
+        // The last pass this thread recorded into, so repeated recorder() calls skip the map lookup
+        struct ThreadChunkCache {
+            uint64_t lastID = 0;
+            std::vector<Command>* lastChunk = nullptr;
+            std::unordered_map<uint64_t, std::vector<Command>*> chunks;
+        };
+        thread_local ThreadChunkCache t_chunkCache;
+    }
+
+    RenderPass::ThreadChunks::ThreadChunks() : id(s_nextPassID.fetch_add(1, std::memory_order_relaxed)) {}
     RenderPass::RenderPass(RenderTarget* renderTarget, Core::baseCamera* camera)
         : renderTarget(renderTarget), camera(camera) {}
 
@@ -20,10 +83,66 @@ namespace Dexium::Renderer {
         storeCommand(cmd.mesh, cmd.material, cmd.transform);
     }
 
+    void RenderPass::storeBatch(Core::SpriteBatch* batch) {
+        if (batch == nullptr) {
+            TraceLog(LogLevel::DEBUG, "[RenderCommand]: SpriteBatch ptr is invalid. Cannot store batch");
+            return;
+        }
+        m_batches.push_back(batch);
+    }
+
+    namespace {
+        AABB worldBounds(const Core::Mesh& mesh, Core::Transform& transform) {
+            if (!mesh.hasBounds) {
+                // Nothing to go off, so it'll land in (and be drawn from) every cell the grid has
+                constexpr float big = 1e30f;
+                return {glm::vec3(-big), glm::vec3(big)};
+            }
+            return transformBounds(mesh.boundsMin, mesh.boundsMax, transform.ModelMatrix());
+        }
+    }
+
+    void RenderPass::enableStaticGrid(float cellSize) {
+        if (m_staticGrid && m_staticGrid->size() > 0) {
+            TraceLog(LogLevel::WARNING, "[RenderPass]: Static grid already holds {} commands, cannot change its cell size", m_staticGrid->size());
+            return;
+        }
+        m_staticGrid = std::make_unique<UniformGrid>(cellSize);
+    }
+
+    UniformGrid::Handle RenderPass::storeStatic(Core::Mesh* mesh, Core::Material* material, Core::Transform* transform) {
+        if (!validateCommand(mesh, material, transform)) return UniformGrid::InvalidHandle;
+
+        if (!m_staticGrid) enableStaticGrid();
+
+        Command cmd(mesh, material, transform, SortKey::build(*mesh, *material, *transform, plpState.sortOrder()));
+        return m_staticGrid->insert(cmd, worldBounds(*mesh, *transform));
+    }
+
+    void RenderPass::updateStatic(UniformGrid::Handle handle) {
+        if (!m_staticGrid) return;
+
+        const Command* cmd = m_staticGrid->get(handle);
+        if (!cmd) return;
+
+        m_staticGrid->update(handle, worldBounds(*cmd->mesh, *cmd->transform),
+                             SortKey::build(*cmd->mesh, *cmd->material, *cmd->transform, plpState.sortOrder()));
+    }
+
+    void RenderPass::removeStatic(UniformGrid::Handle handle) {
+        if (m_staticGrid) m_staticGrid->remove(handle);
+    }
+
     void RenderPass::clearCommands() {
         if (m_commands.size() > 0) {
             m_commands.clear();
         }
+        m_batches.clear();
+
+        if (m_threadChunks) {
+            std::lock_guard<std::mutex> lock(m_threadChunks->mutex);
+            for (auto& chunk : m_threadChunks->chunks) chunk->clear();
+        }
     }
 
     void RenderPass::setClearColor(const Colour color) {
@@ -37,45 +156,92 @@ namespace Dexium::Renderer {
     }
 
     void RenderPass::storeCommand(Core::Mesh* mesh, Core::Material* material, Core::Transform* transform) {
-        //Validate cmd
-        if (mesh == nullptr) {
-            TraceLog(LogLevel::DEBUG, "[RenderCommand]: Mesh ptr is invalid. Cannot store command");
-            return;
-        }
-        if (material == nullptr) {
-            TraceLog(LogLevel::DEBUG, "[RenderCommand]: Material ptr is invalid. Cannot store command");
-            return;
-        }
-        if (transform == nullptr) {
-            TraceLog(LogLevel::DEBUG, "[RenderCommand]: Transform ptr is invalid. Cannot store command");
+        if (!validateCommand(mesh, material, transform)) return;
+
+        // Store command, along with its sort key (so the Renderer never has to chase these ptrs while sorting)
+        m_commands.emplace_back(mesh, material, transform, SortKey::build(*mesh, *material, *transform, plpState.sortOrder()));
+    }
+
+    void RenderPass::storeCommand(Core::SceneGraph& graph, Core::SceneGraph::Node node) {
+        const size_t first = graph.indexOf(node);
+        if (first == SIZE_MAX) {
+            TraceLog(LogLevel::DEBUG, "[RenderCommand]: SceneGraph node ({}) is invalid. Cannot store its subtree", node);
             return;
         }
 
-        // Validate Mesh internals:
-        if (mesh->VAO < 0 || mesh->VBO < 0 || (mesh->indexCount > 0 && mesh->EBO < 0)) {
-            TraceLog(LogLevel::WARNING, "[RenderCommand]: Mesh data appears out-of-range. It may NOT render correctly or at all.");
+        // The subtree is one contiguous range of the graph's arrays
+        const size_t last = first + graph.subtreeSize(node);
+        for (size_t i = first; i < last; ++i) {
+            Core::Mesh* mesh = graph.meshAt(i);
+            Core::Material* material = graph.materialAt(i);
+            if (mesh == nullptr && material == nullptr) continue; // Just a pivot
+
+            Core::Transform* local = &graph.localAt(i);
+            if (!validateCommand(mesh, material, local)) continue;
+
+            // Depth sorts by the world position, not the local one
+            const glm::mat4& world = graph.worldAt(i);
+            auto& cmd = m_commands.emplace_back(mesh, material, local,
+                SortKey::build(material->shader->ID, material->sortID, material->getTextureSetKey(), SortKey::meshID(*mesh), world[3].z,
+                               plpState.sortOrder()));
+            cmd.world = &world;
         }
+    }
 
-        // Ensure Material points to a valid shader program
-        if (material->shader != nullptr) {
-            // Ensure shader is compiled
-            if (material->shader->isCompiled() == false) {
-                TraceLog(LogLevel::DEBUG, "[RenderCommand]: THe associated shader to this commands material hasn't been compiled!");
-                return;
-            }
+    RenderPass::Recorder RenderPass::recorder() {
+        auto& cache = t_chunkCache;
+        const uint64_t id = m_threadChunks->id;
 
-            // Ensure shader has a valid ID
-            if (material->shader->ID < 1) {
-                TraceLog(LogLevel::DEBUG, "[RenderCommand]: The materials associated shader ID({}) is invalid", material->shader->ID);
-                return;
+        if (cache.lastID != id) {
+            auto it = cache.chunks.find(id);
+            if (it == cache.chunks.end()) {
+                // First time this thread records into this pass, register a chunk for it
+                auto chunk = std::make_unique<std::vector<Command>>();
+                std::vector<Command>* raw = chunk.get();
+                {
+                    std::lock_guard<std::mutex> lock(m_threadChunks->mutex);
+                    m_threadChunks->chunks.push_back(std::move(chunk));
+                }
+                it = cache.chunks.emplace(id, raw).first;
             }
-        } else {
-            // Catch shader nullptr
+            cache.lastID = id;
+            cache.lastChunk = it->second;
+        }
+
+        return Recorder(cache.lastChunk, &m_threadChunks->rejected, plpState.sortOrder());
+    }
+
+    void RenderPass::Recorder::storeCommand(Core::Mesh* mesh, Core::Material* material, Core::Transform* transform) {
+        if (!validateCommand(mesh, material, transform, true)) {
+            m_rejected->fetch_add(1, std::memory_order_relaxed);
             return;
         }
 
-        // Store command
-        m_commands.emplace_back(mesh, material, transform);
+        m_chunk->emplace_back(mesh, material, transform, SortKey::build(*mesh, *material, *transform, m_order));
+    }
+
+    void RenderPass::Recorder::storeCommand(const Command& cmd) {
+        storeCommand(cmd.mesh, cmd.material, cmd.transform);
     }
-}
 
+    void RenderPass::mergeRecorded() {
+        if (!m_threadChunks) return; // Moved from
+
+        // Recorders validate quietly (they run on worker threads), so their rejects are reported from here
+        if (const uint64_t rejected = m_threadChunks->rejected.exchange(0, std::memory_order_relaxed)) {
+            TraceLog(LogLevel::DEBUG, "[RenderCommand]: {} recorded command(s) were invalid & dropped (null mesh/material/transform or an uncompiled shader)", rejected);
+        }
+
+        std::lock_guard<std::mutex> lock(m_threadChunks->mutex);
+
+        size_t total = m_commands.size();
+        for (const auto& chunk : m_threadChunks->chunks) total += chunk->size();
+        if (total == m_commands.size()) return;
+
+        m_commands.reserve(total);
+        for (auto& chunk : m_threadChunks->chunks) {
+            m_commands.insert(m_commands.end(), chunk->begin(), chunk->end());
+            chunk->clear(); // Keeps its capacity for the next frame
+        }
+    }
+}
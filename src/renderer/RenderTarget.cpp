@@ -0,0 +1,116 @@
+//
+// Created by Dextron12 on 17/10/26.
+//
+
+#include <renderer/RenderTarget.hpp>
+#include <renderer/GLStateCache.hpp>
+
+#include <core/Error.hpp>
+
+namespace Dexium::Renderer {
+
+    namespace {
+        // Any valid format/type pair works when no data is uploaded, but it still has to match the internal format's class
+        void pixelTransferFor(GLenum internalFormat, GLenum& format, GLenum& type) {
+            switch (internalFormat) {
+                case GL_RGBA16F:
+                case GL_RGBA32F:
+                case GL_R11F_G11F_B10F:
+                    format = GL_RGBA; type = GL_FLOAT; break;
+                case GL_RGB8:
+                    format = GL_RGB; type = GL_UNSIGNED_BYTE; break;
+                case GL_R8:
+                    format = GL_RED; type = GL_UNSIGNED_BYTE; break;
+                default:
+                    format = GL_RGBA; type = GL_UNSIGNED_BYTE; break;
+            }
+        }
+    }
+
+    RenderTarget::RenderTarget(const TargetDesc& desc)
+        : m_viewport(0, 0, desc.width, desc.height), m_desc(desc) {
+        createAttachments();
+    }
+
+    void RenderTarget::createAttachments() {
+        if (m_desc.width <= 0 || m_desc.height <= 0) {
+            TraceLog(LogLevel::ERROR, "[RenderTarget]: Cannot create an offscreen target of size {}x{}", m_desc.width, m_desc.height);
+            return;
+        }
+
+        auto& gl = GLStateCache::get();
+
+        glGenFramebuffers(1, &m_fbo);
+        gl.bindFramebuffer(m_fbo);
+
+        if (m_desc.colour) {
+            GLenum format, type;
+            pixelTransferFor(m_desc.colourFormat, format, type);
+
+            glGenTextures(1, &m_colour.texID);
+            gl.bindTexture(GL_TEXTURE_2D, m_colour.texID);
+            glTexImage2D(GL_TEXTURE_2D, 0, static_cast<GLint>(m_desc.colourFormat), m_desc.width, m_desc.height, 0, format, type, nullptr);
+
+            m_colour.width = m_desc.width;
+            m_colour.height = m_desc.height;
+            m_colour.nrChannels = 4;
+            m_colour.flags = Utils::TexFlags::Linear | Utils::TexFlags::ClampEdge;
+            m_colour.uploadParameters();
+
+            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_colour.texID, 0);
+        } else {
+            // Depth only
+            glDrawBuffer(GL_NONE);
+            glReadBuffer(GL_NONE);
+        }
+
+        if (m_desc.depth) {
+            glGenRenderbuffers(1, &m_depthRBO);
+            glBindRenderbuffer(GL_RENDERBUFFER, m_depthRBO);
+            glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, m_desc.width, m_desc.height);
+            glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+            glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, m_depthRBO);
+        }
+
+        GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+        if (status != GL_FRAMEBUFFER_COMPLETE) {
+            TraceLog(LogLevel::ERROR, "[RenderTarget]: Framebuffer({}) is incomplete (status: {:#x})", m_fbo, status);
+        }
+
+        gl.bindFramebuffer(0);
+    }
+
+    void RenderTarget::destroy() {
+        auto& gl = GLStateCache::get();
+
+        if (m_colour.texID != 0) {
+            glDeleteTextures(1, &m_colour.texID);
+            gl.forgetTexture(m_colour.texID);
+            m_colour.texID = 0;
+        }
+        if (m_depthRBO != 0) {
+            glDeleteRenderbuffers(1, &m_depthRBO);
+            m_depthRBO = 0;
+        }
+        if (m_fbo != 0) {
+            glDeleteFramebuffers(1, &m_fbo);
+            gl.forgetFramebuffer(m_fbo);
+            m_fbo = 0;
+        }
+    }
+
+    void RenderTarget::resize(int width, int height) {
+        if (!isOffscreen()) {
+            TraceLog(LogLevel::WARNING, "[RenderTarget]: Only offscreen targets can be resized, the window owns the default one");
+            return;
+        }
+        if (width == m_desc.width && height == m_desc.height) return;
+
+        destroy();
+        m_desc.width = width;
+        m_desc.height = height;
+        m_viewport = Viewport(0, 0, width, height);
+        createAttachments();
+    }
+}
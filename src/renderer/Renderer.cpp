@@ -7,10 +7,13 @@
 #include <renderer/RenderTarget.hpp>
 #include <renderer/viewport.hpp>
 #include <renderer/Renderer.hpp>
+#include <renderer/GLStateCache.hpp>
+#include <renderer/UniformBlocks.hpp>
 
 #include <core/Mesh.hpp>
 #include <core/Material.hpp>
 #include <core/Transform.h>
+#include <core/SpriteBatch.hpp>
 
 #include <core/Error.hpp>
 
@@ -19,21 +22,30 @@
 
 namespace Dexium::Renderer {
 
+    namespace {
+        // Byte offset of the mesh's first index in its EBO, as the pointer glDrawElements* wants
+        const void* indexOffset(const Core::Mesh& mesh) {
+            return reinterpret_cast<const void*>(static_cast<uintptr_t>(mesh.firstIndex) * mesh.indexSize());
+        }
+    }
+
     Renderer::Renderer() {
         // Poll GL for max supported textures for active device
         m_maxTextureSlots = 0;
         glGetIntegerv(GL_MAX_TEXTURE_IMAGE_UNITS, &m_maxTextureSlots); // I believe this polls how many active texture slots can be used within the FRAGMENT shader
 
-        // Resize the cached texture array to support max slots
-        m_boundTextures.resize(m_maxTextureSlots, nullptr);
-        // Should really be using reserve instead to avoid dummy values. Just check in the flush() that we dont' exceed this alloc when emplacing
-        // Actually, resize() creates the values to max slots allowing us to iterate through it m(which is exactly what we do when binding textures to slots), so by using reserve or not populating the vec to maxSize we break slot iterations (Will lead to UB... I've spent too long tracking down a segfault becasue fo this!!)
+        // What is bound to each slot is tracked by the GLStateCache now, so no per-slot array is needed here
     }
 
     int Renderer::pollHW_MaxTexSlots() const {
         return m_maxTextureSlots;
     }
 
+    void Renderer::destroy() {
+        m_instances.destroy();
+        m_indirect.destroy();
+    }
+
     void Renderer::submit(RenderPass* pass) {
         // Validate the pass state data. No Need to validate any command data, this is done within the pass submission
         // SO we should assume any stored commands are safe to operate on.
@@ -63,56 +75,59 @@ namespace Dexium::Renderer {
 
     void Renderer::flush() {
 
+        m_profiler.beginFrame();
+
         // Iterate through the stored passes
 
         // Should only be reading the pass data, so a iterate for-auto loop will guarantee this
         for (const auto& pass : m_renderPasses) {
+            auto& gl = GLStateCache::get();
+
+            // Pull in anything worker threads recorded, their keys were built at record time
+            pass->mergeRecorded();
+
+            m_profiler.beginPass(pass->passName, pass->m_commands.size());
+
+            // Draw into the pass's target (0 is the window's default framebuffer)
+            gl.bindFramebuffer(pass->renderTarget->fbo());
+
             // Internal buffer
             GLenum scrBuffers = 0; // Causes UB if not defined
 
             // Clear screen if enabled
             if (Utils::hasFlag(pass->plpState.buffers, Utils::BufferTarget::Color)) {
                 const auto& col = pass->plpState.passColor;
-                glClearColor(col.r(), col.g(), col.b(), col.a());
+                gl.setClearColour(col.r(), col.g(), col.b(), col.a());
 
                 scrBuffers |= GL_COLOR_BUFFER_BIT;
             }
             if (Utils::hasFlag(pass->plpState.buffers, Utils::BufferTarget::Depth)) {
                 // Depth enabled
-                glEnable(GL_DEPTH_TEST);
-                glDepthFunc(pass->plpState.depthFunc);
+                gl.setCapability(GL_DEPTH_TEST, true);
+                gl.setDepthFunc(pass->plpState.depthFunc);
 
                 //Check for depth-writing:
-                if (pass->plpState.DepthWrite) {
-                    glDepthMask(GL_TRUE);
-                } else {
-                    glDepthMask(GL_FALSE);
-                }
+                gl.setDepthMask(pass->plpState.DepthWrite);
 
                 //Clear depth buffer
                 scrBuffers |= GL_DEPTH_BUFFER_BIT;
             } else {
-                glDisable(GL_DEPTH_TEST);
+                gl.setCapability(GL_DEPTH_TEST, false);
             }
 
             if (pass->plpState.blending) {
-                glEnable(GL_BLEND);
-                glBlendFunc(pass->plpState.blendMode.src, pass->plpState.blendMode.dst);
+                gl.setCapability(GL_BLEND, true);
+                gl.setBlendFunc(pass->plpState.blendMode.src, pass->plpState.blendMode.dst);
             } else {
-                glDisable(GL_BLEND);
+                gl.setCapability(GL_BLEND, false);
             }
 
             // Actually clear the buffers
             glClear(scrBuffers);
 
-            // Update VP to match renderTarget
-            if (pass->renderTarget->m_viewport != m_activeViewport) {
-                m_activeViewport = pass->renderTarget->m_viewport;
-
-                // Update GL viewport
-                const auto& vp = m_activeViewport;
-                glViewport(vp.x, vp.y, vp.w, vp.h);
-            }
+            // Update VP to match renderTarget (The cache skips glViewport if it hasn't changed)
+            const auto& vp = pass->renderTarget->m_viewport;
+            gl.setViewport(vp.x, vp.y, vp.w, vp.h);
 
             // Configure the Camera, Projection & View matrices for pass
             if (pass->camera != m_activeCamera) {
@@ -121,35 +136,72 @@ namespace Dexium::Renderer {
                 // Currently not really needed? Proceeding code always uses pass->camera OR pass->VP
             }
 
+            // Each pass can have its own camera, so the first shader bound in a pass always gets the pass matrices
+            m_activeShader = 0;
+
             // Refs to Proj & View matrices
-            const auto& Projection = pass->camera->getProjectionMatrix(m_activeViewport);
+            const auto& Projection = pass->camera->getProjectionMatrix(vp);
             const auto& View = pass->camera->getViewMatrix();
 
-            // Sort pass commands
-            std::sort(pass->m_commands.begin(), pass->m_commands.end(),
-                [&state = pass->plpState](const Command& a, const Command& b) {
-                    // Sort by shader
-                    if (a.material->shader != b.material->shader)
-                        return a.material->shader < b.material->shader;
-
-                    // Sort by Z buffer if blending enabled
-                    if (state.blending) {
-                        // Sort by Z order (Back to front ordering)
-                        if (a.transform->position.z != b.transform->position.z)
-                            return a.transform->position.z > b.transform->position.z;
-                    }
+            // Write the shared CameraBlock once for the whole pass (skipped if the matrices didn't change)
+            // Every program declaring the block reads it, so there's no per-program upload for those
+            CameraUniformBuffer::get().update(Projection, View);
+
+            // Cull against the box the camera can see. Dynamic commands are tested one by one, static ones come from the grid
+            if (pass->plpState.culling || pass->m_staticGrid) {
+                const AABB viewBounds = computeViewBounds(Projection, View);
+
+                if (pass->plpState.culling) m_culler.cull(pass->m_commands, viewBounds);
+                // Grid results are already exact, so they're appended after the per-command test
+                if (pass->m_staticGrid) pass->m_staticGrid->query(viewBounds, pass->m_commands);
+            }
 
-                    // fallback sort: By material
-                    return a.material < b.material;
-                });
+            // Sort pass commands by their pre-built keys (shader -> material -> textures -> depth, mesh before depth when
+            // instancing/multi-drawing, or depth before material when blending)
+            auto phase = m_profiler.stamp();
+            m_sorter.sort(pass->m_commands);
+            m_profiler.addPhase(FrameProfiler::Phase::Sort, phase);
 
             // clear texture batch lookup
             m_batchLookup.clear();
             m_nextTextureSlot = 1; // 0 is reserved for fallback texture
 
+            // Material uniforms may have changed since the last frame, so always upload them for the first use in a pass
+            m_activeMaterial = nullptr;
+
+            // Multi-draw reads the model matrix like instancing does, so it's an instanced pass either way
+            const bool multiDraw = pass->plpState.multiDraw && IndirectBuffer::baseInstanceSupported();
+            const bool instancing = pass->plpState.instancing || pass->plpState.multiDraw;
+
             // Now iterate over the comms
 
-            for (const auto& cmd : pass->m_commands) {
+            auto& commands = pass->m_commands;
+            for (size_t i = 0; i < commands.size(); ) {
+                const auto& cmd = commands[i];
+
+                // A compileAsync() still in flight is polled (and finished) here on the GL thread, its commands wait until it's done
+                if (cmd.material->shader->isPending() && !cmd.material->shader->isCompiled()) {
+                    ++i;
+                    continue;
+                }
+
+                // When instancing, every command sharing this Mesh & Material (they're adjacent after sorting) is drawn in one call
+                // When multi-drawing, that widens to every indexed command sharing the Material & VAO
+                size_t runEnd = i + 1;
+                const bool multiDrawRun = multiDraw && cmd.mesh->EBO != 0;
+                if (multiDrawRun) {
+                    while (runEnd < commands.size() && commands[runEnd].material == cmd.material) {
+                        const auto* mesh = commands[runEnd].mesh;
+                        if (mesh->VAO != cmd.mesh->VAO || mesh->EBO == 0 || mesh->drawMode != cmd.mesh->drawMode ||
+                            mesh->indexType != cmd.mesh->indexType) break;
+                        ++runEnd;
+                    }
+                } else if (instancing) {
+                    while (runEnd < commands.size() && commands[runEnd].mesh == cmd.mesh && commands[runEnd].material == cmd.material) {
+                        ++runEnd;
+                    }
+                }
+
                 // Check if shader program ahs changed
                 if (cmd.material->shader->ID != m_activeShader) {
                     // Really should use a proper handle here!!
@@ -160,17 +212,26 @@ namespace Dexium::Renderer {
                         // Bind it
                         cmd.material->shader->bind();
 
-                        // Set the View & Projection matrices for this pass
-                        if (!pass->plpState.Projection_uName.empty()) {
-                            cmd.material->shader->setUniform(pass->plpState.Projection_uName.c_str(), Projection);
-                        } else {
-                            TraceLog(LogLevel::WARNING, "[Renderer]: No uniform name for Projection is configured!\nIf it isn't explicitly ste through the material uniform nothing will render!");
+                        // Resolve the model uniform once per program switch, rather than by name every draw
+                        m_modelUniform = {};
+                        if (!instancing && !pass->plpState.Model_uName.empty()) {
+                            m_modelUniform = cmd.material->shader->getUniform<glm::mat4>(pass->plpState.Model_uName);
                         }
 
-                        if (!pass->plpState.View_uName.empty()) {
-                            cmd.material->shader->setUniform(pass->plpState.View_uName.c_str(), View);
-                        } else {
-                            TraceLog(LogLevel::WARNING, "[Renderer]: No uniform name for View is configured!");
+                        // Shaders declaring the CameraBlock already see this pass's matrices through the UBO
+                        if (!cmd.material->shader->usesCameraBlock()) {
+                            // Set the View & Projection matrices for this pass
+                            if (!pass->plpState.Projection_uName.empty()) {
+                                cmd.material->shader->setUniform(pass->plpState.Projection_uName, Projection);
+                            } else {
+                                TraceLog(LogLevel::WARNING, "[Renderer]: No uniform name for Projection is configured!\nIf it isn't explicitly ste through the material uniform nothing will render!");
+                            }
+
+                            if (!pass->plpState.View_uName.empty()) {
+                                cmd.material->shader->setUniform(pass->plpState.View_uName, View);
+                            } else {
+                                TraceLog(LogLevel::WARNING, "[Renderer]: No uniform name for View is configured!");
+                            }
                         }
 
                     } else {
@@ -208,63 +269,129 @@ namespace Dexium::Renderer {
                         m_batchLookup[texture] = slot;
                     }
 
-                    // Bind Texture to slot, if not the active texture
-                    if (m_boundTextures[slot] != texture) {
-                        glActiveTexture(GL_TEXTURE0 + slot);
-                        glBindTexture(GL_TEXTURE_2D, texture->texID);
-
-                        m_boundTextures[slot] = texture;
-                    }
+                    // Bind Texture to slot (elided by the state cache if it's already there)
+                    gl.bindTexture(slot, texture->target, texture->texID);
 
                     // Set shader sampler uniform to slot
                     cmd.material->shader->setUniform(samplerName, slot); // Use raw shader.setUniform here as its state doesn't persist unlike Material uniform setting does!!
                 }
 
-                // Set Model Matrix (From cmd Transform data)
-                if (!pass->plpState.Model_uName.empty()) {
-                    cmd.material->shader->setUniform(pass->plpState.Model_uName.c_str(), cmd.transform->ModelMatrix());
-                } else {
-                    TraceLog(LogLevel::WARNING, "[Renderer]: No uniform name for Model is configured!");
+                // Set Model Matrix (From cmd Transform data). Instanced draws read it from the instance buffer instead
+                if (!instancing) {
+                    if (!pass->plpState.Model_uName.empty()) {
+                        cmd.material->shader->setUniform(m_modelUniform, cmd.modelMatrix());
+                    } else {
+                        TraceLog(LogLevel::WARNING, "[Renderer]: No uniform name for Model is configured!");
+                    }
                 }
 
                 // Now set material property uniforms (If, material has changed)
                 if (m_activeMaterial != cmd.material) {
-                    for (const auto& pair : cmd.material->getUniforms()) {
-                        const auto& uniformName = pair.first;
-                        const auto& variant = pair.second;
+                    // Block backed uniforms are one buffer bind (re-uploaded only when the material changed them)
+                    cmd.material->applyBlock();
 
+                    // Anything the shader's MaterialBlock doesn't hold is still set by name
+                    for (const auto& loose : cmd.material->getLooseUniforms()) {
                         // Visit the raw varient value:
-                        std::visit([shader = cmd.material->shader, name = uniformName](auto&& value) {
-                            shader->setUniform(name, value);
-                        }, variant);
+                        std::visit([shader = cmd.material->shader, &loose](auto&& value) {
+                            shader->setUniform(*loose.name, value);
+                        }, *loose.value);
                     }
+                    m_activeMaterial = cmd.material;
                 }
 
+                m_profiler.addPhase(FrameProfiler::Phase::Bind, phase);
+
                 // Begin drawing
 
-                // Bind Mesh VAO
-                glBindVertexArray(cmd.mesh->VAO);
+                if (multiDrawRun) {
+                    // One indirect command per distinct mesh in a row, its instances are the matching slice of the matrices
+                    m_instanceData.clear();
+                    m_indirectData.clear();
+                    for (size_t c = i; c < runEnd; ++c) {
+                        const auto* mesh = commands[c].mesh;
+                        if (c > i && mesh == commands[c - 1].mesh) {
+                            ++m_indirectData.back().instanceCount;
+                        } else {
+                            m_indirectData.push_back({static_cast<GLuint>(mesh->indexCount), 1, mesh->firstIndex, mesh->baseVertex,
+                                                      static_cast<GLuint>(m_instanceData.size())});
+                        }
+                        m_instanceData.push_back(commands[c].modelMatrix());
+                    }
+                    m_instances.upload(m_instanceData.data(), m_instanceData.size());
 
-                // THe mystical drawing sauce that took me ~2.5kLOC to get something drawn...
+                    // Binds the shared VAO (and hooks the instance attribs into it the first time it's seen)
+                    m_instances.attach(cmd.mesh->VAO, pass->plpState.instanceAttrib);
 
-                if (cmd.mesh->EBO != 0) {
-                    // using indices for drawing
-                    glDrawElements(cmd.mesh->drawMode, cmd.mesh->indexCount, GL_UNSIGNED_INT, 0);
+                    m_indirect.draw(cmd.mesh->drawMode, cmd.mesh->indexType, m_indirectData);
+                } else if (instancing) {
+                    // Gather the runs model matrices and draw them all at once
+                    const auto instanceCount = static_cast<GLsizei>(runEnd - i);
+
+                    m_instanceData.clear();
+                    for (size_t c = i; c < runEnd; ++c) {
+                        m_instanceData.push_back(commands[c].modelMatrix());
+                    }
+                    m_instances.upload(m_instanceData.data(), m_instanceData.size());
+
+                    // Binds the mesh VAO (and hooks the instance attribs into it the first time it's seen)
+                    m_instances.attach(cmd.mesh->VAO, pass->plpState.instanceAttrib);
+
+                    if (cmd.mesh->EBO != 0) {
+                        glDrawElementsInstancedBaseVertex(cmd.mesh->drawMode, cmd.mesh->indexCount, cmd.mesh->indexType,
+                            indexOffset(*cmd.mesh), instanceCount, cmd.mesh->baseVertex);
+                    } else {
+                        glDrawArraysInstanced(cmd.mesh->drawMode, cmd.mesh->baseVertex, cmd.mesh->vertexCount, instanceCount);
+                    }
                 } else {
-                    // Vertex drawing mode
-                    glDrawArrays(cmd.mesh->drawMode, 0, cmd.mesh->vertexCount);
+                    // Bind Mesh VAO
+                    gl.bindVertexArray(cmd.mesh->VAO);
+
+                    // THe mystical drawing sauce that took me ~2.5kLOC to get something drawn...
+
+                    if (cmd.mesh->EBO != 0) {
+                        // using indices for drawing (Base vertex & offset are 0 unless the mesh lives in a GeometryArena)
+                        glDrawElementsBaseVertex(cmd.mesh->drawMode, cmd.mesh->indexCount, cmd.mesh->indexType,
+                            indexOffset(*cmd.mesh), cmd.mesh->baseVertex);
+                    } else {
+                        // Vertex drawing mode
+                        glDrawArrays(cmd.mesh->drawMode, cmd.mesh->baseVertex, cmd.mesh->vertexCount);
+                    }
+                }
+
+                m_profiler.countDraw();
+                m_profiler.addPhase(FrameProfiler::Phase::Draw, phase);
+
+                i = runEnd;
+            }
+
+            // Stream any sprite batches after the regular commands
+            if (!pass->m_batches.empty()) {
+                for (auto* batch : pass->m_batches) {
+                    batch->render(Projection, View);
                 }
+
+                // Batches bind their own program & VAO, so our cached state is stale now
+                m_activeShader = 0;
+                m_activeMaterial = nullptr;
+
+                m_profiler.addPhase(FrameProfiler::Phase::Draw, phase);
             }
 
+            m_profiler.endPass();
+
             // Force clear the commands from each pass (to rpevent stale state)
             pass->clearCommands();
         }
 
-        glDisable(GL_BLEND);
+        GLStateCache::get().setCapability(GL_BLEND, false);
+        GLStateCache::get().bindFramebuffer(0); // Leave the window bound for anything drawn after the renderer
 
         // Clear stored passes
         m_renderPasses.clear(); // Avoids stale states
 
+        m_profiler.endFrame();
+
 
 
     }
@@ -0,0 +1,154 @@
+//
+// Created by Dextron12 on 17/10/26.
+//
+
+#include <renderer/SortKey.hpp>
+
+#include <core/Material.hpp>
+#include <core/Mesh.hpp>
+#include <core/Transform.h>
+
+#include <algorithm>
+#include <array>
+#include <thread>
+
+namespace Dexium::Renderer::SortKey {
+
+    uint32_t meshID(const Core::Mesh& mesh) {
+        return static_cast<uint32_t>(((mesh.VAO & mask(MeshVAOBits)) << MeshIDBits) | (mesh.sortID & mask(MeshIDBits)));
+    }
+
+    uint64_t build(const Core::Mesh& mesh, const Core::Material& material, const Core::Transform& transform, Order order) {
+        return build(material.shader->ID, material.sortID, material.getTextureSetKey(), meshID(mesh), transform.position.z, order);
+    }
+}
+
+namespace Dexium::Renderer {
+
+    void CommandSorter::radixSort(KeyIndex* data, KeyIndex* scratch, size_t count) {
+        constexpr int Passes = 8; // 8 bits per digit, 64-bit keys
+        std::array<std::array<uint32_t, 256>, Passes> histograms{};
+
+        // Build every digit histogram in a single read of the keys
+        for (size_t i = 0; i < count; ++i) {
+            uint64_t key = data[i].key;
+            for (int p = 0; p < Passes; ++p) {
+                histograms[p][(key >> (p * 8)) & 0xFF]++;
+            }
+        }
+
+        KeyIndex* src = data;
+        KeyIndex* dst = scratch;
+
+        for (int p = 0; p < Passes; ++p) {
+            auto& hist = histograms[p];
+
+            // Skip digits that are identical across all keys (common for the shader bits), the pass wouldn't move anything
+            if (hist[(src[0].key >> (p * 8)) & 0xFF] == count) continue;
+
+            // Exclusive prefix sum -> bucket offsets
+            uint32_t offset = 0;
+            for (auto& bucket : hist) {
+                uint32_t c = bucket;
+                bucket = offset;
+                offset += c;
+            }
+
+            for (size_t i = 0; i < count; ++i) {
+                const auto& k = src[i];
+                dst[hist[(k.key >> (p * 8)) & 0xFF]++] = k;
+            }
+
+            std::swap(src, dst);
+        }
+
+        // An odd number of executed passes leaves the result in scratch
+        if (src != data) {
+            std::copy(src, src + count, data);
+        }
+    }
+
+    void CommandSorter::sort(std::vector<Command>& commands) {
+        const size_t count = commands.size();
+        if (count < 2) return;
+
+        m_keys.resize(count);
+        m_keyScratch.resize(count);
+
+        for (size_t i = 0; i < count; ++i) {
+            m_keys[i] = {commands[i].sortKey, static_cast<uint32_t>(i)};
+        }
+
+        unsigned threads = 1;
+        if (parallelThreshold != 0 && count >= parallelThreshold) {
+            threads = maxThreads != 0 ? maxThreads : std::max(1u, std::thread::hardware_concurrency());
+            // Don't bother splitting into chunks smaller than half the threshold
+            threads = static_cast<unsigned>(std::min<size_t>(threads, std::max<size_t>(1, count / std::max<size_t>(1, parallelThreshold / 2))));
+        }
+
+        if (threads <= 1) {
+            radixSort(m_keys.data(), m_keyScratch.data(), count);
+        } else {
+            // Each thread radix sorts its own chunk
+            std::vector<size_t> bounds(threads + 1);
+            for (unsigned t = 0; t <= threads; ++t) {
+                bounds[t] = count * t / threads;
+            }
+
+            std::vector<std::thread> workers;
+            workers.reserve(threads - 1);
+            for (unsigned t = 1; t < threads; ++t) {
+                workers.emplace_back([this, &bounds, t] {
+                    radixSort(m_keys.data() + bounds[t], m_keyScratch.data() + bounds[t], bounds[t + 1] - bounds[t]);
+                });
+            }
+            radixSort(m_keys.data(), m_keyScratch.data(), bounds[1]);
+            for (auto& w : workers) w.join();
+            workers.clear();
+
+            // Then the sorted chunks are merged pairwise (in parallel) until only one run is left
+            // std::merge prefers the left range on ties, so the sort stays stable
+            auto compare = [](const KeyIndex& a, const KeyIndex& b) { return a.key < b.key; };
+            KeyIndex* src = m_keys.data();
+            KeyIndex* dst = m_keyScratch.data();
+
+            while (bounds.size() > 2) {
+                std::vector<size_t> merged;
+                merged.reserve(bounds.size() / 2 + 1);
+
+                for (size_t r = 0; r + 1 < bounds.size(); r += 2) {
+                    merged.push_back(bounds[r]);
+                    if (r + 2 < bounds.size()) {
+                        size_t lo = bounds[r], mid = bounds[r + 1], hi = bounds[r + 2];
+                        workers.emplace_back([=] {
+                            std::merge(src + lo, src + mid, src + mid, src + hi, dst + lo, compare);
+                        });
+                    } else {
+                        // Odd run out, carry it across untouched
+                        size_t lo = bounds[r], hi = bounds[r + 1];
+                        std::copy(src + lo, src + hi, dst + lo);
+                    }
+                }
+                merged.push_back(count);
+
+                for (auto& w : workers) w.join();
+                workers.clear();
+
+                std::swap(src, dst);
+                bounds = std::move(merged);
+            }
+
+            if (src != m_keys.data()) {
+                std::copy(src, src + count, m_keys.data());
+            }
+        }
+
+        // Gather commands into their sorted order
+        m_cmdScratch.clear();
+        m_cmdScratch.reserve(count);
+        for (const auto& k : m_keys) {
+            m_cmdScratch.push_back(commands[k.index]);
+        }
+        commands.swap(m_cmdScratch);
+    }
+}
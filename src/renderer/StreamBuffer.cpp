@@ -0,0 +1,149 @@
+//
+// Created by Dextron12 on 17/10/26.
+//
+
+#include <renderer/StreamBuffer.hpp>
+#include <renderer/GLStateCache.hpp>
+
+#include <core/Error.hpp>
+
+namespace Dexium::Renderer {
+
+    StreamBuffer::StreamBuffer(StreamBuffer&& other) noexcept
+        : m_buffer(other.m_buffer), m_target(other.m_target), m_regionSize(other.m_regionSize), m_region(other.m_region),
+          m_mapped(other.m_mapped), m_fences(other.m_fences), m_staging(std::move(other.m_staging)) {
+        other.m_buffer = 0;
+        other.m_regionSize = 0;
+        other.m_region = RegionCount - 1;
+        other.m_mapped = nullptr;
+        other.m_fences = {};
+    }
+
+    StreamBuffer& StreamBuffer::operator=(StreamBuffer&& other) noexcept {
+        if (this != &other) {
+            destroy();
+            m_buffer = other.m_buffer;
+            m_target = other.m_target;
+            m_regionSize = other.m_regionSize;
+            m_region = other.m_region;
+            m_mapped = other.m_mapped;
+            m_fences = other.m_fences;
+            m_staging = std::move(other.m_staging);
+
+            other.m_buffer = 0;
+            other.m_regionSize = 0;
+            other.m_region = RegionCount - 1;
+            other.m_mapped = nullptr;
+            other.m_fences = {};
+        }
+        return *this;
+    }
+
+    void StreamBuffer::create(GLenum target, size_t regionSize, bool forceOrphaning) {
+        if (m_buffer != 0) {
+            TraceLog(LogLevel::WARNING, "[StreamBuffer]: Buffer({}) has already been created", m_buffer);
+            return;
+        }
+
+        m_target = target;
+        m_regionSize = regionSize;
+
+        auto& gl = GLStateCache::get();
+
+        glGenBuffers(1, &m_buffer);
+        gl.bindBuffer(m_target, m_buffer);
+
+        // glBufferStorage & persistent mapping are core in 4.4
+        if (!forceOrphaning && GLAD_GL_VERSION_4_4) {
+            const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+            glBufferStorage(m_target, m_regionSize * RegionCount, nullptr, flags);
+            m_mapped = static_cast<unsigned char*>(glMapBufferRange(m_target, 0, m_regionSize * RegionCount, flags));
+
+            if (!m_mapped) {
+                // Storage is immutable now, so we need a fresh buffer for the fallback
+                TraceLog(LogLevel::WARNING, "[StreamBuffer]: Persistent mapping failed, falling back to buffer orphaning");
+                gl.bindBuffer(m_target, 0);
+                glDeleteBuffers(1, &m_buffer);
+                gl.forgetBuffer(m_buffer);
+                glGenBuffers(1, &m_buffer);
+                gl.bindBuffer(m_target, m_buffer);
+            }
+        }
+
+        if (!m_mapped) {
+            glBufferData(m_target, m_regionSize, nullptr, GL_STREAM_DRAW);
+            m_staging.resize(m_regionSize);
+        }
+
+        gl.bindBuffer(m_target, 0);
+    }
+
+    void* StreamBuffer::beginRegion() {
+        m_region = (m_region + 1) % RegionCount;
+
+        if (!m_mapped) return m_staging.data();
+
+        // Wait until the GPU has finished with whatever was last drawn from this region
+        GLsync& sync = m_fences[m_region];
+        if (sync) {
+            GLenum result = glClientWaitSync(sync, 0, 0);
+            if (result == GL_TIMEOUT_EXPIRED) {
+                // Actually stalled, flush so the fence can signal & then block on it
+                do {
+                    result = glClientWaitSync(sync, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000); // 1ms slices
+                } while (result == GL_TIMEOUT_EXPIRED);
+            }
+            glDeleteSync(sync);
+            sync = nullptr;
+        }
+
+        return m_mapped + regionOffset();
+    }
+
+    void StreamBuffer::endRegion(size_t bytesWritten) {
+        if (m_mapped) return; // Coherent mapping, writes are already visible
+
+        auto& gl = GLStateCache::get();
+        gl.bindBuffer(m_target, m_buffer);
+        glBufferData(m_target, m_regionSize, nullptr, GL_STREAM_DRAW); // Orphan
+        glBufferSubData(m_target, 0, bytesWritten, m_staging.data());
+        gl.bindBuffer(m_target, 0);
+    }
+
+    void StreamBuffer::fence() {
+        if (!m_mapped) return;
+
+        GLsync& sync = m_fences[m_region];
+        if (sync) glDeleteSync(sync);
+        sync = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+
+    void StreamBuffer::destroy() {
+        for (GLsync& sync : m_fences) {
+            if (sync) glDeleteSync(sync);
+            sync = nullptr;
+        }
+
+        if (m_buffer != 0) {
+            auto& gl = GLStateCache::get();
+            if (m_mapped) {
+                gl.bindBuffer(m_target, m_buffer);
+                glUnmapBuffer(m_target);
+                gl.bindBuffer(m_target, 0);
+            }
+            glDeleteBuffers(1, &m_buffer);
+            gl.forgetBuffer(m_buffer);
+        }
+
+        m_buffer = 0;
+        m_regionSize = 0;
+        m_region = RegionCount - 1;
+        m_mapped = nullptr;
+        m_staging.clear();
+        m_staging.shrink_to_fit();
+    }
+
+    size_t StreamBuffer::regionOffset() const {
+        return m_mapped ? m_regionSize * m_region : 0;
+    }
+}
@@ -0,0 +1,37 @@
+//
+// Created by Dextron12 on 17/10/26.
+//
+
+#include <renderer/UniformBlocks.hpp>
+#include <renderer/GLStateCache.hpp>
+
+#include <cstring>
+
+namespace Dexium::Renderer {
+
+    CameraUniformBuffer& CameraUniformBuffer::get() {
+        static CameraUniformBuffer buffer;
+        return buffer;
+    }
+
+    void CameraUniformBuffer::update(const glm::mat4& projection, const glm::mat4& view) {
+        auto& gl = GLStateCache::get();
+
+        if (m_buffer == 0) {
+            glGenBuffers(1, &m_buffer);
+            gl.bindBuffer(GL_UNIFORM_BUFFER, m_buffer);
+            glBufferData(GL_UNIFORM_BUFFER, sizeof(Data), nullptr, GL_DYNAMIC_DRAW);
+        }
+
+        gl.bindBufferBase(GL_UNIFORM_BUFFER, UniformBlocks::Camera.binding, m_buffer);
+
+        Data next{projection, view};
+        if (m_hasData && std::memcmp(&next, &m_data, sizeof(Data)) == 0) return; // Nothing moved
+
+        m_data = next;
+        m_hasData = true;
+
+        gl.bindBuffer(GL_UNIFORM_BUFFER, m_buffer);
+        glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(Data), &m_data);
+    }
+}